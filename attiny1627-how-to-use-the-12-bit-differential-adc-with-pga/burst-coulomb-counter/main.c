@@ -0,0 +1,272 @@
+/*
+    \file   main.c
+
+    \brief  How To Use the 12-Bit Differential ADC in Burst Accumulation Mode
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+
+/*
+ *
+ * How To Use the 12-Bit Differential ADC in Burst Accumulation Mode:
+ * Coulomb Counting with Differential mode and PGA
+ *
+ */
+
+#define F_CPU 3333333ul
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define TIMEBASE_VALUE              ((uint8_t) ceil(F_CPU*0.000001))
+#define ADC_DIFF_MAX_VALUE          (((1 << 12) / 2) - 1)                   /* In differential mode, the max value is 2047 */
+#define ADC_DIFF_MAX_VALUE_16BIT    ((uint32_t) ADC_DIFF_MAX_VALUE << 4)    /* In differential mode, the max value for a 16-bit result is 32752 */
+#define ADC_MAX_VALUE_16BIT         ((uint32_t) ((1 << 12) - 1) << 4)       /* In single-ended mode, the max value for a 16-bit result is 65520 */
+
+/* Defines to easily configure ADC accumulation */
+#define ADC_SAMPNUM_CURRENT ADC_SAMPNUM_ACC256_gc    /* 256 samples take ~5 ms, must fit within the burst period */
+#define ADC_SAMPNUM_VDD     ADC_SAMPNUM_ACC16_gc
+
+/* Defines to easily configure RTC event frequency */
+#define ADC_SAMPLING_FREQ   100     /* Hz */
+#define RTC_CLOCK           32768   /* Hz */
+#define RTC_PERIOD          (RTC_CLOCK / ADC_SAMPLING_FREQ)
+#define BURST_PERIOD_S      ((double)RTC_PERIOD / RTC_CLOCK) /* Exact period between two bursts, RTC.PER is RTC_PERIOD - 1 */
+
+/* VDD is measured after every VDD_INTERVAL current bursts, within the same burst period */
+#define VDD_INTERVAL        100
+
+/* Measurement setup */
+#define PGA_GAIN            16
+#define SHUNT_RESISTANCE    5.0     /* Ohm */
+#define VREF                1.024   /* V */
+
+/* Current per LSB of the 16-bit scaled result */
+#define CURRENT_UA_PER_LSB  (VREF * 1e6 / ADC_DIFF_MAX_VALUE_16BIT / PGA_GAIN / SHUNT_RESISTANCE)
+
+/* Fixed point conversion factors used for integration:
+   Charge in nC per LSB during one burst period, with 24 fractional bits.
+   Energy in nJ per LSB per mV during one burst period, with 32 fractional bits. */
+#define CHARGE_FRAC_BITS    24
+#define ENERGY_FRAC_BITS    32
+#define CHARGE_PER_LSB      ((uint32_t) (CURRENT_UA_PER_LSB * BURST_PERIOD_S * 1e3 * (1UL << CHARGE_FRAC_BITS) + 0.5))
+#define ENERGY_PER_LSB_MV   ((uint32_t) (CURRENT_UA_PER_LSB * BURST_PERIOD_S * 4294967296.0 + 0.5))
+
+typedef struct
+{
+	int64_t charge_nC;          /* Accumulated charge */
+	int64_t energy_nJ;          /* Accumulated energy */
+	int16_t peak_current;       /* Result with the highest magnitude, 16-bit scaled */
+	uint16_t vdd_mV;            /* Last VDD measurement */
+	uint64_t bursts;            /* Number of integrated bursts, does not wrap before the charge */
+} coulomb_registers_t;
+
+typedef enum
+{
+	MEASURE_CURRENT,
+	MEASURE_VDD
+} measurement_t;
+
+static volatile coulomb_registers_t coulomb;
+
+/* Fractional parts of the integrators, only accessed by the ISR */
+static int64_t charge_frac;
+static int64_t energy_frac;
+
+static volatile measurement_t measurement;
+
+/* Volatile variables to improve debug experience */
+static volatile float average_current_uA;
+static volatile float peak_current_uA;
+static volatile float charge_mAh;
+static volatile float energy_mWh;
+
+/******************************************************************************
+EVSYS initialization:
+Channel 0:
+            Event system generator: RTC Overflow
+            Event system user: ADC0
+*******************************************************************************/
+void event_system_init(void)
+{
+	EVSYS.CHANNEL0 = EVSYS_CHANNEL0_RTC_OVF_gc;     /* RTC Overflow ->  Channel 0 */
+	EVSYS.USERADC0START = EVSYS_USER_CHANNEL0_gc;   /* Channel 0    ->  ADC0 Start */
+}
+
+/*********************************************************************************
+RTC initialization
+**********************************************************************************/
+void rtc_init(void)
+{
+	while(RTC.STATUS > 0);  /* Wait for all registers to be synchronized */
+	RTC.CTRLA = RTC_PRESCALER_DIV1_gc | RTC_RTCEN_bm; /* Enable RTC, no prescaler */
+	RTC.CLKSEL = RTC_CLKSEL_INT32K_gc; /* Select 32.768 kHz internal RC oscillator */
+	RTC.PER = RTC_PERIOD - 1; /* The RTC overflows every PER + 1 cycles */
+	while(RTC.STATUS > 0);  /* Wait for all registers to be synchronized */
+}
+
+/**********************************************************************************
+Configure the ADC for a shunt current burst, started by the next RTC event
+**********************************************************************************/
+static void adc_select_current(void)
+{
+	ADC0.CTRLF = ADC_SAMPNUM_CURRENT;
+	ADC0.MUXPOS = ADC_VIA_PGA_gc | ADC_MUXPOS_AIN6_gc; /* ADC channel AIN6 -> PA6 */
+	ADC0.MUXNEG = ADC_VIA_PGA_gc | ADC_MUXNEG_AIN7_gc; /* ADC channel AIN7 -> PA7 */
+	ADC0.COMMAND = ADC_DIFF_bm | ADC_MODE_BURST_SCALING_gc | ADC_START_EVENT_TRIGGER_gc;
+	measurement = MEASURE_CURRENT;
+}
+
+/**********************************************************************************
+Start a VDD/10 burst immediately
+**********************************************************************************/
+static void adc_start_vdd(void)
+{
+	ADC0.CTRLF = ADC_SAMPNUM_VDD;
+	ADC0.MUXPOS = ADC_MUXPOS_VDDDIV10_gc; /* ADC channel VDD/10, not via PGA */
+	ADC0.COMMAND = ADC_MODE_BURST_SCALING_gc | ADC_START_IMMEDIATE_gc;
+	measurement = MEASURE_VDD;
+}
+
+/**********************************************************************************
+ADC initialization
+**********************************************************************************/
+void adc_init()
+{
+	ADC0.CTRLA = ADC_ENABLE_bm;
+	ADC0.CTRLB = ADC_PRESC_DIV2_gc; /* fCLK_ADC = 3.333333/2 MHz */
+	ADC0.CTRLC = ADC_REFSEL_1024MV_gc | (TIMEBASE_VALUE << ADC_TIMEBASE_gp);
+	ADC0.CTRLE = 17; /* (SAMPDUR + 0.5) * fCLK_ADC = 10.5 µs sample duration */
+	ADC0.INTCTRL = ADC_RESRDY_bm; /* Enable Result Ready interrupt */
+
+	/* Enable PGA with 16x gain.
+	Set full bias current for fast sampling. Configure ADCPGASAMPDUR according to data sheet. */
+	ADC0.PGACTRL = ADC_GAIN_16X_gc | ADC_PGABIASSEL_1X_gc | ADC_ADCPGASAMPDUR_6CLK_gc | ADC_PGAEN_bm;
+
+	/* Measure VDD first, the current bursts follow on the RTC events */
+	adc_start_vdd();
+}
+
+/***********************************************************************************
+Result Ready interrupt:
+Every current burst is integrated over the burst period. Only additions and
+multiplications are used, and the fractional parts are kept in separate
+accumulators, so no charge is lost to rounding. The whole part is moved to the
+64-bit registers, which do not overflow within the lifetime of the device.
+
+Every VDD_INTERVAL bursts, VDD is measured right after the current burst. This
+conversion is finished long before the next RTC event, so no current burst is
+skipped.
+***********************************************************************************/
+ISR(ADC0_RESRDY_vect)
+{
+	static uint8_t vdd_countdown;
+	int32_t result = ADC0.RESULT; /* Read 16 bit scaled result, clears the interrupt flag */
+
+	if(measurement == MEASURE_VDD)
+	{
+		/* VDD/10 with VREF = 1.024V, 16-bit resolution */
+		coulomb.vdd_mV = ((uint32_t) result * 10240 + ADC_MAX_VALUE_16BIT / 2) / ADC_MAX_VALUE_16BIT;
+		adc_select_current();
+		return;
+	}
+
+	int16_t current = (int16_t) result;
+
+	charge_frac += (int64_t) current * CHARGE_PER_LSB;
+	energy_frac += (int64_t) ((int32_t) current * coulomb.vdd_mV) * ENERGY_PER_LSB_MV;
+
+	/* Move the whole nC and nJ to the registers. The arithmetic shift rounds towards
+	   minus infinity, so the fractional part left behind is always positive. */
+	coulomb.charge_nC += charge_frac >> CHARGE_FRAC_BITS;
+	charge_frac &= ((int64_t) 1 << CHARGE_FRAC_BITS) - 1;
+
+	coulomb.energy_nJ += energy_frac >> ENERGY_FRAC_BITS;
+	energy_frac &= ((int64_t) 1 << ENERGY_FRAC_BITS) - 1;
+
+	if(abs(current) > abs(coulomb.peak_current))
+	{
+		coulomb.peak_current = current;
+	}
+	coulomb.bursts++;
+
+	if(++vdd_countdown >= VDD_INTERVAL)
+	{
+		vdd_countdown = 0;
+		adc_start_vdd();
+	}
+}
+
+/**********************************************************************************
+Take a consistent copy of the coulomb counter registers
+**********************************************************************************/
+void coulomb_read(coulomb_registers_t *registers)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		*registers = coulomb;
+	}
+}
+
+/**********************************************************************************
+Clear the coulomb counter registers
+**********************************************************************************/
+void coulomb_reset(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		coulomb.charge_nC = 0;
+		coulomb.energy_nJ = 0;
+		coulomb.peak_current = 0;
+		coulomb.bursts = 0;
+		charge_frac = 0;
+		energy_frac = 0;
+	}
+}
+
+int main(void)
+{
+	coulomb_registers_t registers;
+
+	event_system_init();
+	rtc_init();
+	adc_init();
+	sei(); /* Enable global interrupts */
+
+	while(1)
+	{
+		coulomb_read(&registers);
+
+		if(registers.bursts > 0)
+		{
+			average_current_uA = (float) registers.charge_nC * 1e-3 / (registers.bursts * BURST_PERIOD_S);
+		}
+		peak_current_uA = registers.peak_current * CURRENT_UA_PER_LSB;
+		charge_mAh = (float) registers.charge_nC / 3.6e6;
+		energy_mWh = (float) registers.energy_nJ / 3.6e6;
+	}
+}
@@ -0,0 +1,251 @@
+/*
+    \file   main.c
+
+    \brief  How To Use the 12-Bit Differential ADC in Burst Accumulation Mode
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+
+/*
+ *
+ * How To Use the 12-Bit Differential ADC in Burst Accumulation Mode:
+ * Interleaved Dual-Channel Measurement
+ *
+ */
+
+#define F_CPU 3333333ul
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <util/delay.h>
+#include <math.h>
+
+#define TIMEBASE_VALUE      ((uint8_t) ceil(F_CPU*0.000001))
+#define ADC_MAX_VALUE       ((1 << 12) - 1)         /* In single-ended mode, the max value is 4095 */
+#define ADC_DIFF_MAX_VALUE  (((1 << 12) / 2) - 1)   /* In differential mode, the max value is 2047 */
+
+/* Defines to easily configure ADC accumulation, shared by both channels */
+#define ADC_SAMPNUM_CONFIG  ADC_SAMPNUM_ACC4_gc
+/* Left shifting (1 << SAMPNUM) results in the number of accumulated samples */
+#define ADC_SAMPLES         (1 << ADC_SAMPNUM_CONFIG)
+
+/* Defines to easily configure RTC event frequency */
+#define PAIR_FREQ           1024    /* Hz, one voltage and one current burst per pair */
+#define RTC_CLOCK           32768   /* Hz */
+#define RTC_PERIOD          (RTC_CLOCK / PAIR_FREQ)
+/* Pair period in TCA0 ticks (CLK_PER), RTC.PER is RTC_PERIOD - 1 */
+#define PAIR_PERIOD_TICKS   ((uint16_t) ((uint32_t) RTC_PERIOD * F_CPU / RTC_CLOCK))
+
+/* Set to 1 to align the current to the time of the voltage measurement */
+#ifndef PAIR_ALIGN
+#define PAIR_ALIGN          1
+#endif
+
+#define SHUNT_RESISTANCE    5.0     /* Ohm */
+#define PGA_GAIN            16
+
+typedef enum
+{
+	CHANNEL_VOLTAGE,    /* VDD/10, single-ended, triggered by the RTC */
+	CHANNEL_CURRENT     /* AIN6 - AIN7 via PGA, started when the voltage burst is done */
+} pair_channel_t;
+
+typedef struct
+{
+	uint16_t voltage_raw;   /* Accumulated VDD/10 result */
+	int16_t current_raw;    /* Accumulated differential result, aligned if PAIR_ALIGN is 1 */
+	uint16_t skew;          /* Ticks from the voltage result to the current result */
+	uint16_t count;         /* Number of pairs since the last read */
+} adc_pair_t;
+
+static volatile adc_pair_t pair;
+
+/* Volatile variables to improve debug experience */
+static volatile float vdd;
+static volatile float current;
+static volatile float power;
+static volatile float skew_us;
+static volatile uint16_t pair_rate;   /* Pairs per second */
+
+/******************************************************************************
+EVSYS initialization:
+Channel 0:
+            Event system generator: RTC Overflow
+            Event system user: ADC0
+*******************************************************************************/
+void event_system_init(void)
+{
+	EVSYS.CHANNEL0 = EVSYS_CHANNEL0_RTC_OVF_gc;     /* RTC Overflow ->  Channel 0 */
+	EVSYS.USERADC0START = EVSYS_USER_CHANNEL0_gc;   /* Channel 0    ->  ADC0 Start */
+}
+
+/*********************************************************************************
+RTC initialization: overflow triggers a pair, PIT interrupt once per second
+**********************************************************************************/
+void rtc_init(void)
+{
+	while(RTC.STATUS > 0);  /* Wait for all registers to be synchronized */
+	RTC.CTRLA = RTC_PRESCALER_DIV1_gc | RTC_RTCEN_bm; /* Enable RTC, no prescaler */
+	RTC.CLKSEL = RTC_CLKSEL_INT32K_gc; /* Select 32.768 kHz internal RC oscillator */
+	RTC.PER = RTC_PERIOD - 1; /* The RTC overflows every PER + 1 cycles */
+	while(RTC.STATUS > 0);  /* Wait for all registers to be synchronized */
+
+	while(RTC.PITSTATUS > 0);
+	RTC.PITCTRLA = RTC_PERIOD_CYC32768_gc | RTC_PITEN_bm; /* 1 second period */
+	RTC.PITINTCTRL = RTC_PI_bm; /* Enable PIT interrupt */
+}
+
+/*********************************************************************************
+TCA0 initialization: free-running counter used as timestamp
+**********************************************************************************/
+void tca_init(void)
+{
+	TCA0.SINGLE.PER = 0xFFFF;
+	TCA0.SINGLE.CTRLA = TCA_SINGLE_CLKSEL_DIV1_gc | TCA_SINGLE_ENABLE_bm;
+}
+
+/**********************************************************************************
+ADC initialization
+**********************************************************************************/
+void adc_init()
+{
+	ADC0.CTRLA = ADC_ENABLE_bm;
+	ADC0.CTRLB = ADC_PRESC_DIV2_gc; /* fCLK_ADC = 3.333333/2 MHz */
+	ADC0.CTRLC = ADC_REFSEL_1024MV_gc | (TIMEBASE_VALUE << ADC_TIMEBASE_gp);
+	ADC0.CTRLE = 17; /* (SAMPDUR + 0.5) * fCLK_ADC = 10.5 µs sample duration */
+	ADC0.CTRLF = ADC_SAMPNUM_CONFIG;
+	ADC0.INTCTRL = ADC_RESRDY_bm; /* Enable Result Ready interrupt */
+
+	/* Enable PGA with 16x gain. The PGA stays enabled while VDD/10 is measured,
+	so it does not need to start up again before the current burst.
+	Set full bias current for fast sampling. Configure ADCPGASAMPDUR according to data sheet. */
+	ADC0.PGACTRL = ADC_GAIN_16X_gc | ADC_PGABIASSEL_1X_gc | ADC_ADCPGASAMPDUR_6CLK_gc | ADC_PGAEN_bm;
+
+	/* The reference is shared by both channels, so no reference settling time is needed */
+	ADC0.MUXPOS = ADC_MUXPOS_VDDDIV10_gc; /* ADC channel VDD/10 */
+	/* Start ADC Burst conversion on event trigger */
+	ADC0.COMMAND = ADC_MODE_BURST_gc | ADC_START_EVENT_TRIGGER_gc;
+}
+
+/***********************************************************************************
+Result Ready interrupt:
+The voltage burst is started by the RTC event. When it is done, the current burst
+is started immediately, so the gap between the two channels is only the interrupt
+latency. When the current burst is done, the ADC is prepared for the next event.
+Both bursts take the same time, so the time between the two results is the skew
+between the two measurements.
+***********************************************************************************/
+ISR(ADC0_RESRDY_vect)
+{
+	static pair_channel_t channel = CHANNEL_VOLTAGE;
+	static uint16_t voltage_time;
+	static uint16_t voltage_raw;
+#if PAIR_ALIGN
+	static int16_t current_previous;
+	static uint8_t current_previous_valid;
+#endif
+	uint16_t now = TCA0.SINGLE.CNT;
+
+	if(channel == CHANNEL_VOLTAGE)
+	{
+		voltage_time = now;
+		voltage_raw = ADC0.RESULT; /* Read ADC result, clears the interrupt flag */
+
+		ADC0.MUXPOS = ADC_VIA_PGA_gc | ADC_MUXPOS_AIN6_gc; /* ADC channel AIN6 -> PA6 */
+		ADC0.MUXNEG = ADC_VIA_PGA_gc | ADC_MUXNEG_AIN7_gc; /* ADC channel AIN7 -> PA7 */
+		ADC0.COMMAND = ADC_DIFF_bm | ADC_MODE_BURST_gc | ADC_START_IMMEDIATE_gc;
+		channel = CHANNEL_CURRENT;
+	}
+	else
+	{
+		int16_t current_raw = ADC0.RESULT; /* Read ADC result, clears the interrupt flag */
+		uint16_t skew = now - voltage_time;
+
+		ADC0.MUXPOS = ADC_MUXPOS_VDDDIV10_gc; /* ADC channel VDD/10 */
+		ADC0.COMMAND = ADC_MODE_BURST_gc | ADC_START_EVENT_TRIGGER_gc;
+		channel = CHANNEL_VOLTAGE;
+
+		pair.voltage_raw = voltage_raw;
+#if PAIR_ALIGN
+		/* Interpolate between the previous and this current result, to the time of the
+		voltage result, which is one skew before this result and (period - skew) after
+		the previous one. The first pair has no previous result, and is not aligned. */
+		if(current_previous_valid)
+		{
+			pair.current_raw = current_previous + (int16_t) (((int32_t) (current_raw - current_previous)
+			                   * (PAIR_PERIOD_TICKS - skew)) / PAIR_PERIOD_TICKS);
+		}
+		else
+		{
+			pair.current_raw = current_raw;
+		}
+		current_previous = current_raw;
+		current_previous_valid = 1;
+#else
+		pair.current_raw = current_raw;
+#endif
+		pair.skew = skew;
+		pair.count++;
+	}
+}
+
+/***********************************************************************************
+PIT interrupt: calculates the achieved pair rate once per second
+***********************************************************************************/
+ISR(RTC_PIT_vect)
+{
+	RTC.PITINTFLAGS = RTC_PI_bm; /* Clear PIT interrupt flag */
+
+	pair_rate = pair.count;
+	pair.count = 0;
+}
+
+int main(void)
+{
+	adc_pair_t copy;
+
+	event_system_init();
+	rtc_init();
+	tca_init();
+	adc_init();
+	sei(); /* Enable global interrupts */
+
+	while(1)
+	{
+		_delay_ms(500);
+
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			copy = pair;
+		}
+
+		/* Calculate VDD, VREF = 1.024V, 12-bit resolution.
+		   Multiplied by 10 because the input channel is VDD/10. */
+		vdd = (float)(copy.voltage_raw * 1.024 * 10) / ADC_MAX_VALUE / ADC_SAMPLES;
+		/* Calculate the current through the shunt, VREF = 1.024V, 12-bit resolution, 16x gain */
+		current = (float)(copy.current_raw * 1.024) / ADC_DIFF_MAX_VALUE / ADC_SAMPLES / PGA_GAIN / SHUNT_RESISTANCE;
+		power = vdd * current;
+		skew_us = (float) copy.skew * 1000000 / F_CPU;
+	}
+}
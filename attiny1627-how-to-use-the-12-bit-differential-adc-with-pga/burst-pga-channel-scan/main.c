@@ -0,0 +1,338 @@
+/*
+    \file   main.c
+
+    \brief  How To Use the 12-Bit Differential ADC in Burst Accumulation Mode
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+
+/*
+ *
+ * How To Use the 12-Bit Differential ADC in Burst Accumulation Mode:
+ * PGA Channel Scan
+ *
+ */
+
+#define F_CPU 3333333ul
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdbool.h>
+#include <math.h>
+
+#define TIMEBASE_VALUE              ((uint8_t) ceil(F_CPU*0.000001))
+#define ADC_DIFF_MAX_VALUE          (((1 << 12) / 2) - 1)                   /* In differential mode, the max value is 2047 */
+#define ADC_DIFF_MAX_VALUE_16BIT    ((uint32_t) ADC_DIFF_MAX_VALUE << 4)    /* In differential mode, the max value for a 16-bit result is 32752 */
+
+/* Defines to easily configure ADC accumulation */
+#define ADC_SAMPNUM_CONFIG  ADC_SAMPNUM_ACC64_gc
+/* Left shifting (1 << SAMPNUM) results in the number of accumulated samples */
+#define ADC_SAMPLES         (1 << ADC_SAMPNUM_CONFIG)
+
+#define ADC_CLOCK           (F_CPU / 2)     /* Hz, fCLK_ADC = 3.333333/2 MHz */
+#define ADC_SAMPDUR         17              /* (SAMPDUR + 0.5) * fCLK_ADC = 10.5 µs sample duration */
+#define ADC_CONVERSION_CLKS 13              /* CLK_ADC cycles per conversion after sampling */
+
+/* Full scans of all channels per second */
+#define SCAN_RATE           20      /* Hz */
+#define RTC_CLOCK           32768   /* Hz */
+#define RTC_PERIOD          (RTC_CLOCK / SCAN_RATE)
+
+/* Settling model, estimates as in host-tools/adc-sweep. Replace them with values from
+   the data sheet and measurements on the application circuit. */
+#define SETTLE_TIME_CONSTANTS   9       /* e^-9 < 1/4096, settled to 12 bits */
+#define SAMPLE_CAP_PF           8       /* pF, sampling capacitor */
+#define INPUT_RESISTANCE        10000   /* Ohm, switch and routing */
+#define PGA_TAU_FULL_BIAS_NS    200     /* ns, PGA settling time constant at full bias */
+
+/******************************************************************************
+Scan channels:
+Each entry is a differential input pair through the PGA, its gain, and the
+resistance of the source, which sets the time the sampling capacitor needs to
+settle after the input was switched from another channel.
+*******************************************************************************/
+typedef struct
+{
+	uint8_t muxpos;
+	uint8_t muxneg;
+	uint8_t gain;               /* ADC0.PGACTRL GAIN bit field */
+	uint8_t gain_value;
+	uint32_t source_resistance; /* Ohm */
+} scan_channel_t;
+
+static const scan_channel_t scan_channels[] =
+{
+	{ ADC_VIA_PGA_gc | ADC_MUXPOS_AIN6_gc, ADC_VIA_PGA_gc | ADC_MUXNEG_AIN7_gc, ADC_GAIN_16X_gc, 16, 100 },     /* Shunt resistor */
+	{ ADC_VIA_PGA_gc | ADC_MUXPOS_AIN4_gc, ADC_VIA_PGA_gc | ADC_MUXNEG_AIN5_gc, ADC_GAIN_4X_gc,  4,  10000 },   /* Bridge sensor */
+	{ ADC_VIA_PGA_gc | ADC_MUXPOS_AIN1_gc, ADC_VIA_PGA_gc | ADC_MUXNEG_AIN2_gc, ADC_GAIN_1X_gc,  1,  220000 },  /* High impedance divider */
+};
+
+#define ARRAY_SIZE(a)       (sizeof(a) / sizeof((a)[0]))
+#define SCAN_CHANNELS       ARRAY_SIZE(scan_channels)
+
+/* PGA bias settings, lowest current first */
+static const struct
+{
+	uint8_t value;
+	uint8_t quarters;   /* Bias current in quarters of full bias */
+} pga_biases[] =
+{
+	{ ADC_PGABIASSEL_1_4X_gc, 1 },
+	{ ADC_PGABIASSEL_1_2X_gc, 2 },
+	{ ADC_PGABIASSEL_3_4X_gc, 3 },
+	{ ADC_PGABIASSEL_1X_gc,   4 },
+};
+
+/* ADCPGASAMPDUR settings, shortest first */
+static const struct
+{
+	uint8_t value;
+	uint8_t clks;
+} pga_sampdurs[] =
+{
+	{ ADC_ADCPGASAMPDUR_6CLK_gc,  6 },
+	{ ADC_ADCPGASAMPDUR_15CLK_gc, 15 },
+	{ ADC_ADCPGASAMPDUR_20CLK_gc, 20 },
+};
+
+/******************************************************************************
+Scan plan:
+pgactrl         PGA bias and ADCPGASAMPDUR, the gain is set per channel
+settle_sampdur  0 when the first sample after switching to the channel settles
+                within SAMPDUR. Otherwise, one conversion with this SAMPDUR is
+                done and discarded before the burst.
+scan_time_us    Time of one scan with this plan
+*******************************************************************************/
+typedef struct
+{
+	uint8_t pgactrl;
+	uint8_t settle_sampdur[SCAN_CHANNELS];
+	uint32_t scan_time_us;
+} scan_plan_t;
+
+/* Volatile variables to improve debug experience */
+static volatile scan_plan_t plan;
+static volatile int16_t scan_results[SCAN_CHANNELS];    /* 16-bit scaled results */
+static volatile bool scan_done;
+static volatile uint16_t scan_count;
+static volatile uint16_t scan_overruns;                 /* Scans started before the previous one was done */
+static volatile uint16_t discarded_conversions;
+static volatile float voltages[SCAN_CHANNELS];
+
+static uint8_t scan_channel;
+static bool scan_busy;
+static bool settling;
+
+/**********************************************************************************
+Plan the scan:
+With the lowest PGA bias first, find the shortest ADCPGASAMPDUR that lets the PGA
+output settle within SETTLE_TIME_CONSTANTS time constants; the time constant grows
+as the bias current is reduced. Then find, for every channel, whether the sampling
+capacitor settles within the first sample after the switch. Inside a burst, the
+capacitor only sees the small changes of the same input, so only the first sample
+after a switch needs the longer settling time. The first bias where the whole
+scan fits in the scan period is used, which saves PGA current when the rate
+allows. Returns 0 if no bias fits.
+**********************************************************************************/
+uint8_t scan_plan(scan_plan_t *result)
+{
+	for(uint8_t b = 0; b < ARRAY_SIZE(pga_biases); b++)
+	{
+		uint32_t pga_settle_ns = (uint32_t)SETTLE_TIME_CONSTANTS * PGA_TAU_FULL_BIAS_NS * 4 / pga_biases[b].quarters;
+		uint8_t s;
+
+		for(s = 0; s < ARRAY_SIZE(pga_sampdurs); s++)
+		{
+			if((uint32_t)pga_sampdurs[s].clks * 1000000ul / (ADC_CLOCK / 1000) >= pga_settle_ns)
+			{
+				break;
+			}
+		}
+		if(s == ARRAY_SIZE(pga_sampdurs))
+		{
+			continue;
+		}
+
+		/* Burst of ADC_SAMPLES conversions, in CLK_ADC cycles; half cycles are rounded up */
+		uint32_t conversion_clks = ADC_SAMPDUR + 1 + ADC_CONVERSION_CLKS + pga_sampdurs[s].clks;
+		uint32_t scan_clks = 0;
+
+		for(uint8_t c = 0; c < SCAN_CHANNELS; c++)
+		{
+			/* SETTLE_TIME_CONSTANTS * R * C, in ns */
+			uint32_t settle_ns = SETTLE_TIME_CONSTANTS * (scan_channels[c].source_resistance + INPUT_RESISTANCE) / 1000 * SAMPLE_CAP_PF;
+			/* (SAMPDUR + 0.5) / fCLK_ADC >= settle_ns, rounded up */
+			uint32_t sampdur = (settle_ns * (ADC_CLOCK / 1000) + 999999) / 1000000;
+
+			if(sampdur <= ADC_SAMPDUR)
+			{
+				result->settle_sampdur[c] = 0;
+			}
+			else
+			{
+				result->settle_sampdur[c] = (sampdur > 0xFF) ? 0xFF : sampdur;
+				scan_clks += result->settle_sampdur[c] + 1 + ADC_CONVERSION_CLKS + pga_sampdurs[s].clks;
+			}
+			scan_clks += ADC_SAMPLES * conversion_clks;
+		}
+
+		result->scan_time_us = scan_clks * 1000 / (ADC_CLOCK / 1000);
+		if(result->scan_time_us < 1000000ul / SCAN_RATE)
+		{
+			result->pgactrl = pga_biases[b].value | pga_sampdurs[s].value;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/**********************************************************************************
+Switch to a channel and start its conversion: a discarded settling conversion
+if the plan needs one, or the burst
+**********************************************************************************/
+static void scan_switch(uint8_t channel)
+{
+	const scan_channel_t *next = &scan_channels[channel];
+
+	ADC0.MUXPOS = next->muxpos;
+	ADC0.MUXNEG = next->muxneg;
+	ADC0.PGACTRL = next->gain | plan.pgactrl | ADC_PGAEN_bm;
+
+	settling = plan.settle_sampdur[channel] != 0;
+	if(settling)
+	{
+		ADC0.CTRLE = plan.settle_sampdur[channel];
+		ADC0.COMMAND = ADC_DIFF_bm | ADC_MODE_SINGLE_12BIT_gc | ADC_START_IMMEDIATE_gc;
+	}
+	else
+	{
+		ADC0.COMMAND = ADC_DIFF_bm | ADC_MODE_BURST_SCALING_gc | ADC_START_IMMEDIATE_gc;
+	}
+}
+
+/*********************************************************************************
+RTC initialization: Overflow interrupt starts a scan SCAN_RATE times per second
+**********************************************************************************/
+void rtc_init()
+{
+	while(RTC.STATUS > 0);  /* Wait for all registers to be synchronized */
+	RTC.CTRLA = RTC_PRESCALER_DIV1_gc | RTC_RTCEN_bm; /* Enable RTC, no prescaler */
+	RTC.CLKSEL = RTC_CLKSEL_INT32K_gc; /* Select 32.768 kHz internal RC oscillator */
+	RTC.PER = RTC_PERIOD;
+	RTC.INTCTRL = RTC_OVF_bm; /* Enable overflow interrupt */
+	while(RTC.STATUS > 0);  /* Wait for all registers to be synchronized */
+}
+
+/*********************************************************************************
+ADC initialization
+**********************************************************************************/
+void adc_init()
+{
+	ADC0.CTRLA = ADC_ENABLE_bm;
+	ADC0.CTRLB = ADC_PRESC_DIV2_gc; /* fCLK_ADC = 3.333333/2 MHz */
+	ADC0.CTRLC = ADC_REFSEL_1024MV_gc | (TIMEBASE_VALUE << ADC_TIMEBASE_gp);
+	ADC0.CTRLE = ADC_SAMPDUR;
+	ADC0.CTRLF = ADC_LEFTADJ_bm | ADC_SAMPNUM_CONFIG; /* Enable left adjust if accumulating < 16 samples */
+	ADC0.INTCTRL = ADC_RESRDY_bm; /* Enable Result Ready interrupt */
+
+	/* Enable PGA with the bias and ADCPGASAMPDUR of the plan */
+	ADC0.PGACTRL = scan_channels[0].gain | plan.pgactrl | ADC_PGAEN_bm;
+}
+
+/***********************************************************************************
+RTC Overflow interrupt: Starts a scan with the first channel
+***********************************************************************************/
+ISR(RTC_CNT_vect)
+{
+	RTC.INTFLAGS = RTC_OVF_bm; /* Clear interrupt flag */
+
+	if(scan_busy)
+	{
+		scan_overruns++;
+		return;
+	}
+	scan_busy = true;
+	scan_channel = 0;
+	scan_switch(0);
+}
+
+/***********************************************************************************
+Result Ready interrupt:
+After a settling conversion, the result is discarded and the burst is started
+on the same channel with the normal SAMPDUR. After a burst, the result is stored
+and the next channel is started.
+***********************************************************************************/
+ISR(ADC0_RESRDY_vect)
+{
+	int16_t result = ADC0.RESULT; /* Read result, clears the interrupt flag */
+
+	if(settling)
+	{
+		settling = false;
+		discarded_conversions++;
+		ADC0.CTRLE = ADC_SAMPDUR;
+		ADC0.COMMAND = ADC_DIFF_bm | ADC_MODE_BURST_SCALING_gc | ADC_START_IMMEDIATE_gc;
+		return;
+	}
+
+	scan_results[scan_channel] = result;
+	if(++scan_channel < SCAN_CHANNELS)
+	{
+		scan_switch(scan_channel);
+		return;
+	}
+
+	scan_busy = false;
+	scan_done = true;
+	scan_count++;
+}
+
+int main(void)
+{
+	scan_plan_t settings;
+
+	if(!scan_plan(&settings))
+	{
+		/* The scan does not fit in the scan period; lower SCAN_RATE or ADC_SAMPNUM_CONFIG */
+		while(1);
+	}
+	plan = settings;
+
+	adc_init();
+	rtc_init();
+	sei(); /* Enable global interrupts */
+
+	while(1)
+	{
+		if(scan_done)
+		{
+			scan_done = false;
+
+			for(uint8_t c = 0; c < SCAN_CHANNELS; c++)
+			{
+				/* Calculate the differential voltage, VREF = 1.024V, 16-bit resolution, with the gain of the channel. */
+				voltages[c] = (float)((scan_results[c] * 1.024) / ADC_DIFF_MAX_VALUE_16BIT) / scan_channels[c].gain_value;
+			}
+		}
+	}
+}
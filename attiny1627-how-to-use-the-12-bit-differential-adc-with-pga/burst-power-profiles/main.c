@@ -0,0 +1,299 @@
+/*
+    \file   main.c
+
+    \brief  How To Use the 12-Bit Differential ADC in Burst Accumulation Mode
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+/*
+ *
+ * How To Use the 12-Bit Differential ADC in Burst Accumulation Mode:
+ * Power Profiles
+ *
+ */
+
+#define F_CPU 3333333ul
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <stdbool.h>
+#include <math.h>
+
+#define TIMEBASE_VALUE              ((uint8_t) ceil(F_CPU*0.000001))
+#define ADC_DIFF_MAX_VALUE          (((1 << 12) / 2) - 1)                   /* In differential mode, the max value is 2047 */
+#define ADC_DIFF_MAX_VALUE_16BIT    ((uint32_t) ADC_DIFF_MAX_VALUE << 4)    /* In differential mode, the max value for a 16-bit result is 32752 */
+
+#define ADC_GAIN_VALUE      16
+#define RTC_CLOCK           32768   /* Hz */
+#define SLEEP_NONE          0xFF    /* The CPU polls instead of sleeping */
+
+/******************************************************************************
+Power profiles:
+Each profile is a complete ADC configuration and a CPU sleep policy, from the
+highest result rate to the lowest current draw.
+
+prescaler           ADC0.CTRLB
+sampdur             ADC0.CTRLE
+sampnum             ADC0.CTRLF, SAMPNUM and LEFTADJ when accumulating < 16
+                    samples, so that the scaled result is 16 bits
+pgactrl             PGA bias and ADCPGASAMPDUR, the gain is ADC_GAIN_VALUE
+ctrla               LOWLAT keeps the ADC and reference powered between
+                    conversions, RUNSTDBY lets a burst run in standby
+enable_on_demand    The ADC and PGA are only enabled for each burst
+sleep_mode          Sleep mode used while waiting for a result, or SLEEP_NONE
+rtc_period          RTC cycles between results, or 0 to start the next burst
+                    as soon as a result is ready
+
+The settings are from host-tools/adc-sweep for a 100 Ohm source with 5 µV noise,
+for example "adc_sweep -g 16 -s 100 -n 5 -R 1.024 -c 2:1:2:0.75:6". The model
+gives the ADC and PGA current during the bursts only, not the CPU, the RTC or
+the sleep current:
+
+Profile             ENOB    Max results/s   Energy/result   Rate     ADC+PGA average
+MAX_THROUGHPUT      12.04   20325           0.130 µJ        20325/s  800 µA
+BALANCED            13.73   854             1.932 µJ        10/s     5.9 µA
+ULTRA_LOW_POWER     13.20   1766            0.935 µJ        1/s      0.28 µA
+
+The model draws the same current at every ADC clock, so the fastest ADC clock
+with the shortest sample duration that still settles gives the lowest energy
+per result; the low power profiles save current with a lower PGA bias, fewer
+results and sleep instead of a larger prescaler. Measure the current on the
+application board before relying on these numbers.
+*******************************************************************************/
+typedef enum
+{
+	PROFILE_MAX_THROUGHPUT,
+	PROFILE_BALANCED,
+	PROFILE_ULTRA_LOW_POWER,
+	PROFILE_COUNT
+} profile_id_t;
+
+typedef struct
+{
+	uint8_t prescaler;
+	uint8_t sampdur;
+	uint8_t sampnum;
+	uint8_t pgactrl;
+	uint8_t ctrla;
+	bool enable_on_demand;
+	uint8_t sleep_mode;
+	uint16_t rtc_period;
+} power_profile_t;
+
+static const power_profile_t power_profiles[PROFILE_COUNT] =
+{
+	[PROFILE_MAX_THROUGHPUT] =
+	{
+		ADC_PRESC_DIV2_gc, 1, ADC_LEFTADJ_bm | ADC_SAMPNUM_ACC4_gc,
+		ADC_PGABIASSEL_3_4X_gc | ADC_ADCPGASAMPDUR_6CLK_gc,
+		ADC_LOWLAT_bm, false, SLEEP_NONE, 0
+	},
+	[PROFILE_BALANCED] =
+	{
+		ADC_PRESC_DIV2_gc, 2, ADC_SAMPNUM_ACC64_gc,
+		ADC_PGABIASSEL_1_4X_gc | ADC_ADCPGASAMPDUR_15CLK_gc,
+		0, false, SLEEP_MODE_IDLE, RTC_CLOCK / 10
+	},
+	[PROFILE_ULTRA_LOW_POWER] =
+	{
+		ADC_PRESC_DIV2_gc, 1, ADC_SAMPNUM_ACC32_gc,
+		ADC_PGABIASSEL_1_4X_gc | ADC_ADCPGASAMPDUR_15CLK_gc,
+		ADC_RUNSTDBY_bm, true, SLEEP_MODE_STANDBY, RTC_CLOCK
+	},
+};
+
+/* Volatile variables to improve debug experience */
+static volatile profile_id_t requested_profile = PROFILE_BALANCED;  /* Change to switch the profile */
+static volatile profile_id_t active_profile;
+static volatile int16_t adc_result;
+static volatile bool result_ready;
+static volatile uint32_t result_count;
+static volatile float diff_voltage;
+
+static const power_profile_t *profile;
+
+/*********************************************************************************
+ADC initialization: The settings that are the same in all profiles
+**********************************************************************************/
+void adc_init()
+{
+	ADC0.CTRLC = ADC_REFSEL_1024MV_gc | (TIMEBASE_VALUE << ADC_TIMEBASE_gp);
+	ADC0.MUXPOS = ADC_VIA_PGA_gc | ADC_MUXPOS_AIN6_gc; /* ADC channel AIN6 -> PA6 */
+	ADC0.MUXNEG = ADC_VIA_PGA_gc | ADC_MUXNEG_AIN7_gc; /* ADC channel AIN7 -> PA7 */
+	ADC0.INTCTRL = ADC_RESRDY_bm; /* Enable Result Ready interrupt */
+}
+
+/*********************************************************************************
+RTC initialization: Runs in standby, the period and the overflow interrupt are
+set by the profile
+**********************************************************************************/
+void rtc_init()
+{
+	while(RTC.STATUS > 0);  /* Wait for all registers to be synchronized */
+	RTC.CLKSEL = RTC_CLKSEL_INT32K_gc; /* Select 32.768 kHz internal RC oscillator */
+	RTC.CTRLA = RTC_PRESCALER_DIV1_gc | RTC_RUNSTDBY_bm | RTC_RTCEN_bm; /* Enable RTC in standby, no prescaler */
+	while(RTC.STATUS > 0);  /* Wait for all registers to be synchronized */
+}
+
+static void burst_start()
+{
+	if(profile->enable_on_demand)
+	{
+		ADC0.PGACTRL = ADC_GAIN_16X_gc | profile->pgactrl | ADC_PGAEN_bm;
+		ADC0.CTRLA = profile->ctrla | ADC_ENABLE_bm;
+	}
+	ADC0.COMMAND = ADC_DIFF_bm | ADC_MODE_BURST_SCALING_gc | ADC_START_IMMEDIATE_gc;
+}
+
+/**********************************************************************************
+Switch to a profile at runtime:
+A burst that is running is finished and its result discarded, so that every
+result comes from one configuration. The ADC is disabled while it is
+reconfigured. With burst scaling, the result is 16 bits when 16 or more samples
+are accumulated, and the profiles with fewer samples set LEFTADJ, so the
+conversion to a voltage does not depend on the profile.
+**********************************************************************************/
+void profile_apply(profile_id_t id)
+{
+	const power_profile_t *next = &power_profiles[id];
+
+	cli();
+	while(ADC0.STATUS & ADC_ADCBUSY_bm);
+	ADC0.INTFLAGS = ADC_RESRDY_bm;  /* Discard the result of the old profile */
+	ADC0.CTRLA = 0;
+	ADC0.CTRLB = next->prescaler;
+	ADC0.CTRLE = next->sampdur;
+	ADC0.CTRLF = next->sampnum;
+
+	if(next->enable_on_demand)
+	{
+		ADC0.PGACTRL = ADC_GAIN_16X_gc | next->pgactrl;
+		ADC0.CTRLA = next->ctrla;
+	}
+	else
+	{
+		ADC0.PGACTRL = ADC_GAIN_16X_gc | next->pgactrl | ADC_PGAEN_bm;
+		ADC0.CTRLA = next->ctrla | ADC_ENABLE_bm;
+	}
+
+	if(next->sleep_mode != SLEEP_NONE)
+	{
+		set_sleep_mode(next->sleep_mode);
+	}
+
+	profile = next;
+	active_profile = id;
+	result_ready = false;
+
+	while(RTC.STATUS & RTC_PERBUSY_bm);
+	if(next->rtc_period)
+	{
+		RTC.PER = next->rtc_period - 1;
+		RTC.INTCTRL = RTC_OVF_bm; /* Enable overflow interrupt */
+	}
+	else
+	{
+		RTC.INTCTRL = 0;
+		burst_start();
+	}
+	sei();
+}
+
+/***********************************************************************************
+RTC Overflow interrupt: Starts a burst every rtc_period
+***********************************************************************************/
+ISR(RTC_CNT_vect)
+{
+	RTC.INTFLAGS = RTC_OVF_bm; /* Clear interrupt flag */
+
+	if(!(ADC0.STATUS & ADC_ADCBUSY_bm))
+	{
+		burst_start();
+	}
+}
+
+/***********************************************************************************
+Result Ready interrupt: Stores the result, and either starts the next burst or,
+with enable on demand, disables the ADC and PGA until the next RTC overflow
+***********************************************************************************/
+ISR(ADC0_RESRDY_vect)
+{
+	adc_result = ADC0.RESULT; /* Read result, clears the interrupt flag */
+	result_ready = true;
+	result_count++;
+
+	if(!profile->rtc_period)
+	{
+		ADC0.COMMAND = ADC_DIFF_bm | ADC_MODE_BURST_SCALING_gc | ADC_START_IMMEDIATE_gc;
+	}
+	else if(profile->enable_on_demand)
+	{
+		ADC0.CTRLA = profile->ctrla;
+		ADC0.PGACTRL = ADC_GAIN_16X_gc | profile->pgactrl;
+	}
+}
+
+int main(void)
+{
+	adc_init();
+	rtc_init();
+	profile_apply(requested_profile); /* Enables global interrupts */
+
+	while(1)
+	{
+		profile_id_t id = requested_profile;
+
+		if(id != active_profile && id < PROFILE_COUNT)
+		{
+			profile_apply(id);
+		}
+
+		if(result_ready)
+		{
+			int16_t result;
+
+			cli(); /* The 16-bit result is read in two instructions */
+			result = adc_result;
+			result_ready = false;
+			sei();
+
+			/* Calculate the differential voltage, VREF = 1.024V, 16-bit resolution, with the gain of the PGA */
+			diff_voltage = (float)((result * 1.024) / ADC_DIFF_MAX_VALUE_16BIT) / ADC_GAIN_VALUE;
+		}
+
+		if(profile->sleep_mode != SLEEP_NONE)
+		{
+			/* Sleep unless a result arrived after the check above; the instruction after sei() is executed before any interrupt */
+			cli();
+			if(!result_ready)
+			{
+				sleep_enable();
+				sei();
+				sleep_cpu();
+				sleep_disable();
+			}
+			sei();
+		}
+	}
+}
@@ -0,0 +1,192 @@
+/*
+    \file   main.c
+
+    \brief  How To Use the 12-Bit Differential ADC in Burst Accumulation Mode
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+
+/*
+ *
+ * How To Use the 12-Bit Differential ADC in Burst Accumulation Mode:
+ * Snapshot with Sequence Lock
+ *
+ */
+
+#define F_CPU 3333333ul
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <math.h>
+#include <util/delay.h>
+
+#define TIMEBASE_VALUE              ((uint8_t) ceil(F_CPU*0.000001))
+#define ADC_DIFF_MAX_VALUE          (((1 << 12) / 2) - 1)                   /* In differential mode, the max value is 2047 */
+#define ADC_DIFF_MAX_VALUE_16BIT    ((uint32_t) ADC_DIFF_MAX_VALUE << 4)    /* In differential mode, the max value for a 16-bit result is 32752 */
+
+/* Defines to easily configure ADC accumulation */
+#define ADC_SAMPNUM_CONFIG  ADC_SAMPNUM_ACC256_gc
+
+/* Defines to easily configure RTC event frequency */
+#define ADC_SAMPLING_FREQ   100     /* Hz */
+#define RTC_CLOCK           32768   /* Hz */
+#define RTC_PERIOD          (RTC_CLOCK / ADC_SAMPLING_FREQ)
+
+/*
+ * The latest result, published by the Result Ready interrupt. The sequence
+ * number is odd while the interrupt is writing the snapshot, and is incremented
+ * again when the snapshot is complete. A reader copies the snapshot and checks
+ * that the sequence number was even and did not change during the copy.
+ */
+typedef struct
+{
+	int32_t raw;            /* 16-bit scaled result */
+	float voltage;          /* Differential voltage in V */
+	uint32_t timestamp;     /* Time of the conversion trigger in RTC ticks */
+} adc_snapshot_t;
+
+static volatile uint8_t snapshot_sequence;
+static volatile adc_snapshot_t snapshot;
+
+/* Volatile variables to improve debug experience */
+static volatile int32_t adc_reading;
+static volatile float voltage;
+static volatile float current;
+static volatile uint32_t timestamp;
+static volatile uint16_t snapshot_retries;
+
+/******************************************************************************
+EVSYS initialization:
+Channel 0:
+            Event system generator: RTC Overflow
+            Event system user: ADC0
+*******************************************************************************/
+void event_system_init(void)
+{
+	EVSYS.CHANNEL0 = EVSYS_CHANNEL0_RTC_OVF_gc;     /* RTC Overflow ->  Channel 0 */
+	EVSYS.USERADC0START = EVSYS_USER_CHANNEL0_gc;   /* Channel 0    ->  ADC0 Start */
+}
+
+/*********************************************************************************
+RTC initialization
+**********************************************************************************/
+void rtc_init(void)
+{
+	while(RTC.STATUS > 0);  /* Wait for all registers to be synchronized */
+	RTC.CTRLA = RTC_PRESCALER_DIV1_gc | RTC_RTCEN_bm; /* Enable RTC, no prescaler */
+	RTC.CLKSEL = RTC_CLKSEL_INT32K_gc; /* Select 32.768 kHz internal RC oscillator */
+	RTC.PER = RTC_PERIOD;
+	while(RTC.STATUS > 0);  /* Wait for all registers to be synchronized */
+}
+
+/*********************************************************************************
+ADC initialization
+**********************************************************************************/
+void adc_init()
+{
+	ADC0.CTRLA = ADC_ENABLE_bm;
+	ADC0.CTRLB = ADC_PRESC_DIV2_gc; /* fCLK_ADC = 3.333333/2 MHz */
+	ADC0.CTRLC = ADC_REFSEL_1024MV_gc | (TIMEBASE_VALUE << ADC_TIMEBASE_gp);
+	ADC0.CTRLE = 17; /* (SAMPDUR + 0.5) * fCLK_ADC = 10.5 µs sample duration */
+	ADC0.CTRLF = ADC_SAMPNUM_CONFIG;
+	ADC0.INTCTRL = ADC_RESRDY_bm; /* Enable Result Ready interrupt */
+
+	ADC0.MUXPOS = ADC_VIA_PGA_gc | ADC_MUXPOS_AIN6_gc; /* ADC channel AIN6 -> PA6 */
+	ADC0.MUXNEG = ADC_VIA_PGA_gc | ADC_MUXNEG_AIN7_gc; /* ADC channel AIN7 -> PA7 */
+	/* Start ADC Burst conversion with Scaling on event trigger */
+	ADC0.COMMAND = ADC_DIFF_bm | ADC_MODE_BURST_SCALING_gc | ADC_START_EVENT_TRIGGER_gc;
+
+	/* Enable PGA with 16x gain.
+	Set full bias current for fast sampling. Configure ADCPGASAMPDUR according to data sheet. */
+	ADC0.PGACTRL = ADC_GAIN_16X_gc | ADC_PGABIASSEL_1X_gc | ADC_ADCPGASAMPDUR_6CLK_gc | ADC_PGAEN_bm;
+}
+
+/**********************************************************************************
+Read the latest snapshot without disabling interrupts. If the Result Ready
+interrupt updates the snapshot while it is copied, the copy is repeated.
+The interrupt cannot be interrupted by the reader, so the sequence number is
+always even again when the reader runs. An 8-bit sequence number is enough,
+since the snapshot would have to be updated 128 times during one copy to wrap.
+Returns the number of retries.
+**********************************************************************************/
+uint8_t snapshot_read(adc_snapshot_t *copy)
+{
+	uint8_t retries = 0;
+	uint8_t sequence;
+
+	while(1)
+	{
+		sequence = snapshot_sequence;
+		copy->raw = snapshot.raw;
+		copy->voltage = snapshot.voltage;
+		copy->timestamp = snapshot.timestamp;
+		/* The volatile accesses keep the copy between the two sequence reads */
+		if(!(sequence & 1) && sequence == snapshot_sequence)
+		{
+			return retries;
+		}
+		retries++;
+	}
+}
+
+/***********************************************************************************
+Result Ready interrupt:
+Publishes the result, the voltage and the time of the conversion trigger.
+***********************************************************************************/
+ISR(ADC0_RESRDY_vect)
+{
+	static uint32_t trigger_time;
+	int32_t result = ADC0.RESULT; /* Read 16 bit scaled result, clears the interrupt flag */
+
+	trigger_time += RTC_PERIOD + 1; /* The RTC overflows every PER + 1 cycles */
+
+	snapshot_sequence++; /* Odd: snapshot is being written */
+	snapshot.raw = result;
+	/* Calculate the differential voltage, VREF = 1.024V, 16-bit resolution, 16x gain. */
+	snapshot.voltage = (float)((result * 1.024) / ADC_DIFF_MAX_VALUE_16BIT) / 16;
+	snapshot.timestamp = trigger_time;
+	snapshot_sequence++; /* Even: snapshot is complete */
+}
+
+int main(void)
+{
+	adc_snapshot_t result;
+
+	event_system_init();
+	rtc_init();
+	adc_init();
+	sei(); /* Enable global interrupts */
+
+	while(1)
+	{
+		snapshot_retries += snapshot_read(&result);
+
+		/* The values are consistent: they are from the same conversion */
+		adc_reading = result.raw;
+		voltage = result.voltage;
+		timestamp = result.timestamp;
+		//current = voltage / 5;   /* Uncomment this line if measuring across a 5 ohm resistor in series with the power supply */
+
+		_delay_ms(500);
+	}
+}
@@ -0,0 +1,570 @@
+/*
+    \file   main.c
+
+    \brief  How To Use the 12-Bit Differential ADC in Burst Accumulation Mode
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+
+/*
+ *
+ * How To Use the 12-Bit Differential ADC in Burst Accumulation Mode:
+ * USART Command Interface
+ *
+ */
+
+#define F_CPU 3333333ul
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <util/crc16.h>
+#include <stdbool.h>
+#include <math.h>
+
+#define TIMEBASE_VALUE      ((uint8_t) ceil(F_CPU*0.000001))
+#define BAUD_RATE           115200
+#define BAUD_REG_VAL        ((float)(64 * F_CPU / (16 * (float)BAUD_RATE)) + 0.5)
+
+/* Default configuration, all of it can be changed at runtime over USART0 */
+#define ADC_SAMPNUM_CONFIG  ADC_SAMPNUM_ACC8_gc
+#define ADC_SAMPLING_FREQ   100     /* Hz */
+#define RTC_CLOCK           32768   /* Hz */
+#define RTC_PERIOD          (RTC_CLOCK / ADC_SAMPLING_FREQ)
+#define RTC_PERIOD_MIN      32      /* Highest sampling frequency is RTC_CLOCK / 32 = 1024 Hz */
+
+/******************************************************************************
+Command protocol:
+All frames, in both directions, have the format
+
+    | SYNC (0xA5) | CMD | LEN | PAYLOAD (LEN bytes) | CRC-8 |
+
+The CRC-8 (polynomial 0x07, initial value 0) covers CMD, LEN and PAYLOAD.
+Multi-byte values are little endian. Every command is answered with a frame
+where CMD has the response bit set and the payload holds a status byte,
+except CMD_GET_STATS which answers with the statistics. Frames with a bad
+CRC are dropped and counted as receive errors.
+*******************************************************************************/
+#define FRAME_SYNC          0xA5
+#define FRAME_MAX_PAYLOAD   12
+#define FRAME_RESPONSE_bm   0x80
+
+#define CMD_SET_MUX         0x01    /* MUXPOS, MUXNEG, DIFF (0 or 1) */
+#define CMD_SET_SAMPNUM     0x02    /* SAMPNUM bit field value, 0 - 10 */
+#define CMD_SET_PGA         0x03    /* PGACTRL register value, reserved GAIN and ADCPGASAMPDUR values are rejected */
+#define CMD_SET_WINDOW      0x04    /* WINCM, WINLT (16-bit), WINHT (16-bit) */
+#define CMD_SET_FREQ        0x05    /* Sampling frequency in Hz (16-bit) */
+#define CMD_STREAM_START    0x10
+#define CMD_STREAM_STOP     0x11
+#define CMD_GET_STATS       0x20
+#define CMD_STREAM_DATA     0x30    /* Device to host only: SEQ, RESULT (32-bit), FLAGS */
+
+#define STATUS_OK           0x00
+#define STATUS_BAD_LENGTH   0x01
+#define STATUS_BAD_VALUE    0x02
+#define STATUS_UNKNOWN_CMD  0x03
+
+#define STREAM_FLAG_WCMP    0x01    /* Set when the result matched the configured window-compare condition (WINCM) */
+
+/* Buffer sizes must be powers of two */
+#define RX_BUFFER_SIZE      32
+#define TX_BUFFER_SIZE      64
+
+typedef struct
+{
+	uint8_t muxpos;
+	uint8_t muxneg;
+	uint8_t command;
+	uint8_t ctrlf;
+	uint8_t pgactrl;
+	uint8_t ctrld;
+	uint16_t winlt;
+	uint16_t winht;
+	uint16_t rtc_period;
+} adc_config_t;
+
+typedef struct
+{
+	uint32_t conversions;
+	uint16_t tx_dropped;
+	uint16_t rx_errors;
+	uint16_t configs_applied;
+} adc_stats_t;
+
+typedef enum
+{
+	PARSER_SYNC,
+	PARSER_CMD,
+	PARSER_LEN,
+	PARSER_PAYLOAD,
+	PARSER_CRC
+} parser_state_t;
+
+/* Configuration requested by the host, owned by main() */
+static adc_config_t requested_config;
+/* Configuration handed over to the Result Ready interrupt */
+static adc_config_t pending_config;
+static volatile bool config_pending;
+
+/* RTC period waiting for the next RTC overflow */
+static volatile uint16_t pending_rtc_period;
+
+static volatile bool streaming;
+static volatile adc_stats_t stats;
+static volatile int32_t adc_reading;
+
+static volatile uint8_t rx_buffer[RX_BUFFER_SIZE];
+static volatile uint8_t rx_head;
+static volatile uint8_t rx_tail;
+
+static volatile uint8_t tx_buffer[TX_BUFFER_SIZE];
+static volatile uint8_t tx_head;
+static volatile uint8_t tx_tail;
+
+/******************************************************************************
+EVSYS initialization:
+Channel 0:
+            Event system generator: RTC Overflow
+            Event system user: ADC0
+*******************************************************************************/
+void event_system_init(void)
+{
+	EVSYS.CHANNEL0 = EVSYS_CHANNEL0_RTC_OVF_gc;     /* RTC Overflow ->  Channel 0 */
+	EVSYS.USERADC0START = EVSYS_USER_CHANNEL0_gc;   /* Channel 0    ->  ADC0 Start */
+}
+
+/*********************************************************************************
+RTC initialization
+**********************************************************************************/
+void rtc_init(void)
+{
+	while(RTC.STATUS > 0);  /* Wait for all registers to be synchronized */
+	RTC.CTRLA = RTC_PRESCALER_DIV1_gc | RTC_RTCEN_bm; /* Enable RTC, no prescaler */
+	RTC.CLKSEL = RTC_CLKSEL_INT32K_gc; /* Select 32.768 kHz internal RC oscillator */
+	RTC.PER = RTC_PERIOD;
+	while(RTC.STATUS > 0);  /* Wait for all registers to be synchronized */
+}
+
+/**********************************************************************************
+Write a complete configuration to the ADC. Must only be called while the ADC
+is idle, i.e. at init or from the Result Ready interrupt before the next event
+trigger arrives. A new RTC period is written by the RTC Overflow interrupt.
+**********************************************************************************/
+void adc_apply_config(const adc_config_t *config)
+{
+	ADC0.CTRLF = config->ctrlf;
+	ADC0.PGACTRL = config->pgactrl;
+	ADC0.MUXPOS = config->muxpos;
+	ADC0.MUXNEG = config->muxneg;
+	ADC0.WINLT = config->winlt;
+	ADC0.WINHT = config->winht;
+	ADC0.CTRLD = config->ctrld;
+	ADC0.COMMAND = config->command;
+
+	if(RTC.PER != config->rtc_period)
+	{
+		pending_rtc_period = config->rtc_period;
+		RTC.INTCTRL = RTC_OVF_bm; /* Enable overflow interrupt */
+	}
+}
+
+/**********************************************************************************
+ADC initialization
+**********************************************************************************/
+void adc_init()
+{
+	ADC0.CTRLA = ADC_ENABLE_bm;
+	ADC0.CTRLB = ADC_PRESC_DIV2_gc; /* fCLK_ADC = 3.333333/2 MHz */
+	ADC0.CTRLC = ADC_REFSEL_VDD_gc | (TIMEBASE_VALUE << ADC_TIMEBASE_gp);
+	ADC0.CTRLE = 17; /* (SAMPDUR + 0.5) * fCLK_ADC = 10.5 µs sample duration */
+	ADC0.INTCTRL = ADC_RESRDY_bm; /* Enable Result Ready interrupt */
+
+	requested_config.muxpos = ADC_MUXPOS_AIN6_gc; /* ADC channel AIN6 -> PA6 */
+	requested_config.muxneg = ADC_MUXNEG_AIN7_gc; /* ADC channel AIN7 -> PA7 */
+	/* Start ADC Burst conversion on event trigger */
+	requested_config.command = ADC_DIFF_bm | ADC_MODE_BURST_gc | ADC_START_EVENT_TRIGGER_gc;
+	requested_config.ctrlf = ADC_SAMPNUM_CONFIG;
+	requested_config.pgactrl = 0; /* PGA disabled */
+	/* Window comparator disabled, use RESULT register as source when enabled */
+	requested_config.ctrld = ADC_WINCM_NONE_gc | ADC_WINSRC_RESULT_gc;
+	requested_config.winlt = 0;
+	requested_config.winht = 0;
+	requested_config.rtc_period = RTC_PERIOD;
+
+	adc_apply_config(&requested_config);
+}
+
+/**********************************************************************************
+USART initialization
+**********************************************************************************/
+void usart_init()
+{
+	PORTB.DIRSET = PIN2_bm; /* Set TXD to output */
+	USART0.BAUD = BAUD_REG_VAL; /* Set baud rate */
+	USART0.CTRLA = USART_RXCIE_bm; /* Enable Receive Complete interrupt */
+	USART0.CTRLB = USART_TXEN_bm | USART_RXEN_bm; /* Enable USART transmitter and receiver */
+}
+
+/**********************************************************************************
+Queue a complete frame for transmission. The frame is either queued in full or
+dropped, so a full buffer never produces a partial frame on the line.
+Must be called with interrupts disabled.
+**********************************************************************************/
+static bool tx_queue_frame(uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+	uint8_t free_space = (tx_tail - tx_head - 1) & (TX_BUFFER_SIZE - 1);
+	uint8_t crc = 0;
+
+	if(free_space < len + 4)
+	{
+		stats.tx_dropped++;
+		return false;
+	}
+
+	tx_buffer[tx_head] = FRAME_SYNC;
+	tx_head = (tx_head + 1) & (TX_BUFFER_SIZE - 1);
+	tx_buffer[tx_head] = cmd;
+	tx_head = (tx_head + 1) & (TX_BUFFER_SIZE - 1);
+	crc = _crc8_ccitt_update(crc, cmd);
+	tx_buffer[tx_head] = len;
+	tx_head = (tx_head + 1) & (TX_BUFFER_SIZE - 1);
+	crc = _crc8_ccitt_update(crc, len);
+
+	for(uint8_t i = 0; i < len; i++)
+	{
+		tx_buffer[tx_head] = payload[i];
+		tx_head = (tx_head + 1) & (TX_BUFFER_SIZE - 1);
+		crc = _crc8_ccitt_update(crc, payload[i]);
+	}
+
+	tx_buffer[tx_head] = crc;
+	tx_head = (tx_head + 1) & (TX_BUFFER_SIZE - 1);
+
+	USART0.CTRLA |= USART_DREIE_bm; /* Start transmission from the Data Register Empty interrupt */
+	return true;
+}
+
+/***********************************************************************************
+Result Ready interrupt:
+The ADC is idle until the next RTC event, so this is where a new configuration
+is applied. That way a configuration change never corrupts a burst in progress,
+and the next event trigger already uses the new settings.
+***********************************************************************************/
+ISR(ADC0_RESRDY_vect)
+{
+	static uint8_t sequence;
+	uint8_t frame[6];
+	int32_t result = ADC0.RESULT; /* Read accumulated ADC result, clears the interrupt flag */
+
+	frame[5] = 0;
+	if(ADC0.INTFLAGS & ADC_WCMP_bm)
+	{
+		ADC0.INTFLAGS = ADC_WCMP_bm; /* Clear WCMP flag */
+		frame[5] = STREAM_FLAG_WCMP;
+	}
+
+	if(config_pending)
+	{
+		adc_apply_config(&pending_config);
+		config_pending = false;
+		stats.configs_applied++;
+	}
+
+	adc_reading = result;
+	stats.conversions++;
+
+	if(streaming)
+	{
+		frame[0] = sequence++;
+		frame[1] = (uint8_t) result;
+		frame[2] = (uint8_t) (result >> 8);
+		frame[3] = (uint8_t) (result >> 16);
+		frame[4] = (uint8_t) (result >> 24);
+		tx_queue_frame(CMD_STREAM_DATA, frame, sizeof(frame));
+	}
+}
+
+/***********************************************************************************
+RTC Overflow interrupt:
+Writes a new period right after the counter wrapped to 0. If PER was written
+while CNT is already past the new value, the counter would run to 0xFFFF
+before the next overflow, a gap of 2 s. RTC_PERIOD_MIN is longer than the
+interrupt latency and the PER synchronization together, and a write that is
+still busy is retried at the next overflow, so the interrupt never waits.
+***********************************************************************************/
+ISR(RTC_CNT_vect)
+{
+	RTC.INTFLAGS = RTC_OVF_bm; /* Clear interrupt flag */
+
+	if(!(RTC.STATUS & RTC_PERBUSY_bm))
+	{
+		RTC.PER = pending_rtc_period;
+		RTC.INTCTRL = 0; /* Disable overflow interrupt until the next change */
+	}
+}
+
+/***********************************************************************************
+Receive Complete interrupt:
+Only buffers the byte. Frames are parsed in main() to keep the interrupt short.
+***********************************************************************************/
+ISR(USART0_RXC_vect)
+{
+	uint8_t data = USART0.RXDATAL;
+	uint8_t next = (rx_head + 1) & (RX_BUFFER_SIZE - 1);
+
+	if(next != rx_tail)
+	{
+		rx_buffer[rx_head] = data;
+		rx_head = next;
+	}
+	else
+	{
+		stats.rx_errors++; /* Receive buffer overflow */
+	}
+}
+
+/***********************************************************************************
+Data Register Empty interrupt:
+Sends the next queued byte, and disables itself when the buffer is empty.
+***********************************************************************************/
+ISR(USART0_DRE_vect)
+{
+	if(tx_head != tx_tail)
+	{
+		USART0.TXDATAL = tx_buffer[tx_tail];
+		tx_tail = (tx_tail + 1) & (TX_BUFFER_SIZE - 1);
+	}
+	else
+	{
+		USART0.CTRLA &= ~USART_DREIE_bm;
+	}
+}
+
+/**********************************************************************************
+Hand the requested configuration over to the Result Ready interrupt. If a
+previous configuration has not been applied yet, it is replaced, so the ADC
+always moves directly to the latest requested state.
+**********************************************************************************/
+static void config_request_apply(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		pending_config = requested_config;
+		config_pending = true;
+	}
+}
+
+static void send_response(uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		tx_queue_frame(cmd | FRAME_RESPONSE_bm, payload, len);
+	}
+}
+
+/**********************************************************************************
+Execute a received command and return the response status
+**********************************************************************************/
+static uint8_t command_execute(uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+	uint16_t value;
+
+	switch(cmd)
+	{
+	case CMD_SET_MUX:
+		if(len != 3) return STATUS_BAD_LENGTH;
+		if(payload[2] > 1) return STATUS_BAD_VALUE;
+		requested_config.muxpos = payload[0];
+		requested_config.muxneg = payload[1];
+		requested_config.command = (payload[2] ? ADC_DIFF_bm : 0) | ADC_MODE_BURST_gc | ADC_START_EVENT_TRIGGER_gc;
+		break;
+
+	case CMD_SET_SAMPNUM:
+		if(len != 1) return STATUS_BAD_LENGTH;
+		if(payload[0] > ADC_SAMPNUM_ACC1024_gc) return STATUS_BAD_VALUE;
+		requested_config.ctrlf = payload[0];
+		break;
+
+	case CMD_SET_PGA:
+		if(len != 1) return STATUS_BAD_LENGTH;
+		/* GAIN above 16X and ADCPGASAMPDUR 3 are reserved, all four PGABIASSEL values are valid */
+		if((payload[0] & ADC_GAIN_gm) > ADC_GAIN_16X_gc) return STATUS_BAD_VALUE;
+		if((payload[0] & ADC_ADCPGASAMPDUR_gm) > ADC_ADCPGASAMPDUR_20CLK_gc) return STATUS_BAD_VALUE;
+		requested_config.pgactrl = payload[0];
+		break;
+
+	case CMD_SET_WINDOW:
+		if(len != 5) return STATUS_BAD_LENGTH;
+		if(payload[0] > ADC_WINCM_OUTSIDE_gc) return STATUS_BAD_VALUE;
+		requested_config.ctrld = payload[0] | ADC_WINSRC_RESULT_gc;
+		requested_config.winlt = payload[1] | (payload[2] << 8);
+		requested_config.winht = payload[3] | (payload[4] << 8);
+		break;
+
+	case CMD_SET_FREQ:
+		if(len != 2) return STATUS_BAD_LENGTH;
+		value = payload[0] | (payload[1] << 8);
+		if((value == 0) || (RTC_CLOCK / value < RTC_PERIOD_MIN)) return STATUS_BAD_VALUE;
+		requested_config.rtc_period = RTC_CLOCK / value;
+		break;
+
+	case CMD_STREAM_START:
+		if(len != 0) return STATUS_BAD_LENGTH;
+		streaming = true;
+		return STATUS_OK;
+
+	case CMD_STREAM_STOP:
+		if(len != 0) return STATUS_BAD_LENGTH;
+		streaming = false;
+		return STATUS_OK;
+
+	default:
+		return STATUS_UNKNOWN_CMD;
+	}
+
+	config_request_apply();
+	return STATUS_OK;
+}
+
+static void send_stats(void)
+{
+	adc_stats_t snapshot;
+	uint8_t payload[10];
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		snapshot = stats;
+	}
+
+	payload[0] = (uint8_t) snapshot.conversions;
+	payload[1] = (uint8_t) (snapshot.conversions >> 8);
+	payload[2] = (uint8_t) (snapshot.conversions >> 16);
+	payload[3] = (uint8_t) (snapshot.conversions >> 24);
+	payload[4] = (uint8_t) snapshot.tx_dropped;
+	payload[5] = (uint8_t) (snapshot.tx_dropped >> 8);
+	payload[6] = (uint8_t) snapshot.rx_errors;
+	payload[7] = (uint8_t) (snapshot.rx_errors >> 8);
+	payload[8] = (uint8_t) snapshot.configs_applied;
+	payload[9] = (uint8_t) (snapshot.configs_applied >> 8);
+
+	send_response(CMD_GET_STATS, payload, sizeof(payload));
+}
+
+/**********************************************************************************
+Feed one received byte to the frame parser
+**********************************************************************************/
+static void command_parse_byte(uint8_t data)
+{
+	static parser_state_t state = PARSER_SYNC;
+	static uint8_t cmd;
+	static uint8_t len;
+	static uint8_t index;
+	static uint8_t crc;
+	static uint8_t payload[FRAME_MAX_PAYLOAD];
+	uint8_t status;
+
+	switch(state)
+	{
+	case PARSER_SYNC:
+		if(data == FRAME_SYNC)
+		{
+			crc = 0;
+			state = PARSER_CMD;
+		}
+		break;
+
+	case PARSER_CMD:
+		cmd = data;
+		crc = _crc8_ccitt_update(crc, data);
+		state = PARSER_LEN;
+		break;
+
+	case PARSER_LEN:
+		len = data;
+		index = 0;
+		crc = _crc8_ccitt_update(crc, data);
+		if(len > FRAME_MAX_PAYLOAD)
+		{
+			ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+			{
+				stats.rx_errors++;
+			}
+			state = PARSER_SYNC;
+		}
+		else
+		{
+			state = (len > 0) ? PARSER_PAYLOAD : PARSER_CRC;
+		}
+		break;
+
+	case PARSER_PAYLOAD:
+		payload[index++] = data;
+		crc = _crc8_ccitt_update(crc, data);
+		if(index == len)
+		{
+			state = PARSER_CRC;
+		}
+		break;
+
+	case PARSER_CRC:
+		state = PARSER_SYNC;
+		if(data != crc)
+		{
+			ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+			{
+				stats.rx_errors++;
+			}
+			break;
+		}
+
+		if(cmd == CMD_GET_STATS)
+		{
+			send_stats();
+		}
+		else
+		{
+			status = command_execute(cmd, payload, len);
+			send_response(cmd, &status, 1);
+		}
+		break;
+	}
+}
+
+int main(void)
+{
+	event_system_init();
+	rtc_init();
+	adc_init();
+	usart_init();
+	sei(); /* Enable global interrupts */
+
+	while(1)
+	{
+		/* Parse all received bytes, the ADC keeps streaming in the background */
+		while(rx_tail != rx_head)
+		{
+			command_parse_byte(rx_buffer[rx_tail]);
+			rx_tail = (rx_tail + 1) & (RX_BUFFER_SIZE - 1);
+		}
+	}
+}
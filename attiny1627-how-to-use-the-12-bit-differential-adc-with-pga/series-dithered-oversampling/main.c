@@ -0,0 +1,193 @@
+/*
+    \file   main.c
+
+    \brief  How To Use the 12-Bit Differential ADC in Series Accumulation Mode
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+
+/*
+ *
+ * How To Use the 12-Bit Differential ADC in Series Accumulation Mode:
+ * Dithered Oversampling
+ *
+ */
+
+#define F_CPU 3333333ul
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <math.h>
+
+#define TIMEBASE_VALUE          ((uint8_t) ceil(F_CPU*0.000001))
+
+/* Defines to configure ADC accumulation */
+#define OVERSAMPLING_BITS       5 /* 5 bits extra */
+#define OVERSAMPLING_MAX_VALUE  ((uint32_t) ((1 << 12) - 1) << OVERSAMPLING_BITS) /* 12 + 5 bits = 17 bits */
+#define ADC_SAMPNUM_CONFIG      (OVERSAMPLING_BITS << 1) /* The SAMPNUM bit field setting match this formula */
+#define ADC_SAMPLES             (1 << ADC_SAMPNUM_CONFIG) /* 5 bits = 1024 samples */
+
+/* Defines to easily configure TCA0 event frequency */
+#define ADC_SAMPLING_FREQ       10000   /* Hz */
+#define TCA_PERIOD              ((F_CPU / ADC_SAMPLING_FREQ) - 1)
+
+/* Set to 0 to keep the dither pins low, to compare the result with and without dither */
+#define DITHER_ENABLE           1
+
+/*
+ * The dither is added by a 4-bit resistor DAC on PC0-PC3, summed with the signal
+ * at PA6. The pins are always driven, so the total conductance at PA6 is constant
+ * and the voltage at PA6 is a weighted sum of the signal and the pins:
+ *     V(PA6) = SIGNAL_GAIN * V(signal) + sum(DITHER_WEIGHT(bit) * VDD * bit)
+ */
+#define R_SOURCE                100.0       /* Ohm, signal -> PA6 */
+#define R_DITHER_0              3300000.0   /* Ohm, PC0 -> PA6 */
+#define R_DITHER_1              1600000.0   /* Ohm, PC1 -> PA6 */
+#define R_DITHER_2              820000.0    /* Ohm, PC2 -> PA6 */
+#define R_DITHER_3              390000.0    /* Ohm, PC3 -> PA6 */
+#define G_DITHER                (1 / R_DITHER_0 + 1 / R_DITHER_1 + 1 / R_DITHER_2 + 1 / R_DITHER_3)
+#define G_TOTAL                 (1 / R_SOURCE + G_DITHER)
+#define SIGNAL_GAIN             ((1 / R_SOURCE) / G_TOTAL)
+
+#define DITHER_PINS             (PIN0_bm | PIN1_bm | PIN2_bm | PIN3_bm)
+#define DITHER_LEVELS           16
+
+#if DITHER_ENABLE
+/* Every dither level is used equally often, so each pin is high for half of the
+samples. The sum of the dither over one accumulation, in ADC codes, is known.
+It is calculated from the nominal resistor values, and is proportional to
+G_DITHER / G_TOTAL, which is about G_DITHER * R_SOURCE. With resistors of
+tolerance t, the real sum differs by up to 2 * t * DITHER_SUM. This is an offset
+that is not removed: with 1% resistors, up to 20 codes, 0.6 LSB of the 17-bit
+result or 15 uV. Measure a known input once and correct the offset if it matters. */
+#define DITHER_SUM              ((uint32_t) ((ADC_SAMPLES / 2) * 4096.0 * (G_DITHER / G_TOTAL) + 0.5))
+_Static_assert(ADC_SAMPLES % DITHER_LEVELS == 0, "Every dither level must be used equally often");
+#else
+#define DITHER_SUM              0
+#endif
+
+/* Dither levels in bit-reversed order: every group of 2, 4 or 8 samples spans the
+full dither range, so a slowly changing signal sees the same dither as a steady one */
+static const uint8_t dither_sequence[DITHER_LEVELS] =
+{
+	0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15
+};
+
+/* Volatile variables to improve debug experience */
+static volatile uint32_t adc_reading;
+static volatile float voltage;
+
+/******************************************************************************
+EVSYS initialization:
+Channel 0:
+            Event system generator: TCA0 Overflow
+            Event system user: ADC0
+*******************************************************************************/
+void event_system_init(void)
+{
+	EVSYS.CHANNEL0 = EVSYS_CHANNEL0_TCA0_OVF_LUNF_gc;   /* TCA0 Overflow    ->  Channel 0 */
+	EVSYS.USERADC0START = EVSYS_USER_CHANNEL0_gc;       /* Channel 0        ->  ADC0 Start */
+}
+
+/*********************************************************************************
+TCA0 initialization: Overflow event at ADC_SAMPLING_FREQ
+**********************************************************************************/
+void tca_init(void)
+{
+	TCA0.SINGLE.PER = TCA_PERIOD;
+	TCA0.SINGLE.CTRLA = TCA_SINGLE_CLKSEL_DIV1_gc | TCA_SINGLE_ENABLE_bm;
+}
+
+/*********************************************************************************
+Dither DAC initialization: PC0-PC3 as outputs, starting at the first level
+**********************************************************************************/
+void dither_init(void)
+{
+	PORTC.OUTCLR = DITHER_PINS;
+	PORTC.DIRSET = DITHER_PINS;
+#if DITHER_ENABLE
+	PORTC.OUTSET = dither_sequence[0];
+#endif
+}
+
+/*********************************************************************************
+ADC initialization
+**********************************************************************************/
+void adc_init()
+{
+	ADC0.CTRLA = ADC_ENABLE_bm;
+	ADC0.CTRLB = ADC_PRESC_DIV2_gc; /* fCLK_ADC = 3.333333/2 MHz */
+	ADC0.CTRLC = ADC_REFSEL_VDD_gc | (TIMEBASE_VALUE << ADC_TIMEBASE_gp);
+	ADC0.CTRLE = 17; /* (SAMPDUR + 0.5) * fCLK_ADC = 10.5 µs sample duration */
+	ADC0.CTRLF = ADC_SAMPNUM_CONFIG;
+#if DITHER_ENABLE
+	ADC0.INTCTRL = ADC_SAMPRDY_bm; /* Enable Sample Ready interrupt */
+#endif
+
+	ADC0.MUXPOS = ADC_MUXPOS_AIN6_gc; /* ADC channel AIN6 -> PA6 */
+	/* Start ADC Series conversion on event trigger */
+	ADC0.COMMAND = ADC_MODE_SERIES_gc | ADC_START_EVENT_TRIGGER_gc;
+}
+
+#if DITHER_ENABLE
+/***********************************************************************************
+Sample Ready interrupt:
+Sets the next dither level. The DAC output settles before the next conversion is
+triggered by TCA0.
+***********************************************************************************/
+ISR(ADC0_SAMPRDY_vect)
+{
+	static uint8_t index;
+
+	ADC0.INTFLAGS = ADC_SAMPRDY_bm; /* Clear SAMPRDY flag */
+
+	index = (index + 1) % DITHER_LEVELS;
+	VPORTC.OUT = (VPORTC.OUT & ~DITHER_PINS) | dither_sequence[index];
+}
+#endif
+
+int main(void)
+{
+	event_system_init();
+	dither_init();
+	tca_init();
+	adc_init();
+	sei(); /* Enable global interrupts */
+
+	while(1)
+	{
+		if(ADC0.INTFLAGS & ADC_RESRDY_bm)  /* Check if the accumulation is done */
+		{
+			/* Read accumulated ADC result, clears the interrupt flag */
+			uint32_t result = ADC0.RESULT;
+
+			/* The dither is known, so its sum is subtracted from the accumulated result */
+			result = (result > DITHER_SUM) ? result - DITHER_SUM : 0;
+
+			/* Oversampling compensation as explained in the tech brief */
+			adc_reading = result >> OVERSAMPLING_BITS; /* Scale accumulated result by right shifting the number of extra bits */
+			/* Calculate the signal voltage using 17-bit resolution, VDD = 3.3V. The resistor DAC attenuates the signal slightly. */
+			voltage = (float)((adc_reading * 3.3) / OVERSAMPLING_MAX_VALUE) / SIGNAL_GAIN;
+		}
+	}
+}
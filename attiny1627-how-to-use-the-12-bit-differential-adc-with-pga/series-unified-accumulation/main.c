@@ -0,0 +1,287 @@
+/*
+    \file   main.c
+
+    \brief  How To Use the 12-Bit Differential ADC in Series and Burst Accumulation Mode
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+
+/*
+ *
+ * How To Use the 12-Bit Differential ADC in Series and Burst Accumulation Mode:
+ * Unified Accumulation
+ *
+ */
+
+#define F_CPU 3333333ul
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdbool.h>
+#include <math.h>
+#include <util/delay.h>
+
+#define TIMEBASE_VALUE      ((uint8_t) ceil(F_CPU*0.000001))
+
+/******************************************************************************
+Acquisition configuration:
+ACQ_MODE        ACQ_SERIES: one sample per start, the result is ready after
+                2^ACQ_SAMPNUM starts. ACQ_BURST: all samples on one start.
+ACQ_SAMPNUM     0 - 10, 2^ACQ_SAMPNUM samples are accumulated
+ACQ_SCALING     1: the result is the 16-bit scaled mean of the samples
+ACQ_LEFTADJ     1: left adjust a scaled result of less than 16 samples to 16 bits
+ACQ_DIFF        1: differential AIN6 - AIN7 through the PGA, 0: AIN6 single-ended
+ACQ_WINDOW      1: restart the accumulation when a sample is outside the window
+                from ACQ_WINDOW_LOW to ACQ_WINDOW_HIGH
+ACQ_PERIOD_MS   Time between starts
+Every choice is made by the preprocessor, so only the code of the selected
+combination is compiled, with the same register accesses as the hand-written
+Series and Burst examples. The defines can also be given on the compiler
+command line, e.g. -DACQ_MODE=ACQ_BURST.
+*******************************************************************************/
+#define ACQ_SERIES          0
+#define ACQ_BURST           1
+
+#ifndef ACQ_MODE
+#define ACQ_MODE            ACQ_SERIES
+#endif
+#ifndef ACQ_SAMPNUM
+#define ACQ_SAMPNUM         8
+#endif
+#ifndef ACQ_SCALING
+#define ACQ_SCALING         0
+#endif
+#ifndef ACQ_LEFTADJ
+#define ACQ_LEFTADJ         0
+#endif
+#ifndef ACQ_DIFF
+#define ACQ_DIFF            0
+#endif
+#ifndef ACQ_WINDOW
+#define ACQ_WINDOW          0
+#endif
+#ifndef ACQ_PERIOD_MS
+#define ACQ_PERIOD_MS       1
+#endif
+
+/* Command and CTRLF values of the selected combination */
+#if ACQ_MODE == ACQ_SERIES && ACQ_SCALING
+#define ACQ_COMMAND_MODE    ADC_MODE_SERIES_SCALING_gc
+#elif ACQ_MODE == ACQ_SERIES
+#define ACQ_COMMAND_MODE    ADC_MODE_SERIES_gc
+#elif ACQ_SCALING
+#define ACQ_COMMAND_MODE    ADC_MODE_BURST_SCALING_gc
+#else
+#define ACQ_COMMAND_MODE    ADC_MODE_BURST_gc
+#endif
+
+/* The window compares the signed samples in differential mode, so it is centered on 0 there */
+#if ACQ_DIFF
+#define ACQ_COMMAND         (ADC_DIFF_bm | ACQ_COMMAND_MODE)
+#define ACQ_SAMPLE_MAX      (((1 << 12) / 2) - 1)   /* In differential mode, the max value is 2047 */
+#define ACQ_VREF            1.024                   /* V */
+#define ACQ_GAIN            16
+#define ACQ_WINDOW_LOW      (-ACQ_SAMPLE_MAX / 2)   /* -32 mV at the PGA input */
+#define ACQ_WINDOW_HIGH     (ACQ_SAMPLE_MAX / 2)    /* +32 mV at the PGA input */
+#else
+#define ACQ_COMMAND         ACQ_COMMAND_MODE
+#define ACQ_SAMPLE_MAX      ((1 << 12) - 1)         /* In single-ended mode, the max value is 4095 */
+#define ACQ_VREF            3.3                     /* V, VDD */
+#define ACQ_GAIN            1
+#define ACQ_WINDOW_LOW      2000                    /* As in the hand-written Window Comparator examples */
+#define ACQ_WINDOW_HIGH     3000
+#endif
+
+#if ACQ_LEFTADJ
+#define ACQ_CTRLF           (ADC_LEFTADJ_bm | ACQ_SAMPNUM)
+#else
+#define ACQ_CTRLF           ACQ_SAMPNUM
+#endif
+
+/* Width of RESULT: the sum of the samples, or the 16-bit scaled mean */
+#if ACQ_SCALING && (ACQ_SAMPNUM >= 4 || ACQ_LEFTADJ)
+#define ACQ_RESULT_BITS     16
+#else
+#define ACQ_RESULT_BITS     (12 + ACQ_SAMPNUM)
+#endif
+
+/* Smallest type that holds RESULT, signed in differential mode */
+#if ACQ_RESULT_BITS <= 16 && ACQ_DIFF
+typedef int16_t acq_result_t;
+#elif ACQ_RESULT_BITS <= 16
+typedef uint16_t acq_result_t;
+#elif ACQ_DIFF
+typedef int32_t acq_result_t;
+#else
+typedef uint32_t acq_result_t;
+#endif
+
+/* RESULT value for a full-scale input */
+#define ACQ_FULL_SCALE      ((uint32_t) ACQ_SAMPLE_MAX << (ACQ_RESULT_BITS - 12))
+
+_Static_assert(ACQ_MODE == ACQ_SERIES || ACQ_MODE == ACQ_BURST, "ACQ_MODE must be ACQ_SERIES or ACQ_BURST");
+_Static_assert(ACQ_SAMPNUM >= 0 && ACQ_SAMPNUM <= 10, "At most 1024 samples can be accumulated");
+_Static_assert(!ACQ_LEFTADJ || ACQ_SCALING, "ACQ_LEFTADJ is only used with ACQ_SCALING");
+_Static_assert((ACQ_DIFF ? -ACQ_SAMPLE_MAX - 1 : 0) <= ACQ_WINDOW_LOW && ACQ_WINDOW_LOW < ACQ_WINDOW_HIGH &&
+               ACQ_WINDOW_HIGH <= ACQ_SAMPLE_MAX, "The window must lie in the range of the samples");
+_Static_assert(ACQ_RESULT_BITS <= 8 * sizeof(acq_result_t), "RESULT does not fit in acq_result_t");
+_Static_assert(ACQ_FULL_SCALE <= (ACQ_DIFF ? INT32_MAX : UINT32_MAX), "The full-scale RESULT overflows 32 bits");
+
+/* Volatile variables to improve debug experience */
+static volatile acq_result_t adc_reading;
+static volatile float voltage;
+
+/*********************************************************************************
+ADC initialization
+**********************************************************************************/
+void adc_init()
+{
+	ADC0.CTRLA = ADC_ENABLE_bm;
+	ADC0.CTRLB = ADC_PRESC_DIV2_gc; /* fCLK_ADC = 3.333333/2 MHz */
+#if ACQ_DIFF
+	ADC0.CTRLC = ADC_REFSEL_1024MV_gc | (TIMEBASE_VALUE << ADC_TIMEBASE_gp);
+#else
+	ADC0.CTRLC = ADC_REFSEL_VDD_gc | (TIMEBASE_VALUE << ADC_TIMEBASE_gp);
+#endif
+	ADC0.CTRLE = 17; /* (SAMPDUR + 0.5) * fCLK_ADC = 10.5 µs sample duration */
+	ADC0.CTRLF = ACQ_CTRLF;
+
+#if ACQ_DIFF
+	ADC0.MUXPOS = ADC_VIA_PGA_gc | ADC_MUXPOS_AIN6_gc; /* ADC channel AIN6 -> PA6 */
+	ADC0.MUXNEG = ADC_VIA_PGA_gc | ADC_MUXNEG_AIN7_gc; /* ADC channel AIN7 -> PA7 */
+	/* Enable PGA with 16x gain.
+	Set full bias current for fast sampling. Configure ADCPGASAMPDUR according to data sheet. */
+	ADC0.PGACTRL = ADC_GAIN_16X_gc | ADC_PGABIASSEL_1X_gc | ADC_ADCPGASAMPDUR_6CLK_gc | ADC_PGAEN_bm;
+#else
+	ADC0.MUXPOS = ADC_MUXPOS_AIN6_gc; /* ADC channel AIN6 -> PA6 */
+#endif
+
+#if ACQ_WINDOW
+	ADC0.WINHT = ACQ_WINDOW_HIGH; /* Window High Threshold */
+	ADC0.WINLT = ACQ_WINDOW_LOW; /* Window Low Threshold, two's complement in differential mode */
+	/* Window Comparator mode: Outside. Use SAMPLE register as Window Comparator source */
+	ADC0.CTRLD = ADC_WINCM_OUTSIDE_gc | ADC_WINSRC_SAMPLE_gc;
+	/* Enable Window Compare and Result Ready interrupt */
+	ADC0.INTCTRL = ADC_WCMP_bm | ADC_RESRDY_bm;
+#endif
+
+	ADC0.COMMAND = ACQ_COMMAND;
+}
+
+/*********************************************************************************
+Voltage of a result: the scaled result or the sum of the samples, divided by
+its full-scale value, VREF and the gain
+**********************************************************************************/
+static inline float acq_voltage(acq_result_t result)
+{
+	return (float)result * ACQ_VREF / ACQ_FULL_SCALE / ACQ_GAIN;
+}
+
+#if ACQ_WINDOW
+/***********************************************************************************
+Window Compare interrupt:
+A sample outside the window is considered an invalid signal spike, and the
+accumulated ADC result is disregarded by restarting the accumulation.
+***********************************************************************************/
+ISR(ADC0_SAMPRDY_vect)
+{
+	ADC0.INTFLAGS = ADC_WCMP_bm;        /* Clear WCMP flag */
+
+#if ACQ_MODE == ACQ_SERIES
+	/* Clear the accumulator by resetting the Mode bit field */
+	ADC0.COMMAND = ADC_START_STOP_gc;
+	/* Reconfigure Series Accumulation mode */
+	ADC0.COMMAND = ACQ_COMMAND;
+#else
+	/* Stop the ongoing burst */
+	ADC0.COMMAND = ADC_START_STOP_gc;
+	/* Start a new burst accumulation */
+	ADC0.COMMAND = ACQ_COMMAND | ADC_START_IMMEDIATE_gc;
+#endif
+}
+
+/***********************************************************************************
+Result Ready interrupt:
+If no spike was detected, the result is read and the corresponding
+voltage is calculated
+***********************************************************************************/
+ISR(ADC0_RESRDY_vect)
+{
+	ADC0.INTFLAGS = ADC_RESRDY_bm;      /* Clear RESRDY flag */
+
+	/* Check if the last sample was inside the window */
+	if(!(ADC0.INTFLAGS & ADC_WCMP_bm))
+	{
+		adc_reading = (acq_result_t)ADC0.RESULT; /* Read ADC result */
+		voltage = acq_voltage(adc_reading);
+	}
+}
+
+#else
+/*********************************************************************************
+Acquisition:
+Starts a conversion, and returns true with the result when the accumulation is
+complete. In Series mode, this takes 2^ACQ_SAMPNUM calls.
+**********************************************************************************/
+static inline bool acq_poll(acq_result_t *result)
+{
+	ADC0.COMMAND |= ADC_START_IMMEDIATE_gc;
+#if ACQ_MODE == ACQ_SERIES
+	while(!(ADC0.INTFLAGS & ADC_SAMPRDY_bm)); /* Wait until conversion is done */
+	ADC0.INTFLAGS = ADC_SAMPRDY_bm; /* Clear Sample Ready interrupt flag */
+
+	if(!(ADC0.INTFLAGS & ADC_RESRDY_bm)) /* If result is not ready */
+	{
+		return false;
+	}
+#else
+	while(!(ADC0.INTFLAGS & ADC_RESRDY_bm)); /* Wait until conversion is done */
+#endif
+	*result = (acq_result_t)ADC0.RESULT; /* Read ADC result, clears flag */
+	return true;
+}
+#endif
+
+int main(void)
+{
+	adc_init();
+#if ACQ_WINDOW
+	sei(); /* Enable global interrupts */
+#endif
+
+	while(1)
+	{
+#if ACQ_WINDOW
+		ADC0.COMMAND |= ADC_START_IMMEDIATE_gc;
+#else
+		acq_result_t result;
+
+		if(acq_poll(&result))
+		{
+			adc_reading = result;
+			voltage = acq_voltage(result);
+		}
+#endif
+		_delay_ms(ACQ_PERIOD_MS);
+	}
+}
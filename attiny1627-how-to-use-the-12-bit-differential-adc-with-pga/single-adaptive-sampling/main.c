@@ -0,0 +1,219 @@
+/*
+    \file   main.c
+
+    \brief  How To Use the 12-Bit Differential ADC in Single Mode
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+
+/*
+ *
+ * How To Use the 12-Bit Differential ADC in Single Mode:
+ * Adaptive Sampling Rate
+ *
+ */
+
+#define F_CPU 3333333ul
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define TIMEBASE_VALUE      ((uint8_t) ceil(F_CPU*0.000001))
+#define ADC_MAX_VALUE       ((1 << 12) - 1) /* In single-ended mode, the max value is 4095 */
+
+/* Defines to easily configure the RTC event frequency range */
+#define RTC_CLOCK           32768   /* Hz */
+#define ADC_FAST_FREQ       1024    /* Hz, used while the signal changes */
+#define ADC_IDLE_FREQ       10      /* Hz, used while the signal is flat */
+#define RTC_PERIOD_FAST     (RTC_CLOCK / ADC_FAST_FREQ)   /* RTC clock cycles, RTC.PER is one less */
+#define RTC_PERIOD_IDLE     (RTC_CLOCK / ADC_IDLE_FREQ)
+
+/* The rate goes to ADC_FAST_FREQ when the signal changes faster than this */
+#define SLOPE_THRESHOLD     2000UL  /* LSB per second */
+/* Changes up to this are noise. At the fast rate, SLOPE_THRESHOLD is only 2 LSB
+   between two results, so without it the noise would keep the rate fast. */
+#define DELTA_NOISE_LSB     8
+/* Number of fast conversions without activity before the rate starts to decay */
+#define FAST_HOLD_COUNT     64
+/* The period is increased by 1/2^PERIOD_DECAY_SHIFT for every quiet conversion */
+#define PERIOD_DECAY_SHIFT  3
+
+typedef struct
+{
+	uint32_t conversions;
+	uint32_t rtc_ticks;     /* Sum of the periods, in RTC clock cycles */
+	uint16_t transients;    /* Number of times the fast rate was entered */
+} adaptive_stats_t;
+
+static volatile adaptive_stats_t stats;
+
+/* Volatile variables to improve debug experience */
+static volatile uint16_t adc_reading;
+static volatile uint16_t rtc_period = RTC_PERIOD_IDLE; /* The period written to the RTC */
+static volatile float voltage;
+static volatile float average_rate;
+
+/******************************************************************************
+EVSYS initialization:
+Channel 0:
+            Event system generator: RTC Overflow
+            Event system user: ADC0
+Channel 1:
+            Event system generator: ADC0 Result Ready
+            Event system user: EVOUTB (PIN PB2)
+*******************************************************************************/
+void event_system_init(void)
+{
+	PORTB.DIRSET = PIN2_bm; /* Configure EVOUTB to output */
+
+	EVSYS.CHANNEL0 = EVSYS_CHANNEL0_RTC_OVF_gc;     /* RTC Overflow ->  Channel 0 */
+	EVSYS.USERADC0START = EVSYS_USER_CHANNEL0_gc;   /* Channel 0    ->  ADC0 Start */
+
+	EVSYS.CHANNEL1 = EVSYS_CHANNEL1_ADC0_RES_gc;    /* ADC RESRDY   ->  Channel 1 */
+	EVSYS.USEREVSYSEVOUTB = EVSYS_USER_CHANNEL1_gc; /* Channel 1    ->  EVOUTB (PB2) */
+}
+
+/*********************************************************************************
+RTC initialization
+**********************************************************************************/
+void rtc_init(void)
+{
+	while(RTC.STATUS > 0);  /* Wait for all registers to be synchronized */
+	RTC.CTRLA = RTC_PRESCALER_DIV1_gc | RTC_RTCEN_bm; /* Enable RTC, no prescaler */
+	RTC.CLKSEL = RTC_CLKSEL_INT32K_gc; /* Select 32.768 kHz internal RC oscillator */
+	RTC.PER = RTC_PERIOD_IDLE - 1; /* The RTC overflows every PER + 1 cycles */
+	while(RTC.STATUS > 0);  /* Wait for all registers to be synchronized */
+}
+
+/**********************************************************************************
+ADC initialization
+**********************************************************************************/
+void adc_init()
+{
+	ADC0.CTRLA = ADC_ENABLE_bm;
+	ADC0.CTRLB = ADC_PRESC_DIV2_gc; /* fCLK_ADC = 3.333333/2 MHz */
+	ADC0.CTRLC = ADC_REFSEL_VDD_gc | (TIMEBASE_VALUE << ADC_TIMEBASE_gp);
+	ADC0.CTRLE = 17; /* (SAMPDUR + 0.5) * fCLK_ADC = 10.5 µs sample duration */
+
+	ADC0.MUXPOS = ADC_MUXPOS_AIN6_gc; /* ADC channel AIN6 -> PA6 */
+
+	ADC0.WINHT = 3000; /* Window High Threshold */
+	ADC0.WINLT = 2000; /* Window Low Threshold */
+	/* Window Comparator mode: Outside. Use RESULT register as Window Comparator source */
+	ADC0.CTRLD = ADC_WINCM_OUTSIDE_gc | ADC_WINSRC_RESULT_gc;
+	ADC0.INTCTRL = ADC_RESRDY_bm; /* Enable Result Ready interrupt */
+
+	/* Start ADC conversion on event trigger */
+	ADC0.COMMAND = ADC_MODE_SINGLE_12BIT_gc | ADC_START_EVENT_TRIGGER_gc;
+}
+
+/***********************************************************************************
+Result Ready interrupt:
+The slope since the previous result is compared to SLOPE_THRESHOLD without any
+division, by scaling both sides with the period, and changes up to
+DELTA_NOISE_LSB are ignored. When the signal changes fast, or
+the result is outside the window, the rate goes to ADC_FAST_FREQ immediately.
+After FAST_HOLD_COUNT quiet conversions, the period grows by 1/8 per conversion
+until the idle rate is reached.
+
+The new period is written right after a conversion, i.e. right after an RTC
+overflow, so the counter is always below the new period and no period is
+stretched or cut short. If the previous write to PER is still being
+synchronized, the write is skipped and retried after the next conversion,
+instead of waiting in the interrupt.
+***********************************************************************************/
+ISR(ADC0_RESRDY_vect)
+{
+	static uint16_t previous;
+	static uint8_t hold;
+	static uint16_t period = RTC_PERIOD_IDLE; /* The period to write to the RTC */
+	uint16_t result = ADC0.RESULT; /* Read ADC result, clears the interrupt flag */
+	uint16_t elapsed = rtc_period;
+	uint16_t delta = abs((int16_t) (result - previous));
+	uint8_t outside_window = ADC0.INTFLAGS & ADC_WCMP_bm;
+
+	ADC0.INTFLAGS = ADC_WCMP_bm; /* Clear WCMP flag */
+	previous = result;
+	adc_reading = result;
+
+	stats.conversions++;
+	stats.rtc_ticks += elapsed;
+
+	if(outside_window || ((delta > DELTA_NOISE_LSB) && ((uint32_t) delta * RTC_CLOCK > SLOPE_THRESHOLD * elapsed)))
+	{
+		if(period != RTC_PERIOD_FAST)
+		{
+			stats.transients++;
+		}
+		period = RTC_PERIOD_FAST;
+		hold = FAST_HOLD_COUNT;
+	}
+	else if(hold > 0)
+	{
+		hold--;
+	}
+	else if(period < RTC_PERIOD_IDLE)
+	{
+		period += (period >> PERIOD_DECAY_SHIFT) + 1;
+		if(period > RTC_PERIOD_IDLE)
+		{
+			period = RTC_PERIOD_IDLE;
+		}
+	}
+
+	/* Skip the write while the previous PER write is being synchronized */
+	if(period != elapsed && !(RTC.STATUS & RTC_PERBUSY_bm))
+	{
+		rtc_period = period;
+		RTC.PER = period - 1;
+	}
+}
+
+int main(void)
+{
+	adaptive_stats_t snapshot;
+
+	event_system_init();
+	rtc_init();
+	adc_init();
+	sei(); /* Enable global interrupts */
+
+	while(1)
+	{
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			snapshot = stats;
+		}
+
+		if(snapshot.rtc_ticks > 0)
+		{
+			/* Average number of conversions per second since reset */
+			average_rate = (float) snapshot.conversions * RTC_CLOCK / snapshot.rtc_ticks;
+		}
+		/* Calculate voltage on ADC pin, VDD = 3.3V, 12-bit resolution */
+		voltage = (float)(adc_reading * 3.3) / ADC_MAX_VALUE;
+	}
+}
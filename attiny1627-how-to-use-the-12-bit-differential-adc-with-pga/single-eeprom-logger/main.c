@@ -0,0 +1,341 @@
+/*
+    \file   main.c
+
+    \brief  How To Use the 12-Bit Differential ADC in Single Mode
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+
+/*
+ *
+ * How To Use the 12-Bit Differential ADC in Single Mode:
+ * EEPROM Data Logger
+ *
+ */
+
+#define F_CPU 3333333ul
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/cpufunc.h>
+#include <stdbool.h>
+#include <math.h>
+
+#define TIMEBASE_VALUE      ((uint8_t) ceil(F_CPU*0.000001))
+#define BAUD_RATE           9600
+#define BAUD_REG_VAL        ((float)(64 * F_CPU / (16 * (float)BAUD_RATE)) + 0.5)
+
+/* A sample is taken every LOG_PERIOD seconds, and logged when it differs more than
+   LOG_DEADBAND from the last logged sample, or when LOG_MAX_INTERVAL seconds have passed */
+#define LOG_PERIOD          10      /* s */
+#define LOG_DEADBAND        8       /* LSB, 8 * 10.24 V / 4095 = 20 mV of VDD */
+#define LOG_MAX_INTERVAL    250     /* s, must fit in the 8-bit interval of a record */
+
+#define LOG_RECORD_SIZE     4
+#define LOG_RECORDS         (EEPROM_SIZE / LOG_RECORD_SIZE)
+#define LOG_SEQUENCE_MODULO 255     /* 0xFF is never used, it is the value of erased EEPROM */
+#define LOG_ERASED          0xFF
+#define LOG_INTERVAL_RESET  0xFF    /* Interval of the first record after a reset, the time since the previous record is unknown */
+
+_Static_assert(EEPROM_PAGE_SIZE % LOG_RECORD_SIZE == 0, "A record must not cross an EEPROM page");
+_Static_assert(LOG_RECORDS < LOG_SEQUENCE_MODULO, "The sequence numbers in the ring must be unique");
+_Static_assert(LOG_MAX_INTERVAL < LOG_INTERVAL_RESET, "LOG_MAX_INTERVAL must fit in the interval of a record");
+
+/******************************************************************************
+Log record, 4 bytes:
+sequence:       Sequence number, incremented modulo 255 for every record
+interval:       Seconds since the previous record, or LOG_INTERVAL_RESET
+sample:         12-bit ADC sample in bits 0-11, check value in bits 12-15
+*******************************************************************************/
+typedef struct
+{
+	uint8_t sequence;
+	uint8_t interval;
+	uint16_t sample;
+} log_record_t;
+
+_Static_assert(sizeof(log_record_t) == LOG_RECORD_SIZE, "Unexpected log record size");
+
+/* Volatile variables to improve debug experience */
+static volatile uint16_t seconds;
+static volatile uint16_t adc_reading;
+static volatile uint8_t log_newest;         /* Slot of the newest record */
+static volatile uint8_t log_count;          /* Number of records in the ring */
+static volatile uint8_t log_sequence;       /* Sequence number of the newest record */
+static volatile uint8_t log_torn_records;   /* Records found broken after a reset, e.g. by a power loss while writing */
+
+static uint16_t last_logged_sample;
+static uint16_t last_logged_time;
+static bool first_record = true;
+
+/* The EEPROM is mapped into the data space */
+#define log_slot(slot)      ((volatile log_record_t *)(EEPROM_START + (slot) * LOG_RECORD_SIZE))
+
+/**********************************************************************************
+Log record check value:
+Four bits computed from the rest of the record. A record that was only partly
+written when the power was lost has the wrong check value with a probability of
+15 in 16, so about 1 in 16 torn records is accepted. Only the record that was
+being written can be torn, so an accepted torn record is the newest one, or the
+oldest one when the cut left its old sequence number, with a wrong interval or
+sample; the other records are not affected. A wider check
+would need 8-byte records and halve the number of records in the log.
+The erased value 0xFFFF is never a valid sample field, as 0xFFF would need the
+check value 0xF.
+**********************************************************************************/
+static uint8_t log_check(uint8_t sequence, uint8_t interval, uint16_t sample)
+{
+	uint8_t check = sequence ^ interval ^ (uint8_t)sample ^ (uint8_t)(sample >> 8);
+
+	return ((check >> 4) ^ check ^ 0x5) & 0x0F;
+}
+
+static bool log_valid(const volatile log_record_t *record)
+{
+	return record->sequence < LOG_SEQUENCE_MODULO &&
+	       (record->sample >> 12) == log_check(record->sequence, record->interval, record->sample & 0x0FFF);
+}
+
+static uint8_t log_next_sequence(uint8_t sequence)
+{
+	return (sequence + 1 == LOG_SEQUENCE_MODULO) ? 0 : sequence + 1;
+}
+
+/**********************************************************************************
+Log run length:
+Number of records with consecutive sequence numbers, from a slot backwards
+**********************************************************************************/
+static uint8_t log_run_length(uint8_t slot)
+{
+	uint8_t sequence = log_slot(slot)->sequence;
+	uint8_t count = 0;
+
+	do
+	{
+		count++;
+		slot = (slot == 0) ? LOG_RECORDS - 1 : slot - 1;
+		sequence = (sequence == 0) ? LOG_SEQUENCE_MODULO - 1 : sequence - 1;
+	} while(count < LOG_RECORDS && log_valid(log_slot(slot)) && log_slot(slot)->sequence == sequence);
+
+	return count;
+}
+
+/**********************************************************************************
+Log recovery:
+Finds the newest record after a reset. The records in the ring have consecutive
+sequence numbers, so the newest record is one that the next slot does not continue:
+the next slot is erased, broken, or holds the oldest record. A broken record that
+passes the check by chance also looks like this, but it is alone, so the newest
+record is the one with the longest run of records before it. Broken slots are
+counted, and are overwritten by the next records.
+**********************************************************************************/
+void log_recover()
+{
+	/* Empty log, the first record is written to slot 0 */
+	log_newest = LOG_RECORDS - 1;
+	log_sequence = LOG_SEQUENCE_MODULO - 1;
+	log_count = 0;
+	log_torn_records = 0;
+
+	for(uint8_t slot = 0; slot < LOG_RECORDS; slot++)
+	{
+		const volatile log_record_t *record = log_slot(slot);
+		const volatile log_record_t *next = log_slot((slot + 1) % LOG_RECORDS);
+
+		if(!log_valid(record))
+		{
+			if(record->sequence != LOG_ERASED)
+			{
+				log_torn_records++;
+			}
+			continue;
+		}
+		if(!log_valid(next) || next->sequence != log_next_sequence(record->sequence))
+		{
+			uint8_t count = log_run_length(slot);
+
+			if(count > log_count)
+			{
+				log_newest = slot;
+				log_sequence = record->sequence;
+				log_count = count;
+			}
+		}
+	}
+}
+
+/**********************************************************************************
+Log append:
+Loads the four bytes of the record into the EEPROM page buffer, and starts an
+erase/write of the page. Only the loaded bytes are erased and written, so no
+read-modify-write of the page is needed, and every slot is written once per round
+of the ring. The write takes a few milliseconds, but runs in the background; only
+the next append or dump waits for it to finish.
+**********************************************************************************/
+void log_append(uint8_t interval, uint16_t sample)
+{
+	uint8_t slot = (log_newest + 1) % LOG_RECORDS;
+	uint8_t sequence = log_next_sequence(log_sequence);
+	volatile log_record_t *record = log_slot(slot);
+
+	while(NVMCTRL.STATUS & NVMCTRL_EEBUSY_bm); /* Wait for the previous write to finish */
+
+	record->sequence = sequence;
+	record->interval = interval;
+	record->sample = sample | ((uint16_t)log_check(sequence, interval, sample) << 12);
+	_PROTECTED_WRITE_SPM(NVMCTRL.CTRLA, NVMCTRL_CMD_PAGEERASEWRITE_gc);
+
+	log_newest = slot;
+	log_sequence = sequence;
+	if(log_count < LOG_RECORDS)
+	{
+		log_count++;
+	}
+}
+
+/**********************************************************************************
+RTC initialization: Periodic Interrupt Timer every second
+**********************************************************************************/
+void rtc_init()
+{
+	RTC.CLKSEL = RTC_CLKSEL_INT32K_gc; /* Select 32.768 kHz internal RC oscillator */
+	while(RTC.PITSTATUS > 0);  /* Wait for all registers to be synchronized */
+	RTC.PITINTCTRL = RTC_PI_bm; /* Enable periodic interrupt */
+	RTC.PITCTRLA = RTC_PERIOD_CYC32768_gc | RTC_PITEN_bm; /* 32768 cycles = 1 s */
+}
+
+/**********************************************************************************
+ADC initialization
+**********************************************************************************/
+void adc_init()
+{
+	ADC0.CTRLA = ADC_ENABLE_bm;
+	ADC0.CTRLB = ADC_PRESC_DIV2_gc; /* fCLK_ADC = 3.333333/2 MHz */
+	ADC0.CTRLC = ADC_REFSEL_1024MV_gc | (TIMEBASE_VALUE << ADC_TIMEBASE_gp);
+	ADC0.CTRLE = 17; /* (SAMPDUR + 0.5) * fCLK_ADC = 10.5 µs sample duration */
+
+	ADC0.MUXPOS = ADC_MUXPOS_VDDDIV10_gc; /* ADC channel VDD/10 */
+	ADC0.COMMAND = ADC_MODE_SINGLE_12BIT_gc; /* Single 12-bit mode */
+}
+
+/**********************************************************************************
+USART initialization
+**********************************************************************************/
+void usart_init()
+{
+	PORTB.DIRSET = PIN2_bm; /* Set TXD to output */
+	USART0.CTRLB = USART_TXEN_bm | USART_RXEN_bm; /* Enable USART transmitter and receiver */
+	USART0.BAUD = BAUD_REG_VAL; /* Set baud rate */
+}
+
+void usart_send(uint8_t data)
+{
+	while(!(USART0.STATUS & USART_DREIF_bm));
+	USART0.TXDATAL = data;
+}
+
+/**********************************************************************************
+Log dump:
+Sends the records from the oldest to the newest in the Data Visualizer format,
+with the sequence number, the interval and the 12-bit sample as payload.
+**********************************************************************************/
+void log_dump()
+{
+	uint8_t slot = (log_newest + LOG_RECORDS + 1 - log_count) % LOG_RECORDS;
+
+	while(NVMCTRL.STATUS & NVMCTRL_EEBUSY_bm); /* Wait for the last write to finish */
+
+	for(uint8_t i = 0; i < log_count; i++)
+	{
+		const volatile log_record_t *record = log_slot(slot);
+
+		usart_send(0x33); /* Send data stream start byte */
+		usart_send(record->sequence);
+		usart_send(record->interval);
+		usart_send(record->sample & 0xFF);
+		usart_send((record->sample >> 8) & 0x0F);
+		usart_send(~0x33); /* Send data stream stop byte */
+
+		slot = (slot + 1) % LOG_RECORDS;
+	}
+}
+
+ISR(RTC_PIT_vect)
+{
+	RTC.PITINTFLAGS = RTC_PI_bm; /* Clear interrupt flag */
+	seconds++;
+}
+
+int main(void)
+{
+	uint16_t last_sample_time = 0;
+
+	log_recover();
+	adc_init();
+	usart_init();
+	rtc_init();
+	sei(); /* Enable global interrupts */
+
+	while(1)
+	{
+		/* Any byte received on USART0 requests a dump of the log */
+		if(USART0.STATUS & USART_RXCIF_bm)
+		{
+			(void)USART0.RXDATAL;
+			log_dump();
+		}
+
+		cli();
+		uint16_t now = seconds;
+		sei();
+
+		if((uint16_t)(now - last_sample_time) < LOG_PERIOD)
+		{
+			continue;
+		}
+		last_sample_time = now;
+
+		ADC0.COMMAND |= ADC_START_IMMEDIATE_gc;     /* Start ADC conversion */
+		while(!(ADC0.INTFLAGS & ADC_SAMPRDY_bm));   /* Wait until conversion is done */
+		adc_reading = ADC0.SAMPLE; /* Read ADC sample, clears flag */
+
+		uint16_t interval = now - last_logged_time;
+		int16_t change = adc_reading - last_logged_sample;
+
+		if(first_record)
+		{
+			log_append(LOG_INTERVAL_RESET, adc_reading);
+			first_record = false;
+		}
+		else if(change > LOG_DEADBAND || change < -LOG_DEADBAND || interval >= LOG_MAX_INTERVAL)
+		{
+			log_append(interval, adc_reading);
+		}
+		else
+		{
+			continue;
+		}
+		last_logged_sample = adc_reading;
+		last_logged_time = now;
+	}
+}
@@ -0,0 +1,235 @@
+/*
+    \file   main.c
+
+    \brief  How To Use the 12-Bit Differential ADC in Single Mode
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+
+/*
+ *
+ * How To Use the 12-Bit Differential ADC in Single Mode:
+ * Event System Pipeline
+ *
+ */
+
+#define F_CPU 3333333ul
+
+#include <avr/io.h>
+#include <stddef.h>
+#include <math.h>
+
+#define TIMEBASE_VALUE      ((uint8_t) ceil(F_CPU*0.000001))
+
+/* Defines to easily configure TCA0 event frequency */
+#define ADC_SAMPLING_FREQ   1000    /* Hz */
+#define TCA_PERIOD          ((F_CPU / ADC_SAMPLING_FREQ) - 1)
+
+#define EVSYS_CHANNELS      6
+#define EVSYS_MAX_USERS     3
+
+/******************************************************************************
+Event routing table:
+Each entry connects one event generator to the users listed, through one event
+channel. The generator value must be the one for the selected channel. The user
+list is terminated by NULL.
+*******************************************************************************/
+typedef struct
+{
+	uint8_t channel;
+	uint8_t generator;
+	register8_t *users[EVSYS_MAX_USERS + 1];
+} event_route_t;
+
+typedef enum
+{
+	PIPELINE_OK,
+	PIPELINE_INVALID_CHANNEL,
+	PIPELINE_CHANNEL_IN_USE,
+	PIPELINE_USER_IN_USE
+} pipeline_status_t;
+
+/******************************************************************************
+Acquire-compare-signal pipeline, running without any interrupts:
+Channel 0:
+            Event system generator: TCA0 Overflow
+            Event system user: ADC0 (acquire)
+Channel 1:
+            Event system generator: ADC0 Window Compare
+            Event system users: CCL LUT0 input A (signal on LUT0 OUT, PA4)
+                                TCB0 capture (time stamp of the last compare match)
+Channel 2:
+            Event system generator: ADC0 Result Ready
+            Event system users: EVOUTB (PIN PB2)
+                                TCB1 count (number of conversions)
+*******************************************************************************/
+static const event_route_t event_pipeline[] =
+{
+	{ 0, EVSYS_CHANNEL0_TCA0_OVF_LUNF_gc,   { &EVSYS.USERADC0START, NULL } },
+	{ 1, EVSYS_CHANNEL1_ADC0_WCMP_gc,       { &EVSYS.USERCCLLUT0A, &EVSYS.USERTCB0CAPT, NULL } },
+	{ 2, EVSYS_CHANNEL2_ADC0_RES_gc,        { &EVSYS.USEREVSYSEVOUTB, &EVSYS.USERTCB1COUNT, NULL } },
+};
+
+/* Volatile variables to improve debug experience */
+static volatile pipeline_status_t pipeline_status;
+static volatile uint16_t last_compare_timestamp;
+static volatile uint16_t conversion_count;
+
+/**********************************************************************************
+Event pipeline builder:
+Connects the generators and users in the table. Every channel and every user may
+only be used once, and the table is checked before anything is written, so a
+faulty table leaves the event system untouched.
+**********************************************************************************/
+pipeline_status_t event_pipeline_build(const event_route_t *routes, uint8_t count)
+{
+	uint8_t channels_used = 0;
+
+	for(uint8_t i = 0; i < count; i++)
+	{
+		if(routes[i].channel >= EVSYS_CHANNELS)
+		{
+			return PIPELINE_INVALID_CHANNEL;
+		}
+		if(channels_used & (1 << routes[i].channel))
+		{
+			return PIPELINE_CHANNEL_IN_USE;
+		}
+		channels_used |= 1 << routes[i].channel;
+
+		/* A user can only listen to one channel */
+		for(register8_t * const *user = routes[i].users; *user != NULL; user++)
+		{
+			for(uint8_t j = 0; j <= i; j++)
+			{
+				for(register8_t * const *other = routes[j].users; *other != NULL && other != user; other++)
+				{
+					if(*other == *user)
+					{
+						return PIPELINE_USER_IN_USE;
+					}
+				}
+			}
+		}
+	}
+
+	for(uint8_t i = 0; i < count; i++)
+	{
+		/* The channel registers are consecutive */
+		(&EVSYS.CHANNEL0)[routes[i].channel] = routes[i].generator;
+
+		for(register8_t * const *user = routes[i].users; *user != NULL; user++)
+		{
+			/* User values are consecutive, starting at channel 0 */
+			**user = EVSYS_USER_CHANNEL0_gc + routes[i].channel;
+		}
+	}
+
+	return PIPELINE_OK;
+}
+
+/*********************************************************************************
+TCA0 initialization: Overflow event at ADC_SAMPLING_FREQ
+**********************************************************************************/
+void tca_init(void)
+{
+	TCA0.SINGLE.PER = TCA_PERIOD;
+	TCA0.SINGLE.CTRLA = TCA_SINGLE_CLKSEL_DIV1_gc | TCA_SINGLE_ENABLE_bm;
+}
+
+/*********************************************************************************
+TCB initialization:
+TCB0 captures the counter value on every window compare event.
+TCB1 counts the Result Ready events.
+**********************************************************************************/
+void tcb_init(void)
+{
+	TCB0.CTRLB = TCB_CNTMODE_CAPT_gc; /* Input Capture on Event mode */
+	TCB0.EVCTRL = TCB_CAPTEI_bm; /* Enable capture event input */
+	TCB0.CTRLA = TCB_CLKSEL_TCA0_gc | TCB_ENABLE_bm; /* Count with the same clock as TCA0 */
+
+	TCB1.CCMP = 0xFFFF;
+	TCB1.CTRLB = TCB_CNTMODE_INT_gc; /* Periodic Interrupt mode, interrupt not enabled */
+	TCB1.CTRLA = TCB_CLKSEL_EVENT_gc | TCB_ENABLE_bm; /* Count on events */
+}
+
+/*********************************************************************************
+CCL initialization: LUT0 output follows event input A
+The window compare event is a pulse of one CLK_PER cycle, so the LUT0 output
+on PA4 is a pulse of the same length for each result outside the window, not
+a level. The single-window-fast-path example latches it with the CCL
+sequencer when a level is needed.
+**********************************************************************************/
+void ccl_init(void)
+{
+	PORTA.DIRSET = PIN4_bm; /* Configure LUT0 OUT to output */
+
+	CCL.LUT0CTRLB = CCL_INSEL0_EVENTA_gc | CCL_INSEL1_MASK_gc;
+	CCL.LUT0CTRLC = CCL_INSEL2_MASK_gc;
+	CCL.TRUTH0 = 0x02; /* Output is high when input 0 is high */
+	CCL.LUT0CTRLA = CCL_OUTEN_bm | CCL_ENABLE_bm;
+	CCL.CTRLA = CCL_ENABLE_bm;
+}
+
+/**********************************************************************************
+ADC initialization
+**********************************************************************************/
+void adc_init()
+{
+	PORTB.DIRSET = PIN2_bm; /* Configure EVOUTB to output */
+
+	ADC0.CTRLA = ADC_ENABLE_bm;
+	ADC0.CTRLB = ADC_PRESC_DIV2_gc; /* fCLK_ADC = 3.333333/2 MHz */
+	ADC0.CTRLC = ADC_REFSEL_VDD_gc | (TIMEBASE_VALUE << ADC_TIMEBASE_gp);
+	ADC0.CTRLE = 17; /* (SAMPDUR + 0.5) * fCLK_ADC = 10.5 µs sample duration */
+
+	ADC0.MUXPOS = ADC_MUXPOS_AIN6_gc; /* ADC channel AIN6 -> PA6 */
+
+	ADC0.WINHT = 3000; /* Window High Threshold */
+	ADC0.WINLT = 2000; /* Window Low Threshold */
+	/* Window Comparator mode: Outside. Use RESULT register as Window Comparator source */
+	ADC0.CTRLD = ADC_WINCM_OUTSIDE_gc | ADC_WINSRC_RESULT_gc;
+
+	/* Start ADC conversion on event trigger */
+	ADC0.COMMAND = ADC_MODE_SINGLE_12BIT_gc | ADC_START_EVENT_TRIGGER_gc;
+}
+
+int main(void)
+{
+	adc_init();
+	ccl_init();
+	tcb_init();
+
+	pipeline_status = event_pipeline_build(event_pipeline, sizeof(event_pipeline) / sizeof(event_pipeline[0]));
+	if(pipeline_status == PIPELINE_OK)
+	{
+		tca_init(); /* Start the pipeline */
+	}
+
+	while(1)
+	{
+		/* The CPU is not involved in the pipeline, it only reads the results for debugging */
+		last_compare_timestamp = TCB0.CCMP;
+		conversion_count = TCB1.CNT;
+	}
+}
@@ -0,0 +1,444 @@
+/*
+    \file   main.c
+
+    \brief  How To Use the 12-Bit Differential ADC in Single Mode
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+
+/*
+ *
+ * How To Use the 12-Bit Differential ADC in Single Mode:
+ * Frequency Analysis with Goertzel Filters or FFT
+ *
+ */
+
+#define F_CPU 3333333ul
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <math.h>
+
+#define TIMEBASE_VALUE      ((uint8_t) ceil(F_CPU*0.000001))
+#define BAUD_RATE           115200
+#define BAUD_REG_VAL        ((float)(64 * F_CPU / (16 * (float)BAUD_RATE)) + 0.5)
+
+/* Defines to easily configure RTC event frequency */
+#define RTC_CLOCK           32768   /* Hz */
+#define RTC_PERIOD          8
+#define ADC_SAMPLING_FREQ   (RTC_CLOCK / RTC_PERIOD) /* 4096 Hz */
+
+/* Set to 1 to calculate a radix-2 FFT of each block instead of the Goertzel filters */
+#ifndef ANALYSIS_FFT
+#define ANALYSIS_FFT        0
+#endif
+
+#if ANALYSIS_FFT
+#define BLOCK_SIZE          64      /* Must be a power of two */
+#define BLOCK_BITS          6       /* log2(BLOCK_SIZE) */
+#define ANALYSIS_BINS       (BLOCK_SIZE / 2)
+#else
+#define BLOCK_SIZE          256
+/* Frequencies of the Goertzel filters in Hz, below ADC_SAMPLING_FREQ / 2 */
+static const uint16_t goertzel_freqs[] = { 50, 100, 150, 1000 };
+#define ANALYSIS_BINS       (sizeof(goertzel_freqs) / sizeof(goertzel_freqs[0]))
+#endif
+
+/* CPU cycles available per block: the time it takes to capture the next block */
+#define CYCLES_PER_BLOCK_BUDGET ((uint32_t) ((uint64_t) F_CPU * BLOCK_SIZE / ADC_SAMPLING_FREQ))
+
+_Static_assert(2 * BLOCK_SIZE * sizeof(int16_t) <= 1024, "Sample buffers use more than half of the SRAM");
+
+/* Two sample buffers: one is filled by the ISR while the other is analyzed */
+static int16_t sample_buffers[2][BLOCK_SIZE];
+static volatile uint8_t ready_buffer = 0xFF; /* Index of the full buffer, 0xFF if none */
+
+#if ANALYSIS_FFT
+static int16_t fft_imag[BLOCK_SIZE];
+static int16_t twiddle_cos[BLOCK_SIZE / 2]; /* Q15 */
+static int16_t twiddle_sin[BLOCK_SIZE / 2]; /* Q15 */
+#else
+static int16_t goertzel_coeff[ANALYSIS_BINS]; /* 2 * cos(w), Q14 */
+static int16_t goertzel_sin[ANALYSIS_BINS];   /* sin(w), Q14 */
+#endif
+
+/* Volatile variables to improve debug experience */
+static volatile uint16_t dc_level;                  /* Mean of the block in ADC codes */
+static volatile uint16_t amplitudes[ANALYSIS_BINS]; /* Amplitude per bin in ADC codes */
+static volatile uint32_t analysis_cycles;           /* CPU cycles used by the last analysis */
+static volatile uint16_t block_overruns;            /* Blocks lost because the analysis was too slow */
+
+/******************************************************************************
+EVSYS initialization:
+Channel 0:
+            Event system generator: RTC Overflow
+            Event system user: ADC0
+*******************************************************************************/
+void event_system_init(void)
+{
+	EVSYS.CHANNEL0 = EVSYS_CHANNEL0_RTC_OVF_gc;     /* RTC Overflow ->  Channel 0 */
+	EVSYS.USERADC0START = EVSYS_USER_CHANNEL0_gc;   /* Channel 0    ->  ADC0 Start */
+}
+
+/*********************************************************************************
+RTC initialization
+**********************************************************************************/
+void rtc_init(void)
+{
+	while(RTC.STATUS > 0);  /* Wait for all registers to be synchronized */
+	RTC.CTRLA = RTC_PRESCALER_DIV1_gc | RTC_RTCEN_bm; /* Enable RTC, no prescaler */
+	RTC.CLKSEL = RTC_CLKSEL_INT32K_gc; /* Select 32.768 kHz internal RC oscillator */
+	RTC.PER = RTC_PERIOD - 1; /* The period is PER + 1 RTC clock cycles */
+	while(RTC.STATUS > 0);  /* Wait for all registers to be synchronized */
+}
+
+/*********************************************************************************
+TCA0 initialization: free-running counter to measure the analysis time
+**********************************************************************************/
+void tca_init(void)
+{
+	TCA0.SINGLE.PER = 0xFFFF;
+	TCA0.SINGLE.CTRLA = TCA_SINGLE_CLKSEL_DIV16_gc | TCA_SINGLE_ENABLE_bm;
+}
+
+/**********************************************************************************
+ADC initialization
+**********************************************************************************/
+void adc_init()
+{
+	ADC0.CTRLA = ADC_ENABLE_bm;
+	ADC0.CTRLB = ADC_PRESC_DIV2_gc; /* fCLK_ADC = 3.333333/2 MHz */
+	ADC0.CTRLC = ADC_REFSEL_1024MV_gc | (TIMEBASE_VALUE << ADC_TIMEBASE_gp);
+	ADC0.CTRLE = 17; /* (SAMPDUR + 0.5) * fCLK_ADC = 10.5 µs sample duration */
+	ADC0.INTCTRL = ADC_RESRDY_bm; /* Enable Result Ready interrupt */
+
+	ADC0.MUXPOS = ADC_MUXPOS_VDDDIV10_gc; /* ADC channel VDD/10 */
+	/* Start ADC conversion on event trigger */
+	ADC0.COMMAND = ADC_MODE_SINGLE_12BIT_gc | ADC_START_EVENT_TRIGGER_gc;
+}
+
+/**********************************************************************************
+USART initialization
+**********************************************************************************/
+void usart_init()
+{
+	PORTB.DIRSET = PIN2_bm; /* Set TXD to output */
+	USART0.CTRLB = USART_TXEN_bm; /* Enable USART transmitter */
+	USART0.BAUD = BAUD_REG_VAL; /* Set baud rate */
+}
+
+static void usart_send_byte(uint8_t data)
+{
+	while(!(USART0.STATUS & USART_DREIF_bm));
+	USART0.TXDATAL = data;
+}
+
+/**********************************************************************************
+Send the result of a block via USART:
+Start byte, number of bins, DC level and one amplitude per bin as 16-bit little
+endian values, stop byte
+**********************************************************************************/
+void usart_send_spectrum()
+{
+	usart_send_byte(0x33); /* Send data stream start byte */
+	usart_send_byte(ANALYSIS_BINS);
+	usart_send_byte((uint8_t) dc_level);
+	usart_send_byte((uint8_t) (dc_level >> 8));
+	for(uint8_t i = 0; i < ANALYSIS_BINS; i++)
+	{
+		usart_send_byte((uint8_t) amplitudes[i]);
+		usart_send_byte((uint8_t) (amplitudes[i] >> 8));
+	}
+	usart_send_byte(~0x33); /* Send data stream stop byte */
+}
+
+#if ANALYSIS_FFT
+/**********************************************************************************
+Integer square root, rounded down. The FFT powers fit in 32 bits, which the AVR
+calculates with half the instructions of 64 bits.
+**********************************************************************************/
+static uint16_t isqrt32(uint32_t value)
+{
+	uint32_t root = 0;
+	uint32_t bit = (uint32_t) 1 << 30;
+
+	while(bit > value)
+	{
+		bit >>= 2;
+	}
+	while(bit != 0)
+	{
+		if(value >= root + bit)
+		{
+			value -= root + bit;
+			root = (root >> 1) + bit;
+		}
+		else
+		{
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint16_t) root;
+}
+#else
+/**********************************************************************************
+Integer square root, rounded down
+**********************************************************************************/
+static uint32_t isqrt64(uint64_t value)
+{
+	uint64_t root = 0;
+	uint64_t bit = (uint64_t) 1 << 62;
+
+	while(bit > value)
+	{
+		bit >>= 2;
+	}
+	while(bit != 0)
+	{
+		if(value >= root + bit)
+		{
+			value -= root + bit;
+			root = (root >> 1) + bit;
+		}
+		else
+		{
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint32_t) root;
+}
+#endif
+
+/**********************************************************************************
+Calculate the coefficients once at startup, so the analysis only uses integers
+**********************************************************************************/
+void analysis_init()
+{
+#if ANALYSIS_FFT
+	for(uint8_t k = 0; k < BLOCK_SIZE / 2; k++)
+	{
+		float w = 2 * M_PI * k / BLOCK_SIZE;
+		twiddle_cos[k] = (int16_t) lround(cos(w) * 32767);
+		twiddle_sin[k] = (int16_t) lround(sin(w) * 32767);
+	}
+#else
+	for(uint8_t i = 0; i < ANALYSIS_BINS; i++)
+	{
+		float w = 2 * M_PI * goertzel_freqs[i] / ADC_SAMPLING_FREQ;
+		goertzel_coeff[i] = (int16_t) lround(2 * cos(w) * 16384);
+		goertzel_sin[i] = (int16_t) lround(sin(w) * 16384);
+	}
+#endif
+}
+
+/**********************************************************************************
+Remove the DC level of a block, and return it
+**********************************************************************************/
+static uint16_t remove_dc(int16_t *samples)
+{
+	int32_t sum = 0;
+
+	for(uint16_t n = 0; n < BLOCK_SIZE; n++)
+	{
+		sum += samples[n];
+	}
+	int16_t mean = (sum + BLOCK_SIZE / 2) / BLOCK_SIZE;
+	for(uint16_t n = 0; n < BLOCK_SIZE; n++)
+	{
+		samples[n] -= mean;
+	}
+	return mean;
+}
+
+#if ANALYSIS_FFT
+/**********************************************************************************
+Radix-2 decimation-in-time FFT, in place, on a real input block.
+Each stage is scaled by 1/2 to avoid overflow, so the output is X[k] / BLOCK_SIZE.
+**********************************************************************************/
+static void fft_radix2(int16_t *re, int16_t *im)
+{
+	/* Bit-reversed reordering */
+	for(uint8_t i = 1, j = 0; i < BLOCK_SIZE; i++)
+	{
+		uint8_t bit = BLOCK_SIZE >> 1;
+		while(j & bit)
+		{
+			j ^= bit;
+			bit >>= 1;
+		}
+		j |= bit;
+		if(i < j)
+		{
+			int16_t temp = re[i];
+			re[i] = re[j];
+			re[j] = temp;
+		}
+	}
+
+	for(uint8_t half = 1, step = BLOCK_SIZE / 2; half < BLOCK_SIZE; half <<= 1, step >>= 1)
+	{
+		for(uint8_t i = 0; i < BLOCK_SIZE; i += 2 * half)
+		{
+			for(uint8_t k = 0; k < half; k++)
+			{
+				int16_t wr = twiddle_cos[k * step];
+				int16_t wi = -twiddle_sin[k * step];
+				uint8_t a = i + k;
+				uint8_t b = a + half;
+				int16_t tr = ((int32_t) wr * re[b] - (int32_t) wi * im[b]) >> 15;
+				int16_t ti = ((int32_t) wr * im[b] + (int32_t) wi * re[b]) >> 15;
+
+				re[b] = (re[a] - tr) >> 1;
+				im[b] = (im[a] - ti) >> 1;
+				re[a] = (re[a] + tr) >> 1;
+				im[a] = (im[a] + ti) >> 1;
+			}
+		}
+	}
+}
+
+/**********************************************************************************
+Amplitude of each FFT bin in ADC codes. The samples are scaled up by 8 before the
+FFT to use the 16-bit range, and the FFT output is X[k] / BLOCK_SIZE, so the
+amplitude 2 * |X[k]| / BLOCK_SIZE is |output| / 4.
+**********************************************************************************/
+static void analyze_block(int16_t *samples)
+{
+	for(uint8_t n = 0; n < BLOCK_SIZE; n++)
+	{
+		samples[n] <<= 3;
+		fft_imag[n] = 0;
+	}
+	fft_radix2(samples, fft_imag);
+
+	for(uint8_t k = 0; k < ANALYSIS_BINS; k++)
+	{
+		uint32_t power = (int32_t) samples[k] * samples[k] + (int32_t) fft_imag[k] * fft_imag[k];
+		amplitudes[k] = (isqrt32(power) + 2) >> 2;
+	}
+}
+#else
+/**********************************************************************************
+Multiply a 32-bit state with a Q14 coefficient, using two 16x16-bit multiplications
+instead of a 32x32-bit multiplication
+**********************************************************************************/
+static inline int32_t mul_q14(int32_t state, int16_t coeff)
+{
+	int32_t high = (int32_t) (int16_t) (state >> 16) * coeff;
+	int32_t low = (int32_t) (uint16_t) state * coeff; /* Fits: 65535 * 32767 < 2^31 */
+
+	return (high << 2) + (low >> 14);
+}
+
+/**********************************************************************************
+Amplitude at each Goertzel frequency in ADC codes. Per sample and frequency:
+    s[n] = x[n] + 2 * cos(w) * s[n-1] - s[n-2]
+After the block, |X| = |s[n-1] - s[n-2] * e^(-jw)|, and the amplitude is
+2 * |X| / BLOCK_SIZE.
+**********************************************************************************/
+static void analyze_block(int16_t *samples)
+{
+	for(uint8_t i = 0; i < ANALYSIS_BINS; i++)
+	{
+		int16_t coeff = goertzel_coeff[i];
+		int32_t s1 = 0;
+		int32_t s2 = 0;
+
+		for(uint16_t n = 0; n < BLOCK_SIZE; n++)
+		{
+			int32_t s0 = samples[n] + mul_q14(s1, coeff) - s2;
+			s2 = s1;
+			s1 = s0;
+		}
+
+		/* cos(w) = coeff / 2 in Q14 */
+		int64_t re = ((int64_t) s1 << 14) - (int64_t) s2 * (coeff / 2);
+		int64_t im = (int64_t) s2 * goertzel_sin[i];
+		/* re and im are Q14, scale them to fit the square */
+		re >>= 7;
+		im >>= 7;
+		uint32_t magnitude = isqrt64((uint64_t) (re * re + im * im)); /* |X| in Q7 */
+		amplitudes[i] = ((uint64_t) magnitude * 2 / BLOCK_SIZE + 64) >> 7;
+	}
+}
+#endif
+
+/***********************************************************************************
+Result Ready interrupt:
+Stores the result in the buffer that is being filled. When the buffer is full,
+it is handed to the main loop and the other buffer is filled. If the main loop
+still analyzes the previous block, the new block is dropped and the same buffer
+is filled again, so the block being analyzed is never overwritten.
+***********************************************************************************/
+ISR(ADC0_RESRDY_vect)
+{
+	static uint8_t fill_buffer;
+	static uint16_t index;
+
+	sample_buffers[fill_buffer][index] = ADC0.RESULT; /* Read ADC result, clears the interrupt flag */
+
+	if(++index >= BLOCK_SIZE)
+	{
+		index = 0;
+		if(ready_buffer != 0xFF)
+		{
+			block_overruns++; /* The previous block was not analyzed in time, drop this one */
+		}
+		else
+		{
+			ready_buffer = fill_buffer;
+			fill_buffer ^= 1;
+		}
+	}
+}
+
+int main(void)
+{
+	analysis_init();
+	event_system_init();
+	rtc_init();
+	tca_init();
+	adc_init();
+	usart_init();
+	sei(); /* Enable global interrupts */
+
+	while(1)
+	{
+		if(ready_buffer != 0xFF)
+		{
+			int16_t *samples = sample_buffers[ready_buffer];
+			uint16_t start = TCA0.SINGLE.CNT;
+
+			dc_level = remove_dc(samples);
+			analyze_block(samples);
+
+			/* TCA0 counts CLK_PER / 16 */
+			analysis_cycles = (uint32_t) (uint16_t) (TCA0.SINGLE.CNT - start) * 16;
+			ready_buffer = 0xFF;
+
+			usart_send_spectrum(); /* Only a few bytes per block are sent */
+		}
+	}
+}
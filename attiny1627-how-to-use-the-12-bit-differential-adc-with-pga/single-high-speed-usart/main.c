@@ -0,0 +1,297 @@
+/*
+    \file   main.c
+
+    \brief  How To Use the 12-Bit Differential ADC in Single Mode
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+
+/*
+ *
+ * How To Use the 12-Bit Differential ADC in Single Mode:
+ * High-Speed USART with Clock and Baud Planner
+ *
+ */
+
+/* Main clock at reset. The planner changes the clock at run time, so _delay_ms() is not used. */
+#define F_CPU 3333333ul
+
+#include <avr/io.h>
+#include <stddef.h>
+
+#define ADC_MAX_VALUE       ((1 << 12) - 1) /* In single-ended mode, the max value is 4095 */
+
+/* Defines to easily configure the clock and baud planner */
+#define OSC_FREQ            20000000ul  /* Hz, 20 MHz oscillator selected by the fuses (default) */
+#define CLOCK_DIVISION      2           /* Main clock = OSC_FREQ / CLOCK_DIVISION. 1 needs VDD >= 4.5V */
+#define BAUD_RATE_MAX       1000000ul   /* Highest baud rate the receiver supports */
+#define BAUD_ERROR_BUDGET   10          /* Highest accepted baud rate error in permille */
+#define ADC_CLOCK_MAX       2000000ul   /* Hz, keeps the conversion timing of the other examples */
+#define ADC_SAMPLE_TIME_NS  10000ul     /* Minimum sample duration */
+
+typedef struct
+{
+	uint32_t cpu_freq;      /* Main clock in Hz */
+	uint32_t baud_rate;     /* Selected nominal baud rate */
+	uint16_t baud_reg;      /* USART0.BAUD */
+	uint8_t clk2x;          /* Double-speed mode */
+	uint8_t baud_error;     /* Baud rate error in permille */
+	uint8_t mclkctrlb;      /* CLKCTRL.MCLKCTRLB */
+	uint8_t adc_prescaler;  /* ADC0.CTRLB */
+	uint8_t timebase;       /* TIMEBASE in ADC0.CTRLC */
+	uint8_t sampdur;        /* ADC0.CTRLE */
+} clock_plan_t;
+
+typedef struct
+{
+	uint8_t division;
+	uint8_t value;
+} divider_t;
+
+/* Main clock prescaler settings, sorted by division */
+static const divider_t clock_dividers[] =
+{
+	{  1, 0 },
+	{  2, CLKCTRL_PDIV_2X_gc  | CLKCTRL_PEN_bm },
+	{  4, CLKCTRL_PDIV_4X_gc  | CLKCTRL_PEN_bm },
+	{  6, CLKCTRL_PDIV_6X_gc  | CLKCTRL_PEN_bm },
+	{  8, CLKCTRL_PDIV_8X_gc  | CLKCTRL_PEN_bm },
+	{ 10, CLKCTRL_PDIV_10X_gc | CLKCTRL_PEN_bm },
+	{ 16, CLKCTRL_PDIV_16X_gc | CLKCTRL_PEN_bm },
+};
+
+/* ADC prescaler settings, sorted by division */
+static const divider_t adc_dividers[] =
+{
+	{  2, ADC_PRESC_DIV2_gc  }, {  4, ADC_PRESC_DIV4_gc  }, {  6, ADC_PRESC_DIV6_gc  }, {  8, ADC_PRESC_DIV8_gc  },
+	{ 10, ADC_PRESC_DIV10_gc }, { 12, ADC_PRESC_DIV12_gc }, { 14, ADC_PRESC_DIV14_gc }, { 16, ADC_PRESC_DIV16_gc },
+	{ 20, ADC_PRESC_DIV20_gc }, { 24, ADC_PRESC_DIV24_gc }, { 28, ADC_PRESC_DIV28_gc }, { 32, ADC_PRESC_DIV32_gc },
+	{ 40, ADC_PRESC_DIV40_gc }, { 48, ADC_PRESC_DIV48_gc }, { 56, ADC_PRESC_DIV56_gc }, { 64, ADC_PRESC_DIV64_gc },
+};
+
+/* Standard baud rates, highest first */
+static const uint32_t baud_rates[] =
+{
+	1000000, 921600, 500000, 460800, 250000, 230400, 115200, 57600, 38400, 19200, 9600
+};
+
+#define ARRAY_SIZE(a)       (sizeof(a) / sizeof((a)[0]))
+
+static uint8_t usart_sending; /* Bytes were written since the last clock switch */
+
+/* Volatile variables to improve debug experience */
+static volatile clock_plan_t plan;
+static volatile uint16_t adc_reading;
+
+/**********************************************************************************
+Calculate the baud register value for a baud rate, and return the error in
+permille, or 0xFF if the baud rate cannot be reached:
+    BAUD = 64 * fCLK_PER / (S * baud rate), S = 16 in normal mode, 8 in double-speed mode
+**********************************************************************************/
+static uint8_t baud_calculate(uint32_t cpu_freq, uint32_t baud_rate, uint8_t samples, uint16_t *baud_reg)
+{
+	uint32_t divisor = samples * baud_rate;
+	uint32_t reg = (64 * cpu_freq + divisor / 2) / divisor;
+
+	/* BAUD must be at least 64 */
+	if(reg < 64 || reg > 0xFFFF)
+	{
+		return 0xFF;
+	}
+
+	uint32_t actual = (64 * cpu_freq + (samples * reg) / 2) / (samples * reg);
+	uint32_t difference = (actual > baud_rate) ? actual - baud_rate : baud_rate - actual;
+	uint32_t error = (difference * 1000 + baud_rate / 2) / baud_rate;
+
+	*baud_reg = reg;
+	return (error > 0xFE) ? 0xFE : error;
+}
+
+/**********************************************************************************
+Plan the clock settings for a main clock division:
+- The highest baud rate within the error budget, in normal mode if possible,
+  since double-speed mode samples each bit fewer times
+- The lowest ADC prescaler that keeps fCLK_ADC at or below ADC_CLOCK_MAX
+- TIMEBASE and SAMPDUR for the new clock frequencies
+Returns 0 if no setting fits.
+**********************************************************************************/
+uint8_t clock_plan(uint8_t division, clock_plan_t *result)
+{
+	const divider_t *clock = NULL;
+
+	for(uint8_t i = 0; i < ARRAY_SIZE(clock_dividers); i++)
+	{
+		if(clock_dividers[i].division == division)
+		{
+			clock = &clock_dividers[i];
+		}
+	}
+	if(clock == NULL)
+	{
+		return 0;
+	}
+
+	result->cpu_freq = OSC_FREQ / division;
+	result->mclkctrlb = clock->value;
+	result->baud_rate = 0;
+
+	for(uint8_t i = 0; i < ARRAY_SIZE(baud_rates) && result->baud_rate == 0; i++)
+	{
+		if(baud_rates[i] > BAUD_RATE_MAX)
+		{
+			continue;
+		}
+		for(uint8_t clk2x = 0; clk2x < 2; clk2x++)
+		{
+			uint16_t baud_reg;
+			uint8_t error = baud_calculate(result->cpu_freq, baud_rates[i], clk2x ? 8 : 16, &baud_reg);
+
+			if(error <= BAUD_ERROR_BUDGET)
+			{
+				result->baud_rate = baud_rates[i];
+				result->baud_reg = baud_reg;
+				result->baud_error = error;
+				result->clk2x = clk2x;
+				break;
+			}
+		}
+	}
+	if(result->baud_rate == 0)
+	{
+		return 0;
+	}
+
+	uint8_t adc_division = adc_dividers[ARRAY_SIZE(adc_dividers) - 1].division;
+	result->adc_prescaler = adc_dividers[ARRAY_SIZE(adc_dividers) - 1].value;
+	for(uint8_t i = 0; i < ARRAY_SIZE(adc_dividers); i++)
+	{
+		if(result->cpu_freq / adc_dividers[i].division <= ADC_CLOCK_MAX)
+		{
+			adc_division = adc_dividers[i].division;
+			result->adc_prescaler = adc_dividers[i].value;
+			break;
+		}
+	}
+
+	/* TIMEBASE: number of CLK_PER cycles in 1 µs, rounded up */
+	result->timebase = (result->cpu_freq + 999999) / 1000000;
+
+	/* (SAMPDUR + 0.5) / fCLK_ADC >= ADC_SAMPLE_TIME_NS, rounded up */
+	uint32_t adc_freq_khz = result->cpu_freq / adc_division / 1000;
+	result->sampdur = (ADC_SAMPLE_TIME_NS * adc_freq_khz + 999999) / 1000000;
+
+	return 1;
+}
+
+/**********************************************************************************
+ADC initialization
+**********************************************************************************/
+void adc_init(const clock_plan_t *settings)
+{
+	ADC0.CTRLA = ADC_ENABLE_bm;
+	ADC0.CTRLB = settings->adc_prescaler;
+	ADC0.CTRLC = ADC_REFSEL_VDD_gc | (settings->timebase << ADC_TIMEBASE_gp);
+	ADC0.CTRLE = settings->sampdur;
+
+	ADC0.MUXPOS = ADC_MUXPOS_AIN6_gc; /* ADC channel AIN6 -> PA6 */
+	ADC0.COMMAND = ADC_MODE_SINGLE_12BIT_gc; /* Single 12-bit mode */
+}
+
+/**********************************************************************************
+USART initialization
+**********************************************************************************/
+void usart_init(const clock_plan_t *settings)
+{
+	PORTB.DIRSET = PIN2_bm; /* Set TXD to output */
+	USART0.BAUD = settings->baud_reg; /* Set baud rate */
+	/* Enable USART transmitter, in double-speed mode if planned */
+	USART0.CTRLB = USART_TXEN_bm | (settings->clk2x ? USART_RXMODE_CLK2X_gc : USART_RXMODE_NORMAL_gc);
+}
+
+/**********************************************************************************
+Switch the main clock and reconfigure the peripherals that depend on it.
+Returns 0 and keeps the current clock if no setting fits.
+**********************************************************************************/
+uint8_t clock_switch(uint8_t division)
+{
+	clock_plan_t settings;
+
+	if(!clock_plan(division, &settings))
+	{
+		return 0;
+	}
+
+	/* Let the last byte leave the transmitter before the clock changes.
+	TXCIF is cleared before every write, so it is set when the last byte is sent. */
+	if(usart_sending)
+	{
+		while(!(USART0.STATUS & USART_TXCIF_bm));
+		usart_sending = 0;
+	}
+
+	_PROTECTED_WRITE(CLKCTRL.MCLKCTRLB, settings.mclkctrlb);
+	adc_init(&settings);
+	usart_init(&settings);
+
+	plan = settings;
+	return 1;
+}
+
+/**********************************************************************************
+Send a 16-bit value via USART to Data Visualizer
+**********************************************************************************/
+void USART_send_DV(uint16_t value)
+{
+	usart_sending = 1;
+	while(!(USART0.STATUS & USART_DREIF_bm));
+	USART0.STATUS = USART_TXCIF_bm;
+	USART0.TXDATAL = 0x33; /* Send data stream start byte */
+	while(!(USART0.STATUS & USART_DREIF_bm));
+	USART0.STATUS = USART_TXCIF_bm;
+	USART0.TXDATAL = (uint8_t) value;
+	while(!(USART0.STATUS & USART_DREIF_bm));
+	USART0.STATUS = USART_TXCIF_bm;
+	USART0.TXDATAL = (uint8_t) (value >> 8);
+	while(!(USART0.STATUS & USART_DREIF_bm));
+	USART0.STATUS = USART_TXCIF_bm;
+	USART0.TXDATAL = ~0x33; /* Send data stream stop byte */
+}
+
+int main(void)
+{
+	if(!clock_switch(CLOCK_DIVISION))
+	{
+		while(1); /* No baud rate within the error budget, change the planner defines */
+	}
+
+	while(1)
+	{
+		ADC0.COMMAND |= ADC_START_IMMEDIATE_gc;     /* Start ADC conversion */
+		while(!(ADC0.INTFLAGS & ADC_SAMPRDY_bm));   /* Wait until conversion is done */
+
+		adc_reading = ADC0.SAMPLE; /* Read ADC sample, clears flag */
+
+		/* Stream the raw samples as fast as the link allows */
+		USART_send_DV(adc_reading);
+	}
+}
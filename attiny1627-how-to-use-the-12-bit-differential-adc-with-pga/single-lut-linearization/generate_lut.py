@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+"""
+    \\file   generate_lut.py
+
+    \\brief  Generates a flash-resident interpolation table from a sensor curve
+
+    Reads a CSV file with two columns, raw ADC code and value in engineering
+    units, and writes a C header with a PROGMEM table of evenly spaced
+    breakpoints. With evenly spaced breakpoints, the firmware finds the segment
+    by shifting the code, and interpolates with one multiplication and one shift.
+
+    The maximum error of the table compared to the curve in the CSV file is
+    printed, using linear interpolation between the CSV points as reference.
+    Outside the range of the CSV file, the curve is extrapolated from the first
+    and last segment.
+
+    Usage:
+        python3 generate_lut.py thermistor.csv lut.h --name thermistor
+                --input-bits 12 --segment-bits 5 --scale 100
+"""
+
+import argparse
+import csv
+import sys
+
+
+def read_curve(path):
+    points = []
+    with open(path, newline='') as f:
+        for row in csv.reader(f):
+            try:
+                points.append((float(row[0]), float(row[1])))
+            except (ValueError, IndexError):
+                continue  # Header or empty line
+    points.sort()
+    if len(points) < 2:
+        sys.exit('%s: at least two points are needed' % path)
+    return points
+
+
+def evaluate(points, code):
+    """Linear interpolation between the curve points, extrapolated from the end segments"""
+    segments = list(zip(points, points[1:]))
+    (x0, y0), (x1, y1) = segments[0] if code < points[0][0] else segments[-1]
+    for (a, b) in segments:
+        if a[0] <= code <= b[0]:
+            (x0, y0), (x1, y1) = a, b
+            break
+    return y0 + (y1 - y0) * (code - x0) / (x1 - x0)
+
+
+def lookup(table, shift, code):
+    """Same integer arithmetic as lut_lookup() in main.c"""
+    index = code >> shift
+    frac = code & ((1 << shift) - 1)
+    y0 = table[index]
+    y1 = table[index + 1]
+    return y0 + (((y1 - y0) * frac) >> shift)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Generate a PROGMEM interpolation table from a CSV curve')
+    parser.add_argument('input', help='CSV file with raw code and value columns')
+    parser.add_argument('output', help='C header to write')
+    parser.add_argument('--name', default='sensor', help='C identifier prefix')
+    parser.add_argument('--input-bits', type=int, default=12, help='Resolution of the raw code, e.g. 12, 16 or 17')
+    parser.add_argument('--segment-bits', type=int, default=5, help='log2 of the number of table segments')
+    parser.add_argument('--scale', type=float, default=1.0, help='Table unit is 1/scale of the CSV unit')
+    args = parser.parse_args()
+
+    if not 0 < args.segment_bits <= args.input_bits:
+        sys.exit('--segment-bits must be between 1 and --input-bits')
+
+    points = read_curve(args.input)
+    shift = args.input_bits - args.segment_bits
+    segments = 1 << args.segment_bits
+    # The last breakpoint is one past the highest code, so every code has a segment end to interpolate to
+    table = [int(round(evaluate(points, i << shift) * args.scale)) for i in range(segments + 1)]
+
+    if min(table) < -32768 or max(table) > 32767:
+        sys.exit('Scaled values do not fit in 16 bits, use a lower --scale')
+
+    worst_error = 0.0
+    worst_code = 0
+    # Only the range covered by the curve is compared
+    for code in range(int(points[0][0]), min(int(points[-1][0]), (1 << args.input_bits) - 1) + 1):
+        error = abs(lookup(table, shift, code) / args.scale - evaluate(points, code))
+        if error > worst_error:
+            worst_error = error
+            worst_code = code
+
+    name = args.name.upper()
+    with open(args.output, 'w') as f:
+        f.write('/*\n')
+        f.write(' * Generated by generate_lut.py from %s, do not edit.\n' % args.input)
+        f.write(' * %d segments, %d-bit input, values in 1/%g of the CSV unit.\n' % (segments, args.input_bits, args.scale))
+        f.write(' * Maximum error: %.4f at code %d.\n' % (worst_error, worst_code))
+        f.write(' */\n\n')
+        f.write('#ifndef %s_LUT_H\n#define %s_LUT_H\n\n' % (name, name))
+        f.write('#include <avr/pgmspace.h>\n\n')
+        f.write('#define %s_LUT_INPUT_BITS    %d\n' % (name, args.input_bits))
+        f.write('#define %s_LUT_SHIFT         %d\n' % (name, shift))
+        f.write('#define %s_LUT_SCALE         %g\n\n' % (name, args.scale))
+        f.write('static const int16_t %s_lut[%d] PROGMEM =\n{\n' % (args.name, segments + 1))
+        for i in range(0, len(table), 8):
+            f.write('\t' + ', '.join('%d' % v for v in table[i:i + 8]) + ',\n')
+        f.write('};\n\n#endif /* %s_LUT_H */\n' % name)
+
+    print('%s: %d segments, maximum error %.4f at code %d' % (args.output, segments, worst_error, worst_code))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,108 @@
+/*
+    \file   main.c
+
+    \brief  How To Use the 12-Bit Differential ADC in Single Mode
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+
+/*
+ *
+ * How To Use the 12-Bit Differential ADC in Single Mode:
+ * Lookup Table Linearization
+ *
+ */
+
+#define F_CPU 3333333ul
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <util/delay.h>
+#include <math.h>
+
+#include "thermistor_lut.h"
+
+#define TIMEBASE_VALUE ((uint8_t) ceil(F_CPU*0.000001))
+
+/* Volatile variables to improve debug experience */
+static volatile uint16_t adc_reading;
+static volatile int16_t temperature_in_centi_degC;
+
+/**********************************************************************************
+Lookup table linearization:
+The table holds 2^n + 1 evenly spaced breakpoints, so the segment is found by
+shifting the code, and the value is interpolated with one multiplication and one
+shift. The table is generated by generate_lut.py and is read directly from flash.
+Works for 12-, 16- and 17-bit codes, as long as shift matches the table.
+The difference of two breakpoints takes 17 bits, so the product only fits in 32
+bits up to a shift of 14. Larger shifts use a 64-bit product. The shift is a
+constant, so only one of the two branches is compiled.
+With the 12-bit table of this example, a lookup takes 17 instructions on an
+x86-64 host, as counted by host-tools/lut-linearization-test. The AVR takes more
+cycles, as it multiplies and shifts the 32-bit values one byte at a time.
+**********************************************************************************/
+static inline __attribute__((always_inline)) int16_t lut_lookup(const int16_t *table, uint8_t shift, uint32_t code)
+{
+	uint16_t index = code >> shift;
+	uint32_t frac = code & ((1UL << shift) - 1);
+	int16_t y0 = pgm_read_word(&table[index]);
+	int16_t y1 = pgm_read_word(&table[index + 1]);
+	int32_t delta = (int32_t) y1 - y0;
+
+	if(shift > 14)
+	{
+		return y0 + (int16_t) ((delta * (int64_t) frac) >> shift);
+	}
+	return y0 + (int16_t) ((delta * (int32_t) frac) >> shift);
+}
+
+/**********************************************************************************
+ADC initialization
+**********************************************************************************/
+void adc_init()
+{
+	ADC0.CTRLA = ADC_ENABLE_bm;
+	ADC0.CTRLB = ADC_PRESC_DIV2_gc; /* fCLK_ADC = 3.333333/2 MHz */
+	ADC0.CTRLC = ADC_REFSEL_VDD_gc | (TIMEBASE_VALUE << ADC_TIMEBASE_gp); /* The thermistor divider is supplied by VDD */
+	ADC0.CTRLE = 17; /* (SAMPDUR + 0.5) * fCLK_ADC = 10.5 µs sample duration */
+
+	ADC0.MUXPOS = ADC_MUXPOS_AIN6_gc; /* ADC channel AIN6 -> PA6 */
+	ADC0.COMMAND = ADC_MODE_SINGLE_12BIT_gc; /* Single 12-bit mode */
+}
+
+int main(void)
+{
+	adc_init();
+
+	while(1)
+	{
+		ADC0.COMMAND |= ADC_START_IMMEDIATE_gc;     /* Start ADC conversion */
+		while(!(ADC0.INTFLAGS & ADC_RESRDY_bm));   /* Wait until conversion is done */
+
+		adc_reading = ADC0.RESULT; /* Read ADC result, clears the interrupt flag */
+		/* Convert to temperature in 1/100 degC using the thermistor curve */
+		temperature_in_centi_degC = lut_lookup(thermistor_lut, THERMISTOR_LUT_SHIFT, adc_reading);
+
+		_delay_ms(500);
+	}
+}
@@ -0,0 +1,37 @@
+/*
+ * Generated by generate_lut.py from thermistor.csv, do not edit.
+ * 128 segments, 12-bit input, values in 1/100 of the CSV unit.
+ * Maximum error: 0.2700 at code 181.
+ */
+
+#ifndef THERMISTOR_LUT_H
+#define THERMISTOR_LUT_H
+
+#include <avr/pgmspace.h>
+
+#define THERMISTOR_LUT_INPUT_BITS    12
+#define THERMISTOR_LUT_SHIFT         5
+#define THERMISTOR_LUT_SCALE         100
+
+static const int16_t thermistor_lut[129] PROGMEM =
+{
+	16444, 15556, 14667, 13778, 12889, 12000, 11280, 10679,
+	10167, 9724, 9333, 8980, 8667, 8377, 8115, 7871,
+	7643, 7426, 7228, 7031, 6856, 6686, 6516, 6366,
+	6218, 6069, 5932, 5804, 5676, 5548, 5429, 5316,
+	5202, 5089, 4978, 4878, 4778, 4678, 4578, 4480,
+	4390, 4301, 4211, 4121, 4031, 3946, 3864, 3782,
+	3700, 3618, 3536, 3457, 3382, 3306, 3230, 3154,
+	3078, 3002, 2930, 2859, 2787, 2715, 2643, 2572,
+	2500, 2430, 2361, 2291, 2222, 2152, 2083, 2013,
+	1944, 1875, 1806, 1737, 1668, 1599, 1530, 1461,
+	1390, 1320, 1250, 1180, 1110, 1039, 968, 894,
+	820, 747, 673, 599, 525, 448, 368, 289,
+	209, 129, 50, -33, -122, -210, -298, -387,
+	-475, -573, -674, -775, -877, -978, -1093, -1213,
+	-1332, -1451, -1586, -1730, -1874, -2022, -2200, -2378,
+	-2571, -2800, -3036, -3327, -3659, -4049, -4439, -4829,
+	-5220,
+};
+
+#endif /* THERMISTOR_LUT_H */
@@ -0,0 +1,168 @@
+/*
+    \file   main.c
+
+    \brief  How To Use the 12-Bit Differential ADC in Single Mode
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+
+/*
+ *
+ * How To Use the 12-Bit Differential ADC in Single Mode:
+ * Ratiometric measurements with VDD tracking
+ *
+ */
+
+#define F_CPU 3333333ul
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <stdbool.h>
+#include <math.h>
+
+#define TIMEBASE_VALUE ((uint8_t) ceil(F_CPU*0.000001))
+#define ADC_MAX_VALUE   ((1 << 12) - 1) /* In single-ended mode, the max value is 4095 */
+
+/* Number of input conversions between two VDD measurements.
+   A lower value tracks VDD faster, a higher value gives more input conversions per second. */
+#define RATIOMETRIC_INTERLEAVE  16
+
+/* VDD used until the first VDD measurement is done */
+#define VDD_DEFAULT_MV          3300
+
+typedef enum
+{
+	CONVERSION_INPUT,
+	CONVERSION_VDD_SETTLE,
+	CONVERSION_VDD
+} conversion_t;
+
+static volatile conversion_t conversion;
+static volatile uint16_t vdd_mV = VDD_DEFAULT_MV;
+static volatile uint16_t input_reading;
+static volatile bool input_ready;
+
+/* Volatile variables to improve debug experience */
+static volatile uint16_t adc_reading;
+static volatile uint16_t voltage_mV;
+
+/**********************************************************************************
+Configure the ADC to measure the input, referenced to VDD
+**********************************************************************************/
+static void adc_select_input(void)
+{
+	ADC0.CTRLC = ADC_REFSEL_VDD_gc | (TIMEBASE_VALUE << ADC_TIMEBASE_gp);
+	ADC0.MUXPOS = ADC_MUXPOS_AIN6_gc; /* ADC channel AIN6 -> PA6 */
+	conversion = CONVERSION_INPUT;
+}
+
+/**********************************************************************************
+Configure the ADC to measure VDD/10, referenced to the internal 1.024V reference
+**********************************************************************************/
+static void adc_select_vdd(void)
+{
+	ADC0.CTRLC = ADC_REFSEL_1024MV_gc | (TIMEBASE_VALUE << ADC_TIMEBASE_gp);
+	ADC0.MUXPOS = ADC_MUXPOS_VDDDIV10_gc; /* ADC channel VDD/10 */
+	conversion = CONVERSION_VDD_SETTLE;
+}
+
+/**********************************************************************************
+ADC initialization
+**********************************************************************************/
+void adc_init()
+{
+	ADC0.CTRLA = ADC_ENABLE_bm;
+	ADC0.CTRLB = ADC_PRESC_DIV2_gc; /* fCLK_ADC = 3.333333/2 MHz */
+	ADC0.CTRLE = 17; /* (SAMPDUR + 0.5) * fCLK_ADC = 10.5 µs sample duration */
+	ADC0.INTCTRL = ADC_RESRDY_bm; /* Enable Result Ready interrupt */
+
+	adc_select_vdd(); /* Start with a VDD measurement */
+	ADC0.COMMAND = ADC_MODE_SINGLE_12BIT_gc; /* Single 12-bit mode */
+}
+
+/***********************************************************************************
+Result Ready interrupt:
+Schedules the conversions back-to-back. After every RATIOMETRIC_INTERLEAVE input
+conversions, VDD/10 is measured against the internal reference. The first
+conversion after switching reference is discarded, since the internal reference
+needs time to settle.
+***********************************************************************************/
+ISR(ADC0_RESRDY_vect)
+{
+	static uint8_t input_count;
+	uint16_t result = ADC0.RESULT; /* Read ADC result, clears the interrupt flag */
+
+	switch(conversion)
+	{
+	case CONVERSION_INPUT:
+		input_reading = result;
+		input_ready = true;
+		if(++input_count >= RATIOMETRIC_INTERLEAVE)
+		{
+			input_count = 0;
+			adc_select_vdd();
+		}
+		break;
+
+	case CONVERSION_VDD_SETTLE:
+		conversion = CONVERSION_VDD;
+		break;
+
+	case CONVERSION_VDD:
+		/* VDD = result * 1.024V * 10 / 4095, in mV */
+		vdd_mV = ((uint32_t) result * 10240 + ADC_MAX_VALUE / 2) / ADC_MAX_VALUE;
+		adc_select_input();
+		break;
+	}
+
+	ADC0.COMMAND |= ADC_START_IMMEDIATE_gc; /* Start next conversion */
+}
+
+int main(void)
+{
+	uint16_t reading;
+	uint16_t vdd;
+
+	adc_init();
+	sei(); /* Enable global interrupts */
+
+	ADC0.COMMAND |= ADC_START_IMMEDIATE_gc; /* Start the first conversion, the rest are started by the ISR */
+
+	while(1)
+	{
+		if(input_ready)
+		{
+			ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+			{
+				reading = input_reading;
+				vdd = vdd_mV;
+				input_ready = false;
+			}
+
+			adc_reading = reading;
+			/* Calculate voltage on ADC pin using the measured VDD, 12-bit resolution */
+			voltage_mV = ((uint32_t) reading * vdd + ADC_MAX_VALUE / 2) / ADC_MAX_VALUE;
+		}
+	}
+}
@@ -0,0 +1,304 @@
+/*
+    \file   main.c
+
+    \brief  How To Use the 12-Bit Differential ADC in Single Mode
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+
+/*
+ *
+ * How To Use the 12-Bit Differential ADC in Single Mode:
+ * Statistics
+ *
+ */
+
+#define F_CPU 3333333ul
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <util/delay.h>
+#include <math.h>
+
+#define TIMEBASE_VALUE      ((uint8_t) ceil(F_CPU*0.000001))
+#define BAUD_RATE           9600
+#define BAUD_REG_VAL        ((float)(64 * F_CPU / (16 * (float)BAUD_RATE)) + 0.5)
+
+/* Defines to easily configure RTC event frequency */
+#define ADC_SAMPLING_FREQ   1024    /* Hz, shared by all channels */
+#define RTC_CLOCK           32768   /* Hz */
+#define RTC_PERIOD          (RTC_CLOCK / ADC_SAMPLING_FREQ)
+
+/* Channels included in the statistics */
+#define STAT_CHANNELS       2
+static const uint8_t channel_muxpos[STAT_CHANNELS] =
+{
+	ADC_MUXPOS_VDDDIV10_gc,     /* Channel 0: VDD/10 */
+	ADC_MUXPOS_AIN6_gc          /* Channel 1: AIN6 -> PA6 */
+};
+
+/* The sums are exact as long as the count does not exceed this value */
+#define STAT_MAX_COUNT      0xFFFF
+
+typedef struct
+{
+	uint16_t count;
+	uint16_t min;
+	uint16_t max;
+	uint32_t sum;
+	uint64_t sum_squares;
+} stat_accumulator_t;
+
+/* Statistics in ADC codes, fixed point with 4 fractional bits. All values are 0 when count is 0 */
+typedef struct
+{
+	uint16_t count;
+	uint16_t min;
+	uint16_t max;
+	uint16_t mean_q4;
+	uint16_t stddev_q4;
+	uint16_t rms_q4;
+} stat_summary_t;
+
+static volatile stat_accumulator_t accumulators[STAT_CHANNELS];
+
+/* Volatile variables to improve debug experience */
+static volatile stat_summary_t summaries[STAT_CHANNELS];
+
+/******************************************************************************
+EVSYS initialization:
+Channel 0:
+            Event system generator: RTC Overflow
+            Event system user: ADC0
+*******************************************************************************/
+void event_system_init(void)
+{
+	EVSYS.CHANNEL0 = EVSYS_CHANNEL0_RTC_OVF_gc;     /* RTC Overflow ->  Channel 0 */
+	EVSYS.USERADC0START = EVSYS_USER_CHANNEL0_gc;   /* Channel 0    ->  ADC0 Start */
+}
+
+/*********************************************************************************
+RTC initialization
+**********************************************************************************/
+void rtc_init(void)
+{
+	while(RTC.STATUS > 0);  /* Wait for all registers to be synchronized */
+	RTC.CTRLA = RTC_PRESCALER_DIV1_gc | RTC_RTCEN_bm; /* Enable RTC, no prescaler */
+	RTC.CLKSEL = RTC_CLKSEL_INT32K_gc; /* Select 32.768 kHz internal RC oscillator */
+	RTC.PER = RTC_PERIOD;
+	while(RTC.STATUS > 0);  /* Wait for all registers to be synchronized */
+}
+
+/**********************************************************************************
+ADC initialization
+**********************************************************************************/
+void adc_init()
+{
+	ADC0.CTRLA = ADC_ENABLE_bm;
+	ADC0.CTRLB = ADC_PRESC_DIV2_gc; /* fCLK_ADC = 3.333333/2 MHz */
+	ADC0.CTRLC = ADC_REFSEL_1024MV_gc | (TIMEBASE_VALUE << ADC_TIMEBASE_gp);
+	ADC0.CTRLE = 17; /* (SAMPDUR + 0.5) * fCLK_ADC = 10.5 µs sample duration */
+	ADC0.INTCTRL = ADC_RESRDY_bm; /* Enable Result Ready interrupt */
+
+	ADC0.MUXPOS = channel_muxpos[0];
+	/* Start ADC conversion on event trigger */
+	ADC0.COMMAND = ADC_MODE_SINGLE_12BIT_gc | ADC_START_EVENT_TRIGGER_gc;
+}
+
+/**********************************************************************************
+USART initialization
+**********************************************************************************/
+void usart_init()
+{
+	PORTB.DIRSET = PIN2_bm; /* Set TXD to output */
+	USART0.CTRLB = USART_TXEN_bm; /* Enable USART transmitter */
+	USART0.BAUD = BAUD_REG_VAL; /* Set baud rate */
+}
+
+static void usart_send_byte(uint8_t data)
+{
+	while(!(USART0.STATUS & USART_DREIF_bm));
+	USART0.TXDATAL = data;
+}
+
+/**********************************************************************************
+Send a statistics summary frame via USART:
+Start byte, channel, the summary as 16-bit little endian values, stop byte
+**********************************************************************************/
+void usart_send_summary(uint8_t channel, const stat_summary_t *summary)
+{
+	const uint16_t fields[] = { summary->count, summary->min, summary->max,
+	                            summary->mean_q4, summary->stddev_q4, summary->rms_q4 };
+
+	usart_send_byte(0x33); /* Send data stream start byte */
+	usart_send_byte(channel);
+	for(uint8_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++)
+	{
+		usart_send_byte((uint8_t) fields[i]);
+		usart_send_byte((uint8_t) (fields[i] >> 8));
+	}
+	usart_send_byte(~0x33); /* Send data stream stop byte */
+}
+
+/**********************************************************************************
+Add one sample to the statistics. Constant cost: one 16x16-bit multiplication and
+a few additions, no division. Instead of updating the mean and variance for every
+sample, the exact sums are kept, and mean and variance are calculated when the
+statistics are read.
+**********************************************************************************/
+static inline void stat_update(volatile stat_accumulator_t *acc, uint16_t sample)
+{
+	if(acc->count == 0)
+	{
+		acc->min = sample;
+		acc->max = sample;
+	}
+	else
+	{
+		if(sample < acc->min) acc->min = sample;
+		if(sample > acc->max) acc->max = sample;
+	}
+
+	if(acc->count < STAT_MAX_COUNT)
+	{
+		acc->count++;
+		acc->sum += sample;
+		acc->sum_squares += (uint32_t) sample * sample;
+	}
+}
+
+/**********************************************************************************
+Integer square root, rounded down
+**********************************************************************************/
+static uint32_t isqrt64(uint64_t value)
+{
+	uint64_t root = 0;
+	uint64_t bit = (uint64_t) 1 << 62;
+
+	while(bit > value)
+	{
+		bit >>= 2;
+	}
+	while(bit != 0)
+	{
+		if(value >= root + bit)
+		{
+			value -= root + bit;
+			root = (root >> 1) + bit;
+		}
+		else
+		{
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint32_t) root;
+}
+
+/**********************************************************************************
+Read and clear the statistics of a channel in one atomic step, so no sample is
+counted twice or lost, and calculate the summary. The calculations are done
+outside the atomic block to keep the interrupt latency low.
+
+    mean     = sum / n
+    variance = (n * sum_squares - sum^2) / n^2
+    rms      = sqrt(sum_squares / n)
+**********************************************************************************/
+void stat_read_and_reset(uint8_t channel, stat_summary_t *summary)
+{
+	stat_accumulator_t acc;
+
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		acc = accumulators[channel];
+		accumulators[channel].count = 0;
+		accumulators[channel].sum = 0;
+		accumulators[channel].sum_squares = 0;
+	}
+
+	summary->count = acc.count;
+	summary->min = acc.min;
+	summary->max = acc.max;
+
+	if(acc.count == 0)
+	{
+		/* min and max still hold the samples of an earlier summary */
+		summary->min = 0;
+		summary->max = 0;
+		summary->mean_q4 = 0;
+		summary->stddev_q4 = 0;
+		summary->rms_q4 = 0;
+		return;
+	}
+
+	/* The sums are exact, so the subtraction does not lose precision */
+	uint64_t variance_n2 = (uint64_t) acc.count * acc.sum_squares - (uint64_t) acc.sum * acc.sum;
+
+	summary->mean_q4 = ((acc.sum << 4) + acc.count / 2) / acc.count;
+	summary->stddev_q4 = ((uint64_t) isqrt64(variance_n2) << 4) / acc.count;
+	summary->rms_q4 = isqrt64((acc.sum_squares << 8) / acc.count);
+}
+
+/***********************************************************************************
+Result Ready interrupt:
+Adds the result to the statistics of the current channel, and selects the next
+channel for the next event trigger.
+***********************************************************************************/
+ISR(ADC0_RESRDY_vect)
+{
+	static uint8_t channel;
+	uint16_t result = ADC0.RESULT; /* Read ADC result, clears the interrupt flag */
+
+	stat_update(&accumulators[channel], result);
+
+	if(++channel >= STAT_CHANNELS)
+	{
+		channel = 0;
+	}
+	ADC0.MUXPOS = channel_muxpos[channel];
+}
+
+int main(void)
+{
+	stat_summary_t summary;
+
+	event_system_init();
+	rtc_init();
+	adc_init();
+	usart_init();
+	sei(); /* Enable global interrupts */
+
+	while(1)
+	{
+		_delay_ms(500);
+
+		/* Send one summary per channel instead of all the samples */
+		for(uint8_t channel = 0; channel < STAT_CHANNELS; channel++)
+		{
+			stat_read_and_reset(channel, &summary);
+			summaries[channel] = summary;
+			usart_send_summary(channel, &summary);
+		}
+	}
+}
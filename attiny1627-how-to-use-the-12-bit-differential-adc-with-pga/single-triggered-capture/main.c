@@ -0,0 +1,228 @@
+/*
+    \file   main.c
+
+    \brief  How To Use the 12-Bit Differential ADC in Single Mode
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+
+/*
+ *
+ * How To Use the 12-Bit Differential ADC in Single Mode:
+ * Triggered Capture
+ *
+ */
+
+/* The capture runs at 10 MHz: the 20 MHz oscillator (fuse default) divided by 2 */
+#define F_CPU 10000000ul
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <math.h>
+
+#define TIMEBASE_VALUE      ((uint8_t) ceil(F_CPU*0.000001))
+#define BAUD_RATE           115200
+#define BAUD_REG_VAL        ((float)(64 * F_CPU / (16 * (float)BAUD_RATE)) + 0.5)
+
+/* Defines to easily configure the capture window */
+#define CAPTURE_DEPTH       512     /* Samples in the ring buffer, must be a power of two */
+#define CAPTURE_POST        128     /* Samples stored after the trigger sample */
+#define CAPTURE_PRE         (CAPTURE_DEPTH - CAPTURE_POST - 1) /* Samples stored before the trigger sample */
+#define CAPTURE_RAM_BUDGET  1536    /* Bytes of the 2 KB SRAM the ring buffer may use */
+
+_Static_assert((CAPTURE_DEPTH & (CAPTURE_DEPTH - 1)) == 0, "CAPTURE_DEPTH must be a power of two");
+_Static_assert(CAPTURE_DEPTH * sizeof(uint16_t) <= CAPTURE_RAM_BUDGET, "Ring buffer does not fit in SRAM");
+_Static_assert(CAPTURE_POST > 0 && CAPTURE_POST < CAPTURE_DEPTH, "CAPTURE_POST must be between 1 and CAPTURE_DEPTH - 1");
+
+/* Trigger level: a sample above this value triggers the capture */
+#define TRIGGER_THRESHOLD   3000
+
+typedef enum
+{
+	CAPTURE_FILLING,    /* Collecting the pre-trigger history, trigger ignored */
+	CAPTURE_ARMED,      /* Waiting for the trigger */
+	CAPTURE_TRIGGERED,  /* Collecting the post-trigger samples */
+	CAPTURE_DONE        /* Ring buffer frozen, ready to be sent */
+} capture_state_t;
+
+static uint16_t capture_buffer[CAPTURE_DEPTH];
+static uint16_t capture_head;       /* Index of the next sample to write */
+static uint16_t capture_remaining;  /* Samples left before the state changes */
+
+/* Volatile variables to improve debug experience */
+static volatile capture_state_t capture_state;
+static volatile uint16_t capture_count;
+
+/**********************************************************************************
+Clock initialization
+**********************************************************************************/
+void clock_init()
+{
+	/* Main clock = 20 MHz / 2 = 10 MHz */
+	_PROTECTED_WRITE(CLKCTRL.MCLKCTRLB, CLKCTRL_PDIV_2X_gc | CLKCTRL_PEN_bm);
+}
+
+/**********************************************************************************
+ADC initialization
+**********************************************************************************/
+void adc_init()
+{
+	ADC0.CTRLA = ADC_ENABLE_bm;
+	ADC0.CTRLB = ADC_PRESC_DIV4_gc; /* fCLK_ADC = 10/4 MHz */
+	ADC0.CTRLC = ADC_REFSEL_VDD_gc | (TIMEBASE_VALUE << ADC_TIMEBASE_gp);
+	ADC0.CTRLE = 17; /* (SAMPDUR + 0.5) / fCLK_ADC = 7 µs sample duration */
+	ADC0.CTRLF = ADC_FREERUN_bm; /* Start a new conversion as soon as one is done */
+
+	ADC0.MUXPOS = ADC_MUXPOS_AIN6_gc; /* ADC channel AIN6 -> PA6 */
+
+	ADC0.WINHT = TRIGGER_THRESHOLD; /* Window High Threshold */
+	/* Window Comparator mode: Above. Use SAMPLE register as Window Comparator source */
+	ADC0.CTRLD = ADC_WINCM_ABOVE_gc | ADC_WINSRC_SAMPLE_gc;
+	ADC0.INTCTRL = ADC_RESRDY_bm; /* Enable Result Ready interrupt, WCMP is polled */
+}
+
+/**********************************************************************************
+USART initialization
+**********************************************************************************/
+void usart_init()
+{
+	PORTB.DIRSET = PIN2_bm; /* Set TXD to output */
+	USART0.CTRLB = USART_TXEN_bm; /* Enable USART transmitter */
+	USART0.BAUD = BAUD_REG_VAL; /* Set baud rate */
+}
+
+static void usart_send_byte(uint8_t data)
+{
+	while(!(USART0.STATUS & USART_DREIF_bm));
+	USART0.TXDATAL = data;
+}
+
+static void usart_send_word(uint16_t data)
+{
+	usart_send_byte((uint8_t) data);
+	usart_send_byte((uint8_t) (data >> 8));
+}
+
+/**********************************************************************************
+Send the frozen capture via USART:
+Start byte, number of samples, index of the trigger sample, the samples oldest
+first as 16-bit little endian values, stop byte
+**********************************************************************************/
+void usart_send_capture()
+{
+	uint16_t index = capture_head; /* The oldest sample is overwritten next */
+
+	usart_send_byte(0x33); /* Send data stream start byte */
+	usart_send_word(CAPTURE_DEPTH);
+	usart_send_word(CAPTURE_PRE);
+	for(uint16_t i = 0; i < CAPTURE_DEPTH; i++)
+	{
+		usart_send_word(capture_buffer[index]);
+		index = (index + 1) & (CAPTURE_DEPTH - 1);
+	}
+	usart_send_byte(~0x33); /* Send data stream stop byte */
+}
+
+/**********************************************************************************
+Start a new capture. The trigger is ignored until the pre-trigger part of the
+ring buffer holds samples from this capture.
+**********************************************************************************/
+void capture_arm()
+{
+	capture_head = 0;
+	capture_remaining = CAPTURE_PRE + 1;
+	capture_state = CAPTURE_FILLING;
+
+	ADC0.INTFLAGS = ADC_RESRDY_bm | ADC_WCMP_bm;
+	ADC0.COMMAND = ADC_MODE_SINGLE_12BIT_gc | ADC_START_IMMEDIATE_gc;
+}
+
+/***********************************************************************************
+Result Ready interrupt:
+Stores the result in the ring buffer. When a sample above the threshold is found,
+CAPTURE_POST more samples are stored before the ADC is stopped and the buffer is
+frozen. The ISR is kept short, since a new result is ready every 12.2 µs.
+***********************************************************************************/
+ISR(ADC0_RESRDY_vect)
+{
+	uint8_t flags = ADC0.INTFLAGS;
+	uint16_t head = capture_head;
+
+	if(capture_state == CAPTURE_DONE)
+	{
+		/* A conversion finished while stopping, keep the frozen buffer */
+		ADC0.INTFLAGS = ADC_RESRDY_bm | ADC_WCMP_bm;
+		return;
+	}
+
+	capture_buffer[head] = ADC0.RESULT; /* Read ADC result, clears the interrupt flag */
+	capture_head = (head + 1) & (CAPTURE_DEPTH - 1);
+	ADC0.INTFLAGS = ADC_WCMP_bm; /* Clear WCMP flag */
+
+	switch(capture_state)
+	{
+	case CAPTURE_FILLING:
+		if(--capture_remaining == 0)
+		{
+			capture_state = CAPTURE_ARMED;
+		}
+		break;
+	case CAPTURE_ARMED:
+		if(flags & ADC_WCMP_bm)
+		{
+			capture_remaining = CAPTURE_POST;
+			capture_state = CAPTURE_TRIGGERED;
+		}
+		break;
+	case CAPTURE_TRIGGERED:
+		if(--capture_remaining == 0)
+		{
+			ADC0.COMMAND = ADC_START_STOP_gc; /* Stop free-running conversions */
+			capture_state = CAPTURE_DONE;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+int main(void)
+{
+	clock_init();
+	adc_init();
+	usart_init();
+	sei(); /* Enable global interrupts */
+
+	capture_arm();
+
+	while(1)
+	{
+		if(capture_state == CAPTURE_DONE)
+		{
+			/* The ADC is stopped, so the buffer can be read without an atomic block */
+			usart_send_capture();
+			capture_count++;
+			capture_arm();
+		}
+	}
+}
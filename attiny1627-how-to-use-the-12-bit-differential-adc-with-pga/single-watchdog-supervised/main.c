@@ -0,0 +1,187 @@
+/*
+    \file   main.c
+
+    \brief  How To Use the 12-Bit Differential ADC in Single Mode
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+
+/*
+ *
+ * How To Use the 12-Bit Differential ADC in Single Mode:
+ * Watchdog-Supervised Acquisition
+ *
+ */
+
+#define F_CPU 3333333ul
+
+#include <avr/io.h>
+#include <avr/wdt.h>
+#include <util/delay.h>
+#include <math.h>
+
+#define TIMEBASE_VALUE      ((uint8_t) ceil(F_CPU*0.000001))
+#define ADC_MAX_VALUE       ((1 << 12) - 1) /* In single-ended mode, the max value is 4095 */
+
+/* Defines to easily configure the supervision */
+#define ADC_TIMEOUT_US      100     /* A conversion takes ~18 µs, this allows for the PGA and reference start-up */
+/* Each poll takes at least 4 CPU cycles, so the real timeout is at least ADC_TIMEOUT_US */
+#define ADC_TIMEOUT_POLLS   ((uint16_t) ceil(F_CPU*0.000001 * ADC_TIMEOUT_US / 4))
+#define ADC_MAX_RETRIES     3       /* Consecutive timeouts before the watchdog resets the device */
+
+typedef enum
+{
+	ADC_OK,
+	ADC_TIMEOUT
+} adc_status_t;
+
+typedef struct
+{
+	uint32_t conversions;           /* Successful conversions */
+	uint16_t timeouts;              /* Conversions that did not complete in time */
+	uint16_t reinits;               /* ADC re-initializations after a timeout */
+	uint8_t consecutive_timeouts;   /* Timeouts since the last successful conversion */
+	uint8_t watchdog_resets;        /* Watchdog resets since power-on or brown-out */
+} acquisition_stats_t;
+
+/* Not cleared at startup, so the number of watchdog resets survives the reset */
+static uint8_t watchdog_reset_count __attribute__((section(".noinit")));
+
+/* Volatile variables to improve debug experience */
+static volatile acquisition_stats_t stats;
+static volatile uint16_t adc_reading;
+static volatile float voltage;
+
+/**********************************************************************************
+ADC initialization
+**********************************************************************************/
+void adc_init()
+{
+	ADC0.CTRLA = ADC_ENABLE_bm;
+	ADC0.CTRLB = ADC_PRESC_DIV2_gc; /* fCLK_ADC = 3.333333/2 MHz */
+	ADC0.CTRLC = ADC_REFSEL_1024MV_gc | (TIMEBASE_VALUE << ADC_TIMEBASE_gp);
+	ADC0.CTRLE = 17; /* (SAMPDUR + 0.5) * fCLK_ADC = 10.5 µs sample duration */
+
+	ADC0.MUXPOS = ADC_MUXPOS_VDDDIV10_gc; /* ADC channel VDD/10 */
+	ADC0.COMMAND = ADC_MODE_SINGLE_12BIT_gc; /* Single 12-bit mode */
+}
+
+/**********************************************************************************
+Disable the ADC, clear its flags and configure it again
+**********************************************************************************/
+void adc_reinit()
+{
+	ADC0.COMMAND = ADC_START_STOP_gc; /* Stop an ongoing conversion */
+	ADC0.CTRLA = 0;
+	ADC0.INTFLAGS = ADC0.INTFLAGS; /* Clear all flags */
+	adc_init();
+	stats.reinits++;
+}
+
+/**********************************************************************************
+Watchdog initialization: counts watchdog resets, and starts the watchdog with a
+period of ~1 s
+**********************************************************************************/
+void watchdog_init()
+{
+	if(RSTCTRL.RSTFR & (RSTCTRL_PORF_bm | RSTCTRL_BORF_bm))
+	{
+		watchdog_reset_count = 0; /* The .noinit variable is undefined after power-on or brown-out */
+	}
+	else if(RSTCTRL.RSTFR & RSTCTRL_WDRF_bm)
+	{
+		watchdog_reset_count++;
+	}
+	RSTCTRL.RSTFR = RSTCTRL.RSTFR; /* Clear reset flags */
+	stats.watchdog_resets = watchdog_reset_count;
+
+	wdt_enable(WDT_PERIOD_1KCLK_gc);
+}
+
+/**********************************************************************************
+Wait for an ADC flag, at most ADC_TIMEOUT_US. In the healthy case, the only
+extra cost compared to a plain busy-wait is decrementing the counter.
+**********************************************************************************/
+adc_status_t adc_wait(uint8_t flag)
+{
+	uint16_t polls = ADC_TIMEOUT_POLLS;
+
+	while(!(ADC0.INTFLAGS & flag))
+	{
+		if(--polls == 0)
+		{
+			return ADC_TIMEOUT;
+		}
+	}
+	return ADC_OK;
+}
+
+/**********************************************************************************
+Start a conversion and read the result, with a bounded wait. On a timeout, the
+fault is counted and the ADC is initialized again.
+**********************************************************************************/
+adc_status_t adc_convert(uint16_t *result)
+{
+	ADC0.COMMAND |= ADC_START_IMMEDIATE_gc; /* Start ADC conversion */
+
+	if(adc_wait(ADC_RESRDY_bm) != ADC_OK)
+	{
+		stats.timeouts++;
+		stats.consecutive_timeouts++;
+		adc_reinit();
+		return ADC_TIMEOUT;
+	}
+
+	*result = ADC0.RESULT; /* Read ADC result, clears flag */
+	stats.conversions++;
+	stats.consecutive_timeouts = 0;
+	return ADC_OK;
+}
+
+int main(void)
+{
+	uint16_t result;
+
+	watchdog_init();
+	adc_init();
+
+	while(1)
+	{
+		if(adc_convert(&result) == ADC_OK)
+		{
+			adc_reading = result;
+			/* Calculate VDD, VREF = 1.024V, 12-bit resolution.
+			   Multiplied by 10 because the input channel is VDD/10. */
+			voltage = (float)(adc_reading * 1.024 * 10) / ADC_MAX_VALUE;
+		}
+
+		/* Only reset the watchdog while the ADC works or may still recover.
+		   After ADC_MAX_RETRIES failed re-initializations, the watchdog resets the device. */
+		if(stats.consecutive_timeouts < ADC_MAX_RETRIES)
+		{
+			wdt_reset();
+		}
+
+		_delay_ms(100);
+	}
+}
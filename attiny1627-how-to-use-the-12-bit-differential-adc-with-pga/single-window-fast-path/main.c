@@ -0,0 +1,224 @@
+/*
+    \file   main.c
+
+    \brief  How To Use the 12-Bit Differential ADC in Single Mode
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+
+/*
+ *
+ * How To Use the 12-Bit Differential ADC in Single Mode:
+ * Window Comparator Fast Path
+ *
+ */
+
+#define F_CPU 3333333ul
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <math.h>
+
+#define TIMEBASE_VALUE      ((uint8_t) ceil(F_CPU*0.000001))
+#define ADC_MAX_VALUE       ((1 << 12) - 1) /* In single-ended mode, the max value is 4095 */
+
+/* Trip when a sample is above TRIP_THRESHOLD, re-arm when the signal is back below TRIP_RELEASE */
+#define TRIP_THRESHOLD      3000
+#define TRIP_RELEASE        2800
+
+/*
+ * 1: The window compare event sets an SR latch in the CCL, which drives PA4 without the CPU.
+ * 0: The interrupt handler converts the sample to a voltage and drives PA4, as in the
+ *    single-window-comparator example. Use this to compare the latency of the two paths.
+ */
+#ifndef FAST_PATH
+#define FAST_PATH           1
+#endif
+
+/* Volatile variables to improve debug experience */
+static volatile uint16_t trip_count;
+static volatile uint16_t trip_sample;
+static volatile uint16_t trip_latency;      /* CLK_PER cycles from the first window compare event of the trip to the handler being done */
+static volatile uint16_t trip_latency_max;
+static volatile uint8_t tripped;
+#if !FAST_PATH
+static volatile float voltage;
+#endif
+
+/*********************************************************************************
+Event System initialization:
+Channel 0:
+            Event system generator: ADC0 Window Compare
+            Event system users: CCL LUT0 input A (set input of the latch)
+                                EVOUTA (PIN PA2), the raw compare event
+Channel 1:
+            Event system generator: Software event
+            Event system user: CCL LUT1 input A (reset input of the latch)
+Channel 2:
+            Event system generator: CCL LUT0 output (the latch)
+            Event system user: TCB0 capture (time stamp of the first compare event)
+**********************************************************************************/
+void evsys_init()
+{
+	PORTA.DIRSET = PIN2_bm; /* Configure EVOUTA to output */
+
+	EVSYS.CHANNEL0 = EVSYS_CHANNEL0_ADC0_WCMP_gc;    /* ADC0 Window Compare -> Channel 0 */
+	EVSYS.USERCCLLUT0A = EVSYS_USER_CHANNEL0_gc;     /* Channel 0 -> CCL LUT0 input A */
+	EVSYS.USEREVSYSEVOUTA = EVSYS_USER_CHANNEL0_gc;  /* Channel 0 -> EVOUTA (PA2) */
+
+	/* Channel 1 is only used by software events, it has no generator */
+	EVSYS.USERCCLLUT1A = EVSYS_USER_CHANNEL1_gc;     /* Channel 1 -> CCL LUT1 input A */
+
+	/*
+	 * The free-running conversions above the threshold give a compare event every
+	 * conversion, and each would overwrite the capture before the handler reads it.
+	 * The latch only rises on the first one, so TCB0 captures once per trip, and
+	 * is armed again when trip_rearm() resets the latch.
+	 */
+	EVSYS.CHANNEL2 = EVSYS_CHANNEL2_CCL_LUT0_gc;     /* CCL LUT0 output -> Channel 2 */
+	EVSYS.USERTCB0CAPT = EVSYS_USER_CHANNEL2_gc;     /* Channel 2 -> TCB0 capture */
+}
+
+/*********************************************************************************
+CCL initialization:
+LUT0 and LUT1 follow their event input A, and the sequencer makes an SR latch of
+them: LUT0 sets the latch and LUT1 resets it. With FAST_PATH, the latch output is
+LUT0 OUT (PA4). Without FAST_PATH, the latch only triggers the TCB0 capture, and
+the interrupt handler drives PA4.
+**********************************************************************************/
+void ccl_init()
+{
+	PORTA.DIRSET = PIN4_bm; /* Configure LUT0 OUT to output */
+
+	CCL.LUT0CTRLB = CCL_INSEL0_EVENTA_gc | CCL_INSEL1_MASK_gc;
+	CCL.LUT0CTRLC = CCL_INSEL2_MASK_gc;
+	CCL.TRUTH0 = 0x02; /* Output is high when input 0 is high */
+#if FAST_PATH
+	CCL.LUT0CTRLA = CCL_OUTEN_bm | CCL_ENABLE_bm;
+#else
+	CCL.LUT0CTRLA = CCL_ENABLE_bm;
+#endif
+
+	CCL.LUT1CTRLB = CCL_INSEL0_EVENTA_gc | CCL_INSEL1_MASK_gc;
+	CCL.LUT1CTRLC = CCL_INSEL2_MASK_gc;
+	CCL.TRUTH1 = 0x02; /* Output is high when input 0 is high */
+	CCL.LUT1CTRLA = CCL_ENABLE_bm;
+
+	CCL.SEQCTRL0 = CCL_SEQSEL_RS_gc; /* RS latch: LUT0 sets, LUT1 resets */
+	CCL.CTRLA = CCL_ENABLE_bm;
+}
+
+/*********************************************************************************
+TCB initialization: TCB0 captures CLK_PER on the rising edge of the latch
+**********************************************************************************/
+void tcb_init()
+{
+	TCB0.CTRLB = TCB_CNTMODE_CAPT_gc; /* Input Capture on Event mode */
+	TCB0.EVCTRL = TCB_CAPTEI_bm; /* Enable capture event input, on the positive edge */
+	TCB0.CTRLA = TCB_CLKSEL_DIV1_gc | TCB_ENABLE_bm; /* Count CLK_PER */
+}
+
+/**********************************************************************************
+ADC initialization
+**********************************************************************************/
+void adc_init()
+{
+	ADC0.CTRLA = ADC_ENABLE_bm;
+	ADC0.CTRLB = ADC_PRESC_DIV2_gc; /* fCLK_ADC = 3.333333/2 MHz */
+	ADC0.CTRLC = ADC_REFSEL_VDD_gc | (TIMEBASE_VALUE << ADC_TIMEBASE_gp);
+	ADC0.CTRLE = 2; /* (SAMPDUR + 0.5) * fCLK_ADC = 1.5 µs sample duration */
+	ADC0.CTRLF = ADC_FREERUN_bm; /* Enable Free-Run mode */
+
+	ADC0.MUXPOS = ADC_MUXPOS_AIN6_gc; /* ADC channel AIN6 -> PA6 */
+
+	ADC0.WINHT = TRIP_THRESHOLD; /* Window High Threshold */
+	/* Window Comparator mode: Above. Use SAMPLE register as Window Comparator source */
+	ADC0.CTRLD = ADC_WINCM_ABOVE_gc | ADC_WINSRC_SAMPLE_gc;
+	ADC0.INTCTRL = ADC_WCMP_bm; /* Enable window compare interrupt */
+
+	ADC0.COMMAND = ADC_MODE_SINGLE_12BIT_gc | ADC_START_IMMEDIATE_gc; /* Single 12-bit mode, start the free-running conversions */
+}
+
+/**********************************************************************************
+Re-arm: Resets the latch with a software event, which also arms the TCB0 capture,
+and enables the window compare interrupt again
+**********************************************************************************/
+void trip_rearm()
+{
+	EVSYS.SWEVENTA = EVSYS_SWEVENTA_CH1_gc; /* Reset the latch */
+#if !FAST_PATH
+	PORTA.OUTCLR = PIN4_bm;
+#endif
+	tripped = 0;
+	ADC0.INTFLAGS = ADC_WCMP_bm;
+	ADC0.INTCTRL = ADC_WCMP_bm;
+}
+
+/***********************************************************************************
+Window Compare interrupt:
+With FAST_PATH, PA4 has already been set by the CCL when the handler is entered, and
+the handler only does the bookkeeping: it counts the trip and stores the sample that
+tripped. The interrupt is disabled until the main loop re-arms, so the free-running
+conversions above the threshold do not keep the CPU busy.
+Without FAST_PATH, the handler does the reaction itself, after calculating the voltage.
+TCB0 captured the time of the first compare event of the trip, when the latch was
+set, so the latency of the handler is the time passed since the capture.
+***********************************************************************************/
+ISR(ADC0_SAMPRDY_vect)
+{
+	ADC0.INTFLAGS = ADC_WCMP_bm;    /* Clear WCMP flag */
+	ADC0.INTCTRL = 0;               /* Disable window compare interrupt until re-armed */
+
+	trip_sample = ADC0.SAMPLE;      /* Read ADC sample */
+#if !FAST_PATH
+	/* Calculate voltage on ADC pin, VDD = 3.3V, 12-bit resolution */
+	voltage = (float)(trip_sample * 3.3) / ADC_MAX_VALUE;
+	PORTA.OUTSET = PIN4_bm;
+#endif
+	trip_count++;
+	tripped = 1;
+
+	trip_latency = TCB0.CNT - TCB0.CCMP;
+	if(trip_latency > trip_latency_max)
+	{
+		trip_latency_max = trip_latency;
+	}
+}
+
+int main(void)
+{
+	evsys_init();
+	ccl_init();
+	tcb_init();
+	adc_init();
+	sei(); /* Enable global interrupts */
+
+	while(1)
+	{
+		/* Re-arm when the signal is back below the release level */
+		if(tripped && ADC0.SAMPLE < TRIP_RELEASE)
+		{
+			trip_rearm();
+		}
+	}
+}
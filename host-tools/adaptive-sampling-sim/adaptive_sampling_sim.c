@@ -0,0 +1,232 @@
+/*
+    \file   adaptive_sampling_sim.c
+
+    \brief  Host simulation of the single-adaptive-sampling example
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+/*
+ * Compiles the main.c of the single-adaptive-sampling example with the
+ * register model in host-tools/avr-sim, and runs its Result Ready interrupt on
+ * step and ramp inputs. The RTC overflows every RTC.PER + 1 cycles, with the
+ * period the interrupt wrote after the previous conversion, and the window
+ * comparator flag is set as the ADC would set it.
+ *
+ * For every input, the average conversion rate is printed, together with the
+ * transient latency: the time from the start of the transient to the first
+ * conversion at the fast rate. The simulation fails when a transient is
+ * detected later than two idle periods plus one fast period, when a signal
+ * that changes slower than SLOPE_THRESHOLD leaves the idle rate, or when the
+ * rate does not decay back to idle.
+ *
+ * The inputs are run a second time with PERBUSY set at every other
+ * conversion, so the interrupt skips every other write to PER and writes it
+ * after the next conversion. This may delay a transient by one more idle
+ * period.
+ *
+ * Build:   gcc -O2 -Wall -I../avr-sim -o adaptive_sampling_sim adaptive_sampling_sim.c -lm
+ * Usage:   adaptive_sampling_sim [noise LSB rms]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define main firmware_main
+#include "../../attiny1627-how-to-use-the-12-bit-differential-adc-with-pga/single-adaptive-sampling/main.c"
+#undef main
+
+#define SIMULATION_TIME     30.0    /* s */
+#define TRANSIENT_START     10.0    /* s */
+#define SIGNAL_LEVEL        2500.0  /* LSB, inside the window of the example */
+
+typedef struct
+{
+	const char *name;
+	double step;            /* LSB, step at TRANSIENT_START */
+	double step_time;       /* s, length of the step, 0 if it stays */
+	double slope;           /* LSB/s, ramp from TRANSIENT_START */
+	double ramp_time;       /* s, length of the ramp */
+	int transient;          /* 1 if the fast rate must be entered */
+} scenario_t;
+
+/* At the idle rate, SLOPE_THRESHOLD is 200 LSB between two results, so smaller steps are not transients */
+static const scenario_t scenarios[] =
+{
+	{ "flat",                           0,    0, 0,     0,     0 },
+	{ "step +100 LSB",                  100,  0, 0,     0,     0 },
+	{ "step +300 LSB",                  300,  0, 0,     0,     1 },
+	{ "step -400 LSB",                  -400, 0, 0,     0,     1 },
+	{ "1 s out of the window",          800,  1, 0,     0,     1 },
+	{ "ramp 500 LSB/s, slow",           0,    0, 500,   0.8,   0 },
+	{ "ramp 5000 LSB/s",                0,    0, 5000,  0.08,  1 },
+	{ "ramp 50000 LSB/s",               0,    0, 50000, 0.008, 1 },
+};
+
+static double noise_rms;
+static int per_busy;        /* PERBUSY is set at every other conversion */
+static int failures;
+
+static double gaussian(void)
+{
+	double u1 = (rand() + 1.0) / (RAND_MAX + 2.0);
+	double u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+
+	return sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+}
+
+static double input(const scenario_t *scenario, double t)
+{
+	double value = SIGNAL_LEVEL;
+
+	if(t >= TRANSIENT_START)
+	{
+		double ramp = (t - TRANSIENT_START < scenario->ramp_time) ? t - TRANSIENT_START : scenario->ramp_time;
+
+		value += scenario->slope * ramp;
+		if(scenario->step_time == 0 || t < TRANSIENT_START + scenario->step_time)
+		{
+			value += scenario->step;
+		}
+	}
+	return value + noise_rms * gaussian();
+}
+
+/* A conversion of the input, with the flags the ADC sets, and the Result Ready interrupt */
+static void convert(double value)
+{
+	long rounded = lround(value);
+	uint16_t result = (rounded < 0) ? 0 : (rounded > ADC_MAX_VALUE) ? ADC_MAX_VALUE : rounded;
+
+	ADC0.RESULT = result;
+	ADC0.INTFLAGS = ADC_RESRDY_bm;
+	if(result < ADC0.WINLT || result > ADC0.WINHT)
+	{
+		ADC0.INTFLAGS |= ADC_WCMP_bm;
+	}
+	ADC0_RESRDY_vect();
+}
+
+static void reset_firmware(void)
+{
+	memset((void *)&stats, 0, sizeof(stats));
+	memset((void *)&ADC0, 0, sizeof(ADC0));
+	memset((void *)&RTC, 0, sizeof(RTC));
+	rtc_period = RTC_PERIOD_IDLE;
+	event_system_init();
+	rtc_init();
+	adc_init();
+}
+
+static void run(const scenario_t *scenario)
+{
+	uint32_t tick = 0;
+	double latency = -1;
+	double last_fast = -1;
+	uint32_t idle_conversions = 0;
+	uint32_t transients_before;
+	uint32_t conversion = 0;
+
+	reset_firmware();
+
+	/* Settle at the idle rate, the previous result of the interrupt starts at 0 */
+	while(tick < (uint32_t)(TRANSIENT_START * RTC_CLOCK / 2))
+	{
+		tick += RTC.PER + 1;
+		convert(input(scenario, (double)tick / RTC_CLOCK));
+	}
+	memset((void *)&stats, 0, sizeof(stats));
+	transients_before = stats.transients;
+
+	while(tick < (uint32_t)(SIMULATION_TIME * RTC_CLOCK))
+	{
+		/* The conversion takes 20 µs, far less than one RTC cycle, so the result is ready at the overflow */
+		tick += RTC.PER + 1;
+		double t = (double)tick / RTC_CLOCK;
+
+		RTC.STATUS = (per_busy && (++conversion & 1)) ? RTC_PERBUSY_bm : 0;
+		convert(input(scenario, t));
+
+		if(rtc_period == RTC_PERIOD_FAST)
+		{
+			if(latency < 0 && t >= TRANSIENT_START)
+			{
+				latency = t - TRANSIENT_START;
+			}
+			last_fast = t;
+		}
+		if(t > SIMULATION_TIME - 1 && rtc_period == RTC_PERIOD_IDLE)
+		{
+			idle_conversions++;
+		}
+	}
+
+	double average_rate = (double)stats.conversions * RTC_CLOCK / stats.rtc_ticks;
+	/* A ramp is only seen when a whole idle period lies on it, so it may take two idle periods */
+	double max_latency = (2.0 + per_busy) * RTC_PERIOD_IDLE / RTC_CLOCK + (double)RTC_PERIOD_FAST / RTC_CLOCK;
+	int ok;
+
+	printf("%-26s %8.1f Hz %6u", scenario->name, average_rate, stats.transients - transients_before);
+	if(latency >= 0)
+	{
+		printf(" %10.2f ms %10.2f s", latency * 1000, last_fast - TRANSIENT_START);
+	}
+	else
+	{
+		printf(" %13s %12s", "-", "-");
+	}
+
+	if(scenario->transient)
+	{
+		ok = latency >= 0 && latency <= max_latency && idle_conversions > 0;
+	}
+	else
+	{
+		ok = latency < 0 && stats.transients == transients_before;
+	}
+	printf("  %s\n", ok ? "ok" : "FAILED");
+	failures += !ok;
+}
+
+int main(int argc, char *argv[])
+{
+	noise_rms = (argc > 1) ? atof(argv[1]) : 1.0;
+	srand(1);
+
+	printf("Idle rate %.1f Hz, fast rate %.1f Hz, slope threshold %lu LSB/s, noise %.2f LSB rms\n",
+	       (double)RTC_CLOCK / RTC_PERIOD_IDLE, (double)RTC_CLOCK / RTC_PERIOD_FAST,
+	       (unsigned long)SLOPE_THRESHOLD, noise_rms);
+
+	for(per_busy = 0; per_busy <= 1; per_busy++)
+	{
+		printf("\n%s\n", per_busy ? "PERBUSY at every other conversion" : "PERBUSY never set");
+		printf("%-26s %11s %6s %13s %12s\n", "input", "avg rate", "fast", "latency", "fast for");
+		for(size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++)
+		{
+			run(&scenarios[i]);
+		}
+	}
+
+	printf("%s\n", failures ? "FAILED" : "PASSED");
+	return failures ? 1 : 0;
+}
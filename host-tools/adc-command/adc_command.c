@@ -0,0 +1,444 @@
+/*
+    \file   adc_command.c
+
+    \brief  Linux host tool for the burst-usart-command example
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+/*
+ * Sends commands to the burst-usart-command example and prints the responses.
+ *
+ * Build:   gcc -O2 -Wall -o adc_command adc_command.c
+ * Usage:   adc_command <device> <command> [arguments]
+ *
+ * Commands:
+ *   mux <muxpos> <muxneg> <diff>    Set MUXPOS/MUXNEG register values and differential mode
+ *   sampnum <0-10>                  Set number of accumulated samples (2^n)
+ *   pga <pgactrl>                   Set PGACTRL register value
+ *   window <wincm> <low> <high>     Set window comparator mode and thresholds
+ *   freq <hz>                       Set sampling frequency
+ *   start | stop                    Start or stop streaming results
+ *   stats                           Print device statistics
+ *   stream [count]                  Start streaming and print results until count frames are received
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/select.h>
+
+#define BAUD_RATE           B115200
+#define RESPONSE_TIMEOUT_MS 1000
+
+/* Must match the definitions in burst-usart-command/main.c */
+#define FRAME_SYNC          0xA5
+#define FRAME_MAX_PAYLOAD   12
+#define FRAME_RESPONSE_bm   0x80
+
+#define CMD_SET_MUX         0x01
+#define CMD_SET_SAMPNUM     0x02
+#define CMD_SET_PGA         0x03
+#define CMD_SET_WINDOW      0x04
+#define CMD_SET_FREQ        0x05
+#define CMD_STREAM_START    0x10
+#define CMD_STREAM_STOP     0x11
+#define CMD_GET_STATS       0x20
+#define CMD_STREAM_DATA     0x30
+
+#define STREAM_FLAG_WCMP    0x01
+
+/* Number of stream frames left to print, negative for no limit */
+static long stream_remaining = -1;
+
+typedef struct
+{
+	uint8_t cmd;
+	uint8_t len;
+	uint8_t payload[FRAME_MAX_PAYLOAD];
+} frame_t;
+
+typedef enum
+{
+	PARSER_SYNC,
+	PARSER_CMD,
+	PARSER_LEN,
+	PARSER_PAYLOAD,
+	PARSER_CRC
+} parser_state_t;
+
+typedef struct
+{
+	parser_state_t state;
+	uint8_t index;
+	uint8_t crc;
+	frame_t frame;
+} parser_t;
+
+/* Same as _crc8_ccitt_update() in avr-libc: polynomial 0x07 */
+static uint8_t crc8_update(uint8_t crc, uint8_t data)
+{
+	crc ^= data;
+	for(int i = 0; i < 8; i++)
+	{
+		crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+	}
+	return crc;
+}
+
+static int serial_open(const char *device)
+{
+	struct termios tty;
+	int fd = open(device, O_RDWR | O_NOCTTY);
+
+	if(fd < 0)
+	{
+		fprintf(stderr, "%s: %s\n", device, strerror(errno));
+		return -1;
+	}
+
+	if(tcgetattr(fd, &tty) == 0)
+	{
+		cfmakeraw(&tty);
+		cfsetispeed(&tty, BAUD_RATE);
+		cfsetospeed(&tty, BAUD_RATE);
+		tty.c_cflag |= CLOCAL | CREAD;
+		tty.c_cc[VMIN] = 0;
+		tty.c_cc[VTIME] = 0;
+		tcsetattr(fd, TCSANOW, &tty);
+	}
+	/* Plain files and pipes have no terminal settings, they are used as is */
+
+	return fd;
+}
+
+static int frame_send(int fd, uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+	uint8_t buffer[FRAME_MAX_PAYLOAD + 4];
+	uint8_t crc = 0;
+
+	buffer[0] = FRAME_SYNC;
+	buffer[1] = cmd;
+	buffer[2] = len;
+	crc = crc8_update(crc, cmd);
+	crc = crc8_update(crc, len);
+	for(uint8_t i = 0; i < len; i++)
+	{
+		buffer[3 + i] = payload[i];
+		crc = crc8_update(crc, payload[i]);
+	}
+	buffer[3 + len] = crc;
+
+	return (write(fd, buffer, len + 4) == len + 4) ? 0 : -1;
+}
+
+/* Returns 1 when a complete frame with a valid CRC has been received */
+static int parser_feed(parser_t *parser, uint8_t data)
+{
+	switch(parser->state)
+	{
+	case PARSER_SYNC:
+		if(data == FRAME_SYNC)
+		{
+			parser->crc = 0;
+			parser->state = PARSER_CMD;
+		}
+		break;
+
+	case PARSER_CMD:
+		parser->frame.cmd = data;
+		parser->crc = crc8_update(parser->crc, data);
+		parser->state = PARSER_LEN;
+		break;
+
+	case PARSER_LEN:
+		parser->frame.len = data;
+		parser->index = 0;
+		parser->crc = crc8_update(parser->crc, data);
+		if(data > FRAME_MAX_PAYLOAD)
+		{
+			parser->state = PARSER_SYNC;
+		}
+		else
+		{
+			parser->state = (data > 0) ? PARSER_PAYLOAD : PARSER_CRC;
+		}
+		break;
+
+	case PARSER_PAYLOAD:
+		parser->frame.payload[parser->index++] = data;
+		parser->crc = crc8_update(parser->crc, data);
+		if(parser->index == parser->frame.len)
+		{
+			parser->state = PARSER_CRC;
+		}
+		break;
+
+	case PARSER_CRC:
+		parser->state = PARSER_SYNC;
+		return data == parser->crc;
+	}
+
+	return 0;
+}
+
+static long long now_ms(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000LL + now.tv_nsec / 1000000;
+}
+
+/* Wait for a frame, returns 0 on success and -1 on timeout or error. The
+   timeout is for the whole frame, so a stream of noise does not extend it. */
+static int frame_receive(int fd, parser_t *parser, int timeout_ms)
+{
+	long long deadline = now_ms() + timeout_ms;
+	uint8_t data;
+
+	while(1)
+	{
+		fd_set fds;
+		long long remaining = deadline - now_ms();
+		struct timeval tv;
+
+		if(timeout_ms >= 0 && remaining <= 0)
+		{
+			return -1;
+		}
+		tv.tv_sec = remaining / 1000;
+		tv.tv_usec = (remaining % 1000) * 1000;
+
+		FD_ZERO(&fds);
+		FD_SET(fd, &fds);
+		if(select(fd + 1, &fds, NULL, NULL, (timeout_ms < 0) ? NULL : &tv) <= 0)
+		{
+			return -1;
+		}
+		if(read(fd, &data, 1) != 1)
+		{
+			return -1;
+		}
+		if(parser_feed(parser, data))
+		{
+			return 0;
+		}
+	}
+}
+
+static void print_stream_frame(const frame_t *frame)
+{
+	int32_t result;
+
+	if(frame->len != 6 || stream_remaining == 0)
+	{
+		return;
+	}
+	if(stream_remaining > 0)
+	{
+		stream_remaining--;
+	}
+
+	result = (int32_t)((uint32_t)frame->payload[1] | ((uint32_t)frame->payload[2] << 8) |
+	                   ((uint32_t)frame->payload[3] << 16) | ((uint32_t)frame->payload[4] << 24));
+	printf("%u,%ld,%u\n", frame->payload[0], (long)result, (frame->payload[5] & STREAM_FLAG_WCMP) ? 1 : 0);
+}
+
+/* Send a command and wait for its response, printing stream frames received in between */
+static int transact(int fd, uint8_t cmd, const uint8_t *payload, uint8_t len, frame_t *response)
+{
+	parser_t parser = { .state = PARSER_SYNC };
+	static const char *status_text[] = { "OK", "bad length", "bad value", "unknown command" };
+
+	if(frame_send(fd, cmd, payload, len) < 0)
+	{
+		fprintf(stderr, "write failed: %s\n", strerror(errno));
+		return -1;
+	}
+
+	while(frame_receive(fd, &parser, RESPONSE_TIMEOUT_MS) == 0)
+	{
+		if(parser.frame.cmd == CMD_STREAM_DATA)
+		{
+			print_stream_frame(&parser.frame);
+			continue;
+		}
+		if(parser.frame.cmd != (cmd | FRAME_RESPONSE_bm))
+		{
+			continue;
+		}
+
+		*response = parser.frame;
+		if(cmd != CMD_GET_STATS)
+		{
+			uint8_t status = response->len ? response->payload[0] : 0xFF;
+			if(status != 0)
+			{
+				fprintf(stderr, "device: %s\n", (status < 4) ? status_text[status] : "invalid response");
+				return -1;
+			}
+		}
+		return 0;
+	}
+
+	fprintf(stderr, "no response from device\n");
+	return -1;
+}
+
+static uint32_t get_le(const uint8_t *p, int bytes)
+{
+	uint32_t value = 0;
+
+	for(int i = bytes - 1; i >= 0; i--)
+	{
+		value = (value << 8) | p[i];
+	}
+	return value;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+	        "usage: %s <device> <command> [arguments]\n"
+	        "  mux <muxpos> <muxneg> <diff>\n"
+	        "  sampnum <0-10>\n"
+	        "  pga <pgactrl>\n"
+	        "  window <wincm> <low> <high>\n"
+	        "  freq <hz>\n"
+	        "  start | stop | stats\n"
+	        "  stream [count]\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+	uint8_t payload[FRAME_MAX_PAYLOAD];
+	frame_t response;
+	long arg[3] = { 0 };
+	int fd;
+	int ret = 0;
+
+	if(argc < 3)
+	{
+		usage(argv[0]);
+		return 2;
+	}
+
+	for(int i = 0; i < 3 && i + 3 < argc; i++)
+	{
+		arg[i] = strtol(argv[i + 3], NULL, 0);
+	}
+
+	fd = serial_open(argv[1]);
+	if(fd < 0)
+	{
+		return 1;
+	}
+
+	const char *cmd = argv[2];
+	if(!strcmp(cmd, "mux") && argc == 6)
+	{
+		payload[0] = (uint8_t)arg[0];
+		payload[1] = (uint8_t)arg[1];
+		payload[2] = (uint8_t)arg[2];
+		ret = transact(fd, CMD_SET_MUX, payload, 3, &response);
+	}
+	else if(!strcmp(cmd, "sampnum") && argc == 4)
+	{
+		payload[0] = (uint8_t)arg[0];
+		ret = transact(fd, CMD_SET_SAMPNUM, payload, 1, &response);
+	}
+	else if(!strcmp(cmd, "pga") && argc == 4)
+	{
+		payload[0] = (uint8_t)arg[0];
+		ret = transact(fd, CMD_SET_PGA, payload, 1, &response);
+	}
+	else if(!strcmp(cmd, "window") && argc == 6)
+	{
+		payload[0] = (uint8_t)arg[0];
+		payload[1] = (uint8_t)arg[1];
+		payload[2] = (uint8_t)(arg[1] >> 8);
+		payload[3] = (uint8_t)arg[2];
+		payload[4] = (uint8_t)(arg[2] >> 8);
+		ret = transact(fd, CMD_SET_WINDOW, payload, 5, &response);
+	}
+	else if(!strcmp(cmd, "freq") && argc == 4)
+	{
+		payload[0] = (uint8_t)arg[0];
+		payload[1] = (uint8_t)(arg[0] >> 8);
+		ret = transact(fd, CMD_SET_FREQ, payload, 2, &response);
+	}
+	else if(!strcmp(cmd, "start") && argc == 3)
+	{
+		ret = transact(fd, CMD_STREAM_START, NULL, 0, &response);
+	}
+	else if(!strcmp(cmd, "stop") && argc == 3)
+	{
+		ret = transact(fd, CMD_STREAM_STOP, NULL, 0, &response);
+	}
+	else if(!strcmp(cmd, "stats") && argc == 3)
+	{
+		ret = transact(fd, CMD_GET_STATS, NULL, 0, &response);
+		if(ret == 0 && response.len == 10)
+		{
+			printf("conversions:     %lu\n", (unsigned long)get_le(&response.payload[0], 4));
+			printf("tx dropped:      %lu\n", (unsigned long)get_le(&response.payload[4], 2));
+			printf("rx errors:       %lu\n", (unsigned long)get_le(&response.payload[6], 2));
+			printf("configs applied: %lu\n", (unsigned long)get_le(&response.payload[8], 2));
+		}
+	}
+	else if(!strcmp(cmd, "stream") && argc <= 4)
+	{
+		parser_t parser = { .state = PARSER_SYNC };
+
+		stream_remaining = (argc == 4) ? arg[0] : -1;
+		printf("sequence,result,wcmp\n");
+		ret = transact(fd, CMD_STREAM_START, NULL, 0, &response);
+		while(ret == 0 && stream_remaining != 0 && frame_receive(fd, &parser, -1) == 0)
+		{
+			if(parser.frame.cmd == CMD_STREAM_DATA)
+			{
+				print_stream_frame(&parser.frame);
+				fflush(stdout);
+			}
+		}
+		if(ret == 0)
+		{
+			stream_remaining = 0; /* Frames still in flight are discarded */
+			ret = transact(fd, CMD_STREAM_STOP, NULL, 0, &response);
+		}
+	}
+	else
+	{
+		usage(argv[0]);
+		ret = -1;
+	}
+
+	close(fd);
+	return (ret == 0) ? 0 : 1;
+}
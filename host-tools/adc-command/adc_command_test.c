@@ -0,0 +1,350 @@
+/*
+    \file   adc_command_test.c
+
+    \brief  Loopback test of adc_command against the burst-usart-command example
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+/*
+ * Runs adc_command against the command interface of the burst-usart-command
+ * example through a pseudo terminal. The main.c of the example is compiled
+ * on the host with the register model in host-tools/avr-sim: the bytes that
+ * adc_command writes are passed to the Receive Complete interrupt and the
+ * parser of main(), the bytes the Data Register Empty interrupt sends are
+ * written back, and the Result Ready and RTC Overflow interrupts are called
+ * at the sampling frequency set by RTC.PER.
+ *
+ * Build:   gcc -O2 -Wall -I../avr-sim -o adc_command_test adc_command_test.c
+ * Usage:   adc_command_test <path to adc_command>
+ */
+
+#define _DEFAULT_SOURCE
+#define _XOPEN_SOURCE 600
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#define main firmware_main
+#include "../../attiny1627-how-to-use-the-12-bit-differential-adc-with-pga/burst-usart-command/main.c"
+#undef main
+
+#define TOOL_TIMEOUT_MS     5000
+#define RESPONSE_TIMEOUT_MS 1000    /* As in adc_command.c */
+#define OUTPUT_SIZE         65536
+
+/* Device behavior during a test */
+typedef enum
+{
+	DEVICE_NORMAL,
+	DEVICE_NOISE        /* Sends a zero byte every 200 ms and never answers */
+} device_mode_t;
+
+static int master_fd;
+static const char *slave_path;
+static const char *tool_path;
+static int failures;
+
+static long long now_us(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000LL + now.tv_nsec / 1000;
+}
+
+/* One pass of the main() loop of the example */
+static void device_main_loop(void)
+{
+	while(rx_tail != rx_head)
+	{
+		command_parse_byte(rx_buffer[rx_tail]);
+		rx_tail = (rx_tail + 1) & (RX_BUFFER_SIZE - 1);
+	}
+}
+
+static void device_receive(const uint8_t *data, size_t len)
+{
+	for(size_t i = 0; i < len; i++)
+	{
+		USART0.RXDATAL = data[i];
+		USART0_RXC_vect();
+	}
+	device_main_loop();
+}
+
+/* Sends everything the transmit buffer holds, through the Data Register Empty interrupt */
+static void device_transmit(void)
+{
+	while(USART0.CTRLA & USART_DREIE_bm)
+	{
+		bool sending = (tx_head != tx_tail);
+
+		USART0_DRE_vect();
+		if(sending)
+		{
+			uint8_t data = USART0.TXDATAL;
+
+			if(write(master_fd, &data, 1) != 1)
+			{
+				return;
+			}
+		}
+	}
+}
+
+/* The RTC overflow: the event starts a burst, which is done right away */
+static void device_rtc_overflow(void)
+{
+	static int32_t value = 1000;
+
+	if(RTC.INTCTRL & RTC_OVF_bm)
+	{
+		RTC.INTFLAGS |= RTC_OVF_bm;
+		RTC_CNT_vect();
+	}
+	ADC0.RESULT = value++;
+	ADC0.INTFLAGS |= ADC_RESRDY_bm;
+	ADC0_RESRDY_vect();
+}
+
+/* Runs adc_command with the arguments, and the device until it exits. Returns the exit status. */
+static int run_tool(const char *const args[], device_mode_t mode, char *output, long long *duration_us)
+{
+	int pipe_fd[2];
+	size_t used = 0;
+	int status = -1;
+
+	if(pipe(pipe_fd) < 0)
+	{
+		perror("pipe");
+		exit(1);
+	}
+
+	long long start = now_us();
+	pid_t pid = fork();
+	if(pid == 0)
+	{
+		const char *argv[8] = { tool_path, slave_path };
+		int argc = 2;
+
+		while(*args && argc < 7)
+		{
+			argv[argc++] = *args++;
+		}
+		dup2(pipe_fd[1], STDOUT_FILENO);
+		close(pipe_fd[0]);
+		execv(tool_path, (char *const *)argv);
+		perror(tool_path);
+		_exit(127);
+	}
+	close(pipe_fd[1]);
+
+	long long next_overflow = now_us();
+	long long next_noise = now_us();
+	while(1)
+	{
+		struct pollfd fds[2] = { { master_fd, POLLIN, 0 }, { pipe_fd[0], POLLIN, 0 } };
+		uint8_t buffer[256];
+
+		if(poll(fds, 2, 1) < 0 && errno != EINTR)
+		{
+			break;
+		}
+		if(fds[0].revents & POLLIN)
+		{
+			ssize_t n = read(master_fd, buffer, sizeof(buffer));
+
+			if(n > 0 && mode == DEVICE_NORMAL)
+			{
+				device_receive(buffer, n);
+			}
+		}
+		if(fds[1].revents & (POLLIN | POLLHUP))
+		{
+			ssize_t n = read(pipe_fd[0], output + used, OUTPUT_SIZE - 1 - used);
+
+			if(n > 0)
+			{
+				used += n;
+			}
+			else if(waitpid(pid, &status, 0) == pid)
+			{
+				break;
+			}
+		}
+
+		long long now = now_us();
+		if(mode == DEVICE_NORMAL && now >= next_overflow)
+		{
+			/* The RTC period is PER + 1 cycles of the 32.768 kHz clock */
+			next_overflow += (RTC.PER + 1) * 1000000LL / RTC_CLOCK;
+			device_rtc_overflow();
+		}
+		if(mode == DEVICE_NOISE && now >= next_noise)
+		{
+			next_noise += 200000;
+			buffer[0] = 0;
+			if(write(master_fd, buffer, 1) != 1)
+			{
+				break;
+			}
+		}
+		device_transmit();
+
+		if(now - start > TOOL_TIMEOUT_MS * 1000LL)
+		{
+			kill(pid, SIGKILL);
+		}
+	}
+	close(pipe_fd[0]);
+	output[used] = '\0';
+	*duration_us = now_us() - start;
+	return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static void check(int condition, const char *name)
+{
+	printf("%-50s %s\n", name, condition ? "ok" : "FAILED");
+	if(!condition)
+	{
+		failures++;
+	}
+}
+
+/* Checks that the stream output has count lines with consecutive sequence numbers and results */
+static int stream_consecutive(const char *output, int count)
+{
+	const char *line = strchr(output, '\n');
+	int lines = 0;
+	unsigned previous_sequence = 0;
+	long previous_result = 0;
+
+	while(line && line[1])
+	{
+		unsigned sequence;
+		long result;
+		unsigned wcmp;
+
+		if(sscanf(line + 1, "%u,%ld,%u", &sequence, &result, &wcmp) != 3)
+		{
+			return 0;
+		}
+		if(lines > 0 && (sequence != ((previous_sequence + 1) & 0xFF) || result != previous_result + 1))
+		{
+			return 0;
+		}
+		previous_sequence = sequence;
+		previous_result = result;
+		lines++;
+		line = strchr(line + 1, '\n');
+	}
+	return lines == count;
+}
+
+int main(int argc, char *argv[])
+{
+	static char output[OUTPUT_SIZE];
+	struct termios tty;
+	long long duration;
+
+	if(argc != 2)
+	{
+		fprintf(stderr, "usage: %s <path to adc_command>\n", argv[0]);
+		return 2;
+	}
+	tool_path = argv[1];
+
+	master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+	if(master_fd < 0 || grantpt(master_fd) < 0 || unlockpt(master_fd) < 0)
+	{
+		perror("posix_openpt");
+		return 1;
+	}
+	slave_path = ptsname(master_fd);
+
+	/* Keep the slave open, so that the master does not see a hangup between the tool runs */
+	int slave_fd = open(slave_path, O_RDWR | O_NOCTTY);
+	if(slave_fd < 0 || tcgetattr(slave_fd, &tty) < 0)
+	{
+		perror(slave_path);
+		return 1;
+	}
+	cfmakeraw(&tty);
+	tcsetattr(slave_fd, TCSANOW, &tty);
+
+	event_system_init();
+	rtc_init();
+	adc_init();
+	usart_init();
+	sei();
+
+	check(run_tool((const char *[]){ "freq", "200", NULL }, DEVICE_NORMAL, output, &duration) == 0, "freq 200 is accepted");
+	device_rtc_overflow();
+	device_rtc_overflow();
+	check(RTC.PER == RTC_CLOCK / 200, "RTC.PER is written at the next overflow");
+	check(!(RTC.INTCTRL & RTC_OVF_bm), "RTC overflow interrupt is disabled again");
+
+	check(run_tool((const char *[]){ "freq", "2000", NULL }, DEVICE_NORMAL, output, &duration) == 1, "freq 2000 is rejected");
+	check(run_tool((const char *[]){ "sampnum", "11", NULL }, DEVICE_NORMAL, output, &duration) == 1, "sampnum 11 is rejected");
+	check(run_tool((const char *[]){ "pga", "0xA1", NULL }, DEVICE_NORMAL, output, &duration) == 1, "pga with reserved GAIN is rejected");
+	check(run_tool((const char *[]){ "pga", "0x87", NULL }, DEVICE_NORMAL, output, &duration) == 1, "pga with reserved ADCPGASAMPDUR is rejected");
+	check(run_tool((const char *[]){ "pga", "0x9D", NULL }, DEVICE_NORMAL, output, &duration) == 0, "pga 16X, 1/4 bias, 20 clocks is accepted");
+	device_rtc_overflow();
+	check(ADC0.PGACTRL == 0x9D, "PGACTRL is written between two bursts");
+
+	check(run_tool((const char *[]){ "window", "3", "100", "200", NULL }, DEVICE_NORMAL, output, &duration) == 0, "window is accepted");
+	device_rtc_overflow();
+	check(ADC0.CTRLD == (ADC_WINCM_INSIDE_gc | ADC_WINSRC_RESULT_gc) && ADC0.WINLT == 100 && ADC0.WINHT == 200,
+	      "window comparator is configured");
+
+	check(run_tool((const char *[]){ "stream", "50", NULL }, DEVICE_NORMAL, output, &duration) == 0, "stream 50 succeeds");
+	check(stream_consecutive(output, 50), "50 consecutive stream frames are printed");
+	check(!streaming, "streaming is stopped afterwards");
+
+	uint16_t rx_errors = stats.rx_errors;
+	static const uint8_t bad_crc[] = { FRAME_SYNC, CMD_STREAM_START, 0, 0x55 };
+	device_receive(bad_crc, sizeof(bad_crc));
+	check(stats.rx_errors == rx_errors + 1 && !streaming, "a frame with a bad CRC is counted and dropped");
+
+	char expected[64];
+	snprintf(expected, sizeof(expected), "rx errors:       %u\n", stats.rx_errors);
+	check(run_tool((const char *[]){ "stats", NULL }, DEVICE_NORMAL, output, &duration) == 0, "stats succeeds");
+	check(strstr(output, expected) != NULL, "stats reports the receive errors");
+
+	check(run_tool((const char *[]){ "stats", NULL }, DEVICE_NOISE, output, &duration) == 1, "stats fails when the device does not answer");
+	check(duration < 2 * RESPONSE_TIMEOUT_MS * 1000LL, "noise does not extend the response timeout");
+
+	close(slave_fd);
+	close(master_fd);
+	printf("%s\n", failures ? "FAILED" : "PASSED");
+	return failures ? 1 : 0;
+}
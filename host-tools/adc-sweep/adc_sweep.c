@@ -0,0 +1,477 @@
+/*
+    \file   adc_sweep.c
+
+    \brief  Linux host tool that searches the ADC configuration space
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+/*
+ * Evaluates every combination of ADC prescaler, SAMPDUR, SAMPNUM and, when the
+ * PGA is used, PGA bias and ADCPGASAMPDUR with a simple noise and settling
+ * model, on all CPU cores. Prints the Pareto front: the configurations where no
+ * other configuration has a higher ENOB, a higher result rate and a lower
+ * energy per result at the same time, with the register settings for adc_init().
+ *
+ * Model, per result of 2^SAMPNUM accumulated samples:
+ * - Sample duration (SAMPDUR + 0.5) / fCLK_ADC, conversion time
+ *   (SAMPDUR + 0.5 + CONVERSION_CLKS) / fCLK_ADC per sample, plus
+ *   ADCPGASAMPDUR / fCLK_ADC with the PGA.
+ * - Settling error of the sampling capacitor, charged through the source and
+ *   input resistance, 4096 * exp(-t_sample / tau) LSB. With the PGA, the ADC
+ *   samples the PGA output for ADCPGASAMPDUR cycles after the input is sampled,
+ *   and the settling time constant of the PGA grows as the bias current is
+ *   reduced. The settling error does not average out.
+ * - White noise of the input and the ADC, reduced by the square root of the
+ *   number of samples. The quantization error only averages out when the
+ *   white noise is large enough to dither the input.
+ * - Energy: VDD * (ADC current + PGA current scaled by the bias) * time.
+ * The model constants are estimates; replace them with values from the data
+ * sheet and measurements on the application circuit.
+ *
+ * Build:   gcc -O2 -Wall -pthread -o adc_sweep adc_sweep.c -lm
+ * Usage:   adc_sweep [options]
+ *
+ * Options:
+ *   -f <hz>         CPU clock (default: 3333333)
+ *   -g <gain>       PGA gain 1, 2, 4, 8 or 16, 0 without PGA (default: 0)
+ *   -s <ohm>        Source resistance (default: 10000)
+ *   -n <uV>         Input noise, RMS (default: 100)
+ *   -R <V>          Reference voltage (default: 3.3)
+ *   -e <bits>       Only show configurations with at least this ENOB
+ *   -r <hz>         Only show configurations with at least this result rate
+ *   -j <threads>    Number of threads (default: number of CPU cores), each takes every n-th combination
+ *                   of prescaler and SAMPDUR
+ *   -c <config>     Only evaluate one configuration, given as prescaler division, SAMPDUR and SAMPNUM,
+ *                   and with the PGA the bias fraction and ADCPGASAMPDUR cycles, e.g. 16:2:4:0.25:6
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define ADC_BITS            12
+#define ADC_CLOCK_MIN       125000.0    /* Hz */
+#define ADC_CLOCK_MAX       2000000.0   /* Hz, as in the code examples */
+#define CONVERSION_CLKS     13.0        /* CLK_ADC cycles per conversion after sampling */
+#define SAMPLE_CAP          8e-12       /* F, sampling capacitor */
+#define INPUT_RESISTANCE    10e3        /* Ohm, switch and routing */
+#define PGA_TAU_FULL_BIAS   0.2e-6      /* s, PGA settling time constant at full bias */
+#define ADC_NOISE_LSB       0.3         /* RMS, intrinsic ADC noise */
+#define ADC_CURRENT         350e-6      /* A, ADC enabled and converting */
+#define PGA_CURRENT         600e-6      /* A, PGA at full bias */
+#define VDD                 3.3         /* V */
+#define ENOB_TOLERANCE      0.01        /* bits, smaller ENOB differences are not shown */
+
+static const int presc_div[] = { 2, 4, 6, 8, 10, 12, 14, 16, 20, 24, 28, 32, 40, 48, 56, 64 };
+#define PRESC_COUNT         (int)(sizeof(presc_div) / sizeof(presc_div[0]))
+
+/* PGA bias: fraction of full bias current and the name in the device header */
+static const struct { double fraction; const char *name; } pga_bias[] =
+{
+	{ 1.0,  "ADC_PGABIASSEL_1X_gc" },
+	{ 0.75, "ADC_PGABIASSEL_3_4X_gc" },
+	{ 0.5,  "ADC_PGABIASSEL_1_2X_gc" },
+	{ 0.25, "ADC_PGABIASSEL_1_4X_gc" },
+};
+static const struct { int clks; const char *name; } pga_sampdur[] =
+{
+	{ 6,  "ADC_ADCPGASAMPDUR_6CLK_gc" },
+	{ 15, "ADC_ADCPGASAMPDUR_15CLK_gc" },
+	{ 20, "ADC_ADCPGASAMPDUR_20CLK_gc" },
+};
+
+typedef struct
+{
+	unsigned char presc;        /* Index in presc_div */
+	unsigned char sampdur;
+	unsigned char sampnum;
+	unsigned char bias;         /* Index in pga_bias */
+	unsigned char pga_sampdur;  /* Index in pga_sampdur */
+	double enob;
+	double rate;                /* Results per second */
+	double energy;              /* J per result */
+} config_t;
+
+typedef struct
+{
+	config_t *items;
+	size_t count;
+	size_t capacity;
+} front_t;
+
+typedef struct
+{
+	int id;
+	int threads;
+	front_t front;
+	unsigned long evaluated;
+} worker_t;
+
+static double cpu_freq = 3333333.0;
+static int gain = 0;
+static double source_resistance = 10e3;
+static double input_noise = 100e-6;
+static double vref = 3.3;
+static double min_enob = 0.0;
+static double min_rate = 0.0;
+
+/*
+ * Returns 1 if a is at least as good as b in all objectives, and better in one.
+ * The comparison is exact, so that dominance is transitive and the merged front
+ * does not depend on the order the threads found the configurations in.
+ */
+static int dominates(const config_t *a, const config_t *b)
+{
+	if(a->enob < b->enob || a->rate < b->rate || a->energy > b->energy)
+	{
+		return 0;
+	}
+	return a->enob > b->enob || a->rate > b->rate || a->energy < b->energy;
+}
+
+/* Returns 1 if b is only better than a by less than ENOB_TOLERANCE, so that it is not worth printing */
+static int hides(const config_t *a, const config_t *b)
+{
+	if(a->enob < b->enob - ENOB_TOLERANCE || a->rate < b->rate || a->energy > b->energy)
+	{
+		return 0;
+	}
+	return a->rate > b->rate || a->energy < b->energy;
+}
+
+/* Adds a configuration to the front, unless it is dominated, and removes the configurations it dominates */
+static void front_add(front_t *front, const config_t *config)
+{
+	size_t kept = 0;
+
+	for(size_t i = 0; i < front->count; i++)
+	{
+		if(dominates(&front->items[i], config))
+		{
+			return;
+		}
+	}
+	for(size_t i = 0; i < front->count; i++)
+	{
+		if(!dominates(config, &front->items[i]))
+		{
+			front->items[kept++] = front->items[i];
+		}
+	}
+	front->count = kept;
+
+	if(front->count == front->capacity)
+	{
+		front->capacity = front->capacity ? 2 * front->capacity : 64;
+		front->items = realloc(front->items, front->capacity * sizeof(config_t));
+		if(!front->items)
+		{
+			perror("realloc");
+			exit(1);
+		}
+	}
+	front->items[front->count++] = *config;
+}
+
+static void evaluate(config_t *config)
+{
+	double adc_clock = cpu_freq / presc_div[config->presc];
+	double samples = (double)(1 << config->sampnum);
+	double t_sample = (config->sampdur + 0.5) / adc_clock;
+	double t_conversion = (config->sampdur + 0.5 + CONVERSION_CLKS) / adc_clock;
+	double lsb = vref / (1 << ADC_BITS);
+	double settling = (1 << ADC_BITS) * exp(-t_sample / ((source_resistance + INPUT_RESISTANCE) * SAMPLE_CAP));
+	double noise = input_noise / lsb;
+	double current = ADC_CURRENT;
+
+	if(gain)
+	{
+		double bias = pga_bias[config->bias].fraction;
+		double t_pga = pga_sampdur[config->pga_sampdur].clks / adc_clock;
+		double pga_settling = (1 << ADC_BITS) * exp(-t_pga * bias / PGA_TAU_FULL_BIAS);
+
+		settling = sqrt(settling * settling + pga_settling * pga_settling);
+		noise *= gain;
+		t_conversion += t_pga;
+		current += PGA_CURRENT * bias;
+	}
+
+	/* White noise averages out. The quantization error only averages out as far as the noise dithers the input. */
+	double white = sqrt(noise * noise + ADC_NOISE_LSB * ADC_NOISE_LSB);
+	double dither = fmin(1.0, white / 0.5);
+	double quantization = sqrt(1.0 / 12.0) / sqrt(fmax(1.0, samples * dither * dither));
+	double error = sqrt(white * white / samples + quantization * quantization + settling * settling);
+
+	config->enob = ADC_BITS - log2(error / sqrt(1.0 / 12.0));
+	config->rate = 1.0 / (samples * t_conversion);
+	config->energy = VDD * current * samples * t_conversion;
+}
+
+static void *worker_run(void *arg)
+{
+	worker_t *worker = arg;
+	int biases = gain ? (int)(sizeof(pga_bias) / sizeof(pga_bias[0])) : 1;
+	int pga_sampdurs = gain ? (int)(sizeof(pga_sampdur) / sizeof(pga_sampdur[0])) : 1;
+
+	/* The combinations of prescaler and SAMPDUR are shared out between the threads */
+	for(int item = worker->id; item < PRESC_COUNT * 256; item += worker->threads)
+	{
+		int presc = item / 256;
+		int sampdur = item % 256;
+		double adc_clock = cpu_freq / presc_div[presc];
+
+		if(adc_clock < ADC_CLOCK_MIN || adc_clock > ADC_CLOCK_MAX)
+		{
+			continue;
+		}
+		for(int sampnum = 0; sampnum <= 10; sampnum++)
+		{
+			for(int bias = 0; bias < biases; bias++)
+			{
+				for(int pga = 0; pga < pga_sampdurs; pga++)
+				{
+					config_t config = { presc, sampdur, sampnum, bias, pga, 0, 0, 0 };
+
+					evaluate(&config);
+					worker->evaluated++;
+					if(config.enob >= min_enob && config.rate >= min_rate)
+					{
+						front_add(&worker->front, &config);
+					}
+				}
+			}
+		}
+	}
+	return NULL;
+}
+
+static int compare_rate(const void *a, const void *b)
+{
+	const config_t *x = a;
+	const config_t *y = b;
+
+	if(x->rate != y->rate)
+	{
+		return (x->rate < y->rate) - (x->rate > y->rate);
+	}
+	/* Configurations with the same rate are sorted by their settings, so the output does not depend on the threads */
+	if(x->presc != y->presc)
+	{
+		return x->presc - y->presc;
+	}
+	if(x->sampdur != y->sampdur)
+	{
+		return x->sampdur - y->sampdur;
+	}
+	if(x->sampnum != y->sampnum)
+	{
+		return x->sampnum - y->sampnum;
+	}
+	if(x->bias != y->bias)
+	{
+		return x->bias - y->bias;
+	}
+	return x->pga_sampdur - y->pga_sampdur;
+}
+
+static void print_config(const config_t *config)
+{
+	printf("/* ENOB %5.2f, %10.1f results/s, %9.3f uJ/result */\n",
+	       config->enob, config->rate, config->energy * 1e6);
+	printf("ADC0.CTRLB = ADC_PRESC_DIV%d_gc;\n", presc_div[config->presc]);
+	printf("ADC0.CTRLE = %d;\n", config->sampdur);
+	if(config->sampnum < 4)
+	{
+		/* With burst scaling, fewer than 16 samples give a 12-bit result unless it is left adjusted */
+		printf("ADC0.CTRLF = ADC_LEFTADJ_bm | %d; /* SAMPNUM: %d samples, 16-bit scaled result */\n",
+		       config->sampnum, 1 << config->sampnum);
+	}
+	else
+	{
+		printf("ADC0.CTRLF = %d; /* SAMPNUM: %d samples */\n", config->sampnum, 1 << config->sampnum);
+	}
+	if(gain)
+	{
+		printf("ADC0.PGACTRL = ADC_GAIN_%dX_gc | %s | %s | ADC_PGAEN_bm;\n", gain,
+		       pga_bias[config->bias].name, pga_sampdur[config->pga_sampdur].name);
+	}
+	printf("\n");
+}
+
+/* Finds the configuration given with -c, returns 0 if a value is not one of the settings */
+static int parse_config(const char *text, config_t *config)
+{
+	int div = 0, sampdur = -1, sampnum = -1, pga_clks = 6;
+	double bias = 1.0;
+	int fields = sscanf(text, "%d:%d:%d:%lf:%d", &div, &sampdur, &sampnum, &bias, &pga_clks);
+
+	memset(config, 0, sizeof(*config));
+	if(fields < 3 || sampdur < 0 || sampdur > 255 || sampnum < 0 || sampnum > 10)
+	{
+		return 0;
+	}
+	config->sampdur = sampdur;
+	config->sampnum = sampnum;
+
+	int found = 0;
+	for(int i = 0; i < PRESC_COUNT; i++)
+	{
+		if(presc_div[i] == div)
+		{
+			config->presc = i;
+			found++;
+		}
+	}
+	for(int i = 0; i < (int)(sizeof(pga_bias) / sizeof(pga_bias[0])); i++)
+	{
+		if(pga_bias[i].fraction == bias)
+		{
+			config->bias = i;
+			found++;
+		}
+	}
+	for(int i = 0; i < (int)(sizeof(pga_sampdur) / sizeof(pga_sampdur[0])); i++)
+	{
+		if(pga_sampdur[i].clks == pga_clks)
+		{
+			config->pga_sampdur = i;
+			found++;
+		}
+	}
+	return found == 3;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+	        "usage: %s [-f hz] [-g gain] [-s ohm] [-n uV] [-R V] [-e bits] [-r hz] [-j threads] [-c config]\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+	long threads = sysconf(_SC_NPROCESSORS_ONLN);
+	const char *single = NULL;
+	int opt;
+
+	while((opt = getopt(argc, argv, "f:g:s:n:R:e:r:j:c:")) != -1)
+	{
+		switch(opt)
+		{
+		case 'f': cpu_freq = atof(optarg); break;
+		case 'g': gain = atoi(optarg); break;
+		case 's': source_resistance = atof(optarg); break;
+		case 'n': input_noise = atof(optarg) * 1e-6; break;
+		case 'R': vref = atof(optarg); break;
+		case 'e': min_enob = atof(optarg); break;
+		case 'r': min_rate = atof(optarg); break;
+		case 'j': threads = atol(optarg); break;
+		case 'c': single = optarg; break;
+		default:
+			usage(argv[0]);
+			return 2;
+		}
+	}
+	if(optind != argc || cpu_freq <= 0 || vref <= 0 || threads < 1 ||
+	   (gain != 0 && gain != 1 && gain != 2 && gain != 4 && gain != 8 && gain != 16))
+	{
+		usage(argv[0]);
+		return 2;
+	}
+	if(single)
+	{
+		config_t config;
+
+		if(!parse_config(single, &config))
+		{
+			fprintf(stderr, "unknown configuration '%s'\n", single);
+			return 2;
+		}
+		evaluate(&config);
+		print_config(&config);
+		return 0;
+	}
+	if(threads > PRESC_COUNT * 256)
+	{
+		threads = PRESC_COUNT * 256;
+	}
+
+	worker_t *workers = calloc(threads, sizeof(worker_t));
+	pthread_t *ids = calloc(threads, sizeof(pthread_t));
+	if(!workers || !ids)
+	{
+		perror("calloc");
+		return 1;
+	}
+	for(int i = 0; i < threads; i++)
+	{
+		workers[i].id = i;
+		workers[i].threads = threads;
+		if(pthread_create(&ids[i], NULL, worker_run, &workers[i]) != 0)
+		{
+			fprintf(stderr, "pthread_create failed\n");
+			return 1;
+		}
+	}
+
+	/* Merge the fronts of the threads */
+	front_t front = { NULL, 0, 0 };
+	unsigned long evaluated = 0;
+	for(int i = 0; i < threads; i++)
+	{
+		pthread_join(ids[i], NULL);
+		evaluated += workers[i].evaluated;
+		for(size_t j = 0; j < workers[i].front.count; j++)
+		{
+			front_add(&front, &workers[i].front.items[j]);
+		}
+		free(workers[i].front.items);
+	}
+
+	/* Configurations that only improve ENOB by less than ENOB_TOLERANCE over another one on the front are not printed */
+	size_t printed = 0;
+	qsort(front.items, front.count, sizeof(config_t), compare_rate);
+	for(size_t i = 0; i < front.count; i++)
+	{
+		size_t j = 0;
+
+		while(j < front.count && !hides(&front.items[j], &front.items[i]))
+		{
+			j++;
+		}
+		if(j == front.count)
+		{
+			print_config(&front.items[i]);
+			printed++;
+		}
+	}
+	fprintf(stderr, "%lu configurations evaluated on %ld threads, %zu on the Pareto front, %zu printed\n",
+	        evaluated, threads, front.count, printed);
+
+	free(front.items);
+	free(workers);
+	free(ids);
+	return 0;
+}
@@ -0,0 +1,581 @@
+/*
+    \file   io.h
+
+    \brief  Host model of the ATtiny1627 registers used by the code examples
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+/*
+ * Replaces <avr/io.h> when a code example is compiled on the host, so that its
+ * interrupt handlers and functions can be called from a test program. Every
+ * peripheral is a plain structure in memory: writing a register only stores
+ * the value, and a test sets the registers the hardware would set, e.g.
+ * ADC0.RESULT and ADC0.INTFLAGS, before it calls an interrupt handler. Flags
+ * are not cleared by writing 1 or by reading a result register, so the test
+ * writes the complete flag register before each interrupt.
+ *
+ * Only the registers and bit fields used by the code examples are defined,
+ * with the values from the ATtiny1627 device header. A test program includes
+ * the main.c of the example with main renamed, e.g.
+ *
+ *     #define main firmware_main
+ *     #include "../../attiny1627-.../burst-usart-command/main.c"
+ *     #undef main
+ *
+ * and is built with -I../avr-sim. Each test program is one translation unit,
+ * so the registers are defined here.
+ */
+
+#ifndef AVR_SIM_IO_H
+#define AVR_SIM_IO_H
+
+#include <stdint.h>
+
+#define AVR_SIM_STORAGE     static __attribute__((unused))
+
+typedef volatile uint8_t register8_t;
+typedef volatile uint16_t register16_t;
+typedef volatile uint32_t register32_t;
+
+/* ADC */
+typedef struct
+{
+	register8_t CTRLA;
+	register8_t CTRLB;
+	register8_t CTRLC;
+	register8_t CTRLD;
+	register8_t CTRLE;
+	register8_t CTRLF;
+	register8_t COMMAND;
+	register8_t PGACTRL;
+	register8_t MUXPOS;
+	register8_t MUXNEG;
+	register8_t INTCTRL;
+	register8_t INTFLAGS;
+	register8_t STATUS;
+	register32_t RESULT;
+	register16_t SAMPLE;
+	register16_t WINLT;
+	register16_t WINHT;
+} ADC_t;
+
+#define ADC_ENABLE_bm               0x01
+#define ADC_LOWLAT_bm               0x20
+#define ADC_RUNSTDBY_bm             0x80
+
+#define ADC_PRESC_DIV2_gc           0x00
+#define ADC_PRESC_DIV4_gc           0x01
+#define ADC_PRESC_DIV6_gc           0x02
+#define ADC_PRESC_DIV8_gc           0x03
+#define ADC_PRESC_DIV10_gc          0x04
+#define ADC_PRESC_DIV12_gc          0x05
+#define ADC_PRESC_DIV14_gc          0x06
+#define ADC_PRESC_DIV16_gc          0x07
+#define ADC_PRESC_DIV20_gc          0x08
+#define ADC_PRESC_DIV24_gc          0x09
+#define ADC_PRESC_DIV28_gc          0x0A
+#define ADC_PRESC_DIV32_gc          0x0B
+#define ADC_PRESC_DIV40_gc          0x0C
+#define ADC_PRESC_DIV48_gc          0x0D
+#define ADC_PRESC_DIV56_gc          0x0E
+#define ADC_PRESC_DIV64_gc          0x0F
+
+#define ADC_REFSEL_VDD_gc           0x00
+#define ADC_REFSEL_VREFA_gc         0x02
+#define ADC_REFSEL_1024MV_gc        0x04
+#define ADC_REFSEL_2048MV_gc        0x05
+#define ADC_REFSEL_2500MV_gc        0x06
+#define ADC_REFSEL_4096MV_gc        0x07
+#define ADC_TIMEBASE_gm             0xF8
+#define ADC_TIMEBASE_gp             3
+
+#define ADC_WINCM_gm                0x07
+#define ADC_WINCM_NONE_gc           0x00
+#define ADC_WINCM_BELOW_gc          0x01
+#define ADC_WINCM_ABOVE_gc          0x02
+#define ADC_WINCM_INSIDE_gc         0x03
+#define ADC_WINCM_OUTSIDE_gc        0x04
+#define ADC_WINSRC_RESULT_gc        0x00
+#define ADC_WINSRC_SAMPLE_gc        0x08
+
+#define ADC_SAMPNUM_gm              0x0F
+#define ADC_SAMPNUM_NONE_gc         0x00
+#define ADC_SAMPNUM_ACC2_gc         0x01
+#define ADC_SAMPNUM_ACC4_gc         0x02
+#define ADC_SAMPNUM_ACC8_gc         0x03
+#define ADC_SAMPNUM_ACC16_gc        0x04
+#define ADC_SAMPNUM_ACC32_gc        0x05
+#define ADC_SAMPNUM_ACC64_gc        0x06
+#define ADC_SAMPNUM_ACC128_gc       0x07
+#define ADC_SAMPNUM_ACC256_gc       0x08
+#define ADC_SAMPNUM_ACC512_gc       0x09
+#define ADC_SAMPNUM_ACC1024_gc      0x0A
+#define ADC_LEFTADJ_bm              0x10
+#define ADC_FREERUN_bm              0x20
+
+#define ADC_START_gm                0x07
+#define ADC_START_STOP_gc           0x00
+#define ADC_START_IMMEDIATE_gc      0x01
+#define ADC_START_MUXPOS_WRITE_gc   0x02
+#define ADC_START_MUXNEG_WRITE_gc   0x03
+#define ADC_START_EVENT_TRIGGER_gc  0x04
+#define ADC_MODE_gm                 0x70
+#define ADC_MODE_SINGLE_8BIT_gc     0x00
+#define ADC_MODE_SINGLE_12BIT_gc    0x10
+#define ADC_MODE_SERIES_gc          0x20
+#define ADC_MODE_SERIES_SCALING_gc  0x30
+#define ADC_MODE_BURST_gc           0x40
+#define ADC_MODE_BURST_SCALING_gc   0x50
+#define ADC_DIFF_bm                 0x80
+
+#define ADC_PGAEN_bm                0x01
+#define ADC_ADCPGASAMPDUR_gm        0x06
+#define ADC_ADCPGASAMPDUR_6CLK_gc   0x00
+#define ADC_ADCPGASAMPDUR_15CLK_gc  0x02
+#define ADC_ADCPGASAMPDUR_20CLK_gc  0x04
+#define ADC_PGABIASSEL_gm           0x18
+#define ADC_PGABIASSEL_1X_gc        0x00
+#define ADC_PGABIASSEL_3_4X_gc      0x08
+#define ADC_PGABIASSEL_1_2X_gc      0x10
+#define ADC_PGABIASSEL_1_4X_gc      0x18
+#define ADC_GAIN_gm                 0xE0
+#define ADC_GAIN_1X_gc              0x00
+#define ADC_GAIN_2X_gc              0x20
+#define ADC_GAIN_4X_gc              0x40
+#define ADC_GAIN_8X_gc              0x60
+#define ADC_GAIN_16X_gc             0x80
+
+#define ADC_MUXPOS_AIN1_gc          0x01
+#define ADC_MUXPOS_AIN2_gc          0x02
+#define ADC_MUXPOS_AIN3_gc          0x03
+#define ADC_MUXPOS_AIN4_gc          0x04
+#define ADC_MUXPOS_AIN5_gc          0x05
+#define ADC_MUXPOS_AIN6_gc          0x06
+#define ADC_MUXPOS_AIN7_gc          0x07
+#define ADC_MUXPOS_GND_gc           0x30
+#define ADC_MUXPOS_VDDDIV10_gc      0x31
+#define ADC_MUXPOS_TEMPSENSE_gc     0x32
+#define ADC_MUXNEG_AIN1_gc          0x01
+#define ADC_MUXNEG_AIN2_gc          0x02
+#define ADC_MUXNEG_AIN3_gc          0x03
+#define ADC_MUXNEG_AIN4_gc          0x04
+#define ADC_MUXNEG_AIN5_gc          0x05
+#define ADC_MUXNEG_AIN6_gc          0x06
+#define ADC_MUXNEG_AIN7_gc          0x07
+#define ADC_MUXNEG_GND_gc           0x30
+#define ADC_VIA_ADC_gc              0x00
+#define ADC_VIA_PGA_gc              0x40
+
+#define ADC_RESRDY_bm               0x01
+#define ADC_SAMPRDY_bm              0x02
+#define ADC_WCMP_bm                 0x04
+#define ADC_RESOVR_bm               0x08
+#define ADC_SAMPOVR_bm              0x10
+#define ADC_TRIGOVR_bm              0x20
+#define ADC_ADCBUSY_bm              0x01
+
+/* CCL */
+typedef struct
+{
+	register8_t CTRLA;
+	register8_t SEQCTRL0;
+	register8_t LUT0CTRLA;
+	register8_t LUT0CTRLB;
+	register8_t LUT0CTRLC;
+	register8_t TRUTH0;
+	register8_t LUT1CTRLA;
+	register8_t LUT1CTRLB;
+	register8_t LUT1CTRLC;
+	register8_t TRUTH1;
+} CCL_t;
+
+#define CCL_ENABLE_bm               0x01
+#define CCL_RUNSTDBY_bm             0x40
+#define CCL_OUTEN_bm                0x08
+#define CCL_SEQSEL_DISABLE_gc       0x00
+#define CCL_SEQSEL_DFF_gc           0x01
+#define CCL_SEQSEL_JK_gc            0x02
+#define CCL_SEQSEL_LATCH_gc         0x03
+#define CCL_SEQSEL_RS_gc            0x04
+#define CCL_INSEL0_MASK_gc          0x00
+#define CCL_INSEL0_FEEDBACK_gc      0x01
+#define CCL_INSEL0_LINK_gc          0x02
+#define CCL_INSEL0_EVENTA_gc        0x03
+#define CCL_INSEL0_EVENTB_gc        0x04
+#define CCL_INSEL1_MASK_gc          0x00
+#define CCL_INSEL1_EVENTA_gc        0x30
+#define CCL_INSEL2_MASK_gc          0x00
+#define CCL_INSEL2_EVENTA_gc        0x03
+
+/* CLKCTRL */
+typedef struct
+{
+	register8_t MCLKCTRLA;
+	register8_t MCLKCTRLB;
+} CLKCTRL_t;
+
+#define CLKCTRL_PEN_bm              0x01
+#define CLKCTRL_PDIV_2X_gc          0x00
+#define CLKCTRL_PDIV_4X_gc          0x02
+#define CLKCTRL_PDIV_8X_gc          0x04
+#define CLKCTRL_PDIV_16X_gc         0x06
+#define CLKCTRL_PDIV_32X_gc         0x08
+#define CLKCTRL_PDIV_64X_gc         0x0A
+#define CLKCTRL_PDIV_6X_gc          0x10
+#define CLKCTRL_PDIV_10X_gc         0x12
+#define CLKCTRL_PDIV_12X_gc         0x14
+#define CLKCTRL_PDIV_24X_gc         0x16
+#define CLKCTRL_PDIV_48X_gc         0x18
+
+/* EVSYS */
+typedef struct
+{
+	register8_t SWEVENTA;
+	register8_t CHANNEL0;
+	register8_t CHANNEL1;
+	register8_t CHANNEL2;
+	register8_t CHANNEL3;
+	register8_t CHANNEL4;
+	register8_t CHANNEL5;
+	register8_t USERCCLLUT0A;
+	register8_t USERCCLLUT0B;
+	register8_t USERCCLLUT1A;
+	register8_t USERCCLLUT1B;
+	register8_t USERADC0START;
+	register8_t USEREVSYSEVOUTA;
+	register8_t USEREVSYSEVOUTB;
+	register8_t USEREVSYSEVOUTC;
+	register8_t USERTCA0CNTA;
+	register8_t USERTCB0CAPT;
+	register8_t USERTCB0COUNT;
+	register8_t USERTCB1CAPT;
+	register8_t USERTCB1COUNT;
+} EVSYS_t;
+
+#define EVSYS_CHANNEL0_OFF_gc           0x00
+#define EVSYS_CHANNEL0_RTC_OVF_gc       0x06
+#define EVSYS_CHANNEL0_RTC_CMP_gc       0x07
+#define EVSYS_CHANNEL0_ADC0_RES_gc      0x24
+#define EVSYS_CHANNEL0_ADC0_SAMP_gc     0x25
+#define EVSYS_CHANNEL0_ADC0_WCMP_gc     0x26
+#define EVSYS_CHANNEL0_TCA0_OVF_LUNF_gc 0x80
+#define EVSYS_CHANNEL0_TCB0_CAPT_gc     0xA0
+#define EVSYS_CHANNEL1_OFF_gc           0x00
+#define EVSYS_CHANNEL1_RTC_OVF_gc       0x06
+#define EVSYS_CHANNEL1_ADC0_RES_gc      0x24
+#define EVSYS_CHANNEL1_ADC0_WCMP_gc     0x26
+#define EVSYS_CHANNEL1_TCA0_OVF_LUNF_gc 0x80
+#define EVSYS_CHANNEL2_OFF_gc           0x00
+#define EVSYS_CHANNEL2_RTC_OVF_gc       0x06
+#define EVSYS_CHANNEL2_CCL_LUT0_gc      0x10
+#define EVSYS_CHANNEL2_ADC0_RES_gc      0x24
+#define EVSYS_CHANNEL2_ADC0_WCMP_gc     0x26
+#define EVSYS_CHANNEL2_TCA0_OVF_LUNF_gc 0x80
+#define EVSYS_SWEVENTA_CH0_gc           0x01
+#define EVSYS_SWEVENTA_CH1_gc           0x02
+#define EVSYS_SWEVENTA_CH2_gc           0x04
+#define EVSYS_USER_OFF_gc               0x00
+#define EVSYS_USER_CHANNEL0_gc          0x01
+#define EVSYS_USER_CHANNEL1_gc          0x02
+#define EVSYS_USER_CHANNEL2_gc          0x03
+#define EVSYS_USER_CHANNEL3_gc          0x04
+#define EVSYS_USER_CHANNEL4_gc          0x05
+#define EVSYS_USER_CHANNEL5_gc          0x06
+
+/* NVMCTRL and EEPROM */
+typedef struct
+{
+	register8_t CTRLA;
+	register8_t CTRLB;
+	register8_t STATUS;
+} NVMCTRL_t;
+
+#define NVMCTRL_CMD_NONE_gc             0x00
+#define NVMCTRL_CMD_PAGEWRITE_gc        0x01
+#define NVMCTRL_CMD_PAGEERASE_gc        0x02
+#define NVMCTRL_CMD_PAGEERASEWRITE_gc   0x03
+#define NVMCTRL_CMD_PAGEBUFCLR_gc       0x04
+#define NVMCTRL_FBUSY_bm                0x01
+#define NVMCTRL_EEBUSY_bm               0x02
+
+#define EEPROM_SIZE                 256
+#define EEPROM_PAGE_SIZE            32
+/* The EEPROM is mapped to the data space; on the host it is an array */
+AVR_SIM_STORAGE uint8_t avr_sim_eeprom[EEPROM_SIZE];
+#define EEPROM_START                ((uintptr_t)avr_sim_eeprom)
+#define EEPROM_END                  (EEPROM_START + EEPROM_SIZE - 1)
+
+/* PORT */
+typedef struct
+{
+	register8_t DIR;
+	register8_t DIRSET;
+	register8_t DIRCLR;
+	register8_t DIRTGL;
+	register8_t OUT;
+	register8_t OUTSET;
+	register8_t OUTCLR;
+	register8_t OUTTGL;
+	register8_t IN;
+} PORT_t;
+
+#define PIN0_bm                     0x01
+#define PIN1_bm                     0x02
+#define PIN2_bm                     0x04
+#define PIN3_bm                     0x08
+#define PIN4_bm                     0x10
+#define PIN5_bm                     0x20
+#define PIN6_bm                     0x40
+#define PIN7_bm                     0x80
+
+/* VPORT */
+typedef struct
+{
+	register8_t DIR;
+	register8_t OUT;
+	register8_t IN;
+	register8_t INTFLAGS;
+} VPORT_t;
+
+/* RSTCTRL */
+typedef struct
+{
+	register8_t RSTFR;
+	register8_t SWRR;
+} RSTCTRL_t;
+
+#define RSTCTRL_PORF_bm             0x01
+#define RSTCTRL_BORF_bm             0x02
+#define RSTCTRL_EXTRF_bm            0x04
+#define RSTCTRL_WDRF_bm             0x08
+#define RSTCTRL_SWRF_bm             0x10
+#define RSTCTRL_UPDIRF_bm           0x20
+
+/* RTC */
+typedef struct
+{
+	register8_t CTRLA;
+	register8_t STATUS;
+	register8_t INTCTRL;
+	register8_t INTFLAGS;
+	register8_t TEMP;
+	register8_t DBGCTRL;
+	register8_t CALIB;
+	register8_t CLKSEL;
+	register16_t CNT;
+	register16_t PER;
+	register16_t CMP;
+	register8_t PITCTRLA;
+	register8_t PITSTATUS;
+	register8_t PITINTCTRL;
+	register8_t PITINTFLAGS;
+} RTC_t;
+
+#define RTC_RTCEN_bm                0x01
+#define RTC_CORREN_bm               0x04
+#define RTC_RUNSTDBY_bm             0x80
+#define RTC_PRESCALER_DIV1_gc       0x00
+#define RTC_PRESCALER_DIV2_gc       0x08
+#define RTC_PRESCALER_DIV32_gc      0x28
+#define RTC_PRESCALER_DIV1024_gc    0x50
+#define RTC_CTRLABUSY_bm            0x01
+#define RTC_CNTBUSY_bm              0x02
+#define RTC_PERBUSY_bm              0x04
+#define RTC_CMPBUSY_bm              0x08
+#define RTC_OVF_bm                  0x01
+#define RTC_CMP_bm                  0x02
+#define RTC_CLKSEL_INT32K_gc        0x00
+#define RTC_CLKSEL_INT1K_gc         0x01
+#define RTC_CLKSEL_TOSC32K_gc       0x02
+#define RTC_CLKSEL_EXTCLK_gc        0x03
+#define RTC_PITEN_bm                0x01
+#define RTC_PERIOD_OFF_gc           0x00
+#define RTC_PERIOD_CYC4_gc          0x08
+#define RTC_PERIOD_CYC8_gc          0x10
+#define RTC_PERIOD_CYC16_gc         0x18
+#define RTC_PERIOD_CYC32_gc         0x20
+#define RTC_PERIOD_CYC64_gc         0x28
+#define RTC_PERIOD_CYC128_gc        0x30
+#define RTC_PERIOD_CYC256_gc        0x38
+#define RTC_PERIOD_CYC512_gc        0x40
+#define RTC_PERIOD_CYC1024_gc       0x48
+#define RTC_PERIOD_CYC2048_gc       0x50
+#define RTC_PERIOD_CYC4096_gc       0x58
+#define RTC_PERIOD_CYC8192_gc       0x60
+#define RTC_PERIOD_CYC16384_gc      0x68
+#define RTC_PERIOD_CYC32768_gc      0x70
+#define RTC_CTRLBUSY_bm             0x01
+#define RTC_PI_bm                   0x01
+
+/* SIGROW */
+typedef struct
+{
+	register8_t TEMPSENSE0;
+	register8_t TEMPSENSE1;
+} SIGROW_t;
+
+/* SLPCTRL */
+typedef struct
+{
+	register8_t CTRLA;
+} SLPCTRL_t;
+
+#define SLPCTRL_SEN_bm              0x01
+#define SLPCTRL_SMODE_IDLE_gc       0x00
+#define SLPCTRL_SMODE_STDBY_gc      0x02
+#define SLPCTRL_SMODE_PDOWN_gc      0x04
+
+/* TCA, single-slope mode only */
+typedef struct
+{
+	register8_t CTRLA;
+	register8_t CTRLB;
+	register8_t EVCTRL;
+	register8_t INTCTRL;
+	register8_t INTFLAGS;
+	register16_t CNT;
+	register16_t PER;
+	register16_t CMP0;
+} TCA_SINGLE_t;
+
+typedef union
+{
+	TCA_SINGLE_t SINGLE;
+} TCA_t;
+
+#define TCA_SINGLE_ENABLE_bm        0x01
+#define TCA_SINGLE_CLKSEL_DIV1_gc   0x00
+#define TCA_SINGLE_CLKSEL_DIV2_gc   0x02
+#define TCA_SINGLE_CLKSEL_DIV4_gc   0x04
+#define TCA_SINGLE_CLKSEL_DIV8_gc   0x06
+#define TCA_SINGLE_CLKSEL_DIV16_gc  0x08
+#define TCA_SINGLE_CLKSEL_DIV64_gc  0x0A
+#define TCA_SINGLE_CLKSEL_DIV256_gc 0x0C
+#define TCA_SINGLE_CLKSEL_DIV1024_gc 0x0E
+
+/* TCB */
+typedef struct
+{
+	register8_t CTRLA;
+	register8_t CTRLB;
+	register8_t EVCTRL;
+	register8_t INTCTRL;
+	register8_t INTFLAGS;
+	register8_t STATUS;
+	register16_t CNT;
+	register16_t CCMP;
+} TCB_t;
+
+#define TCB_ENABLE_bm               0x01
+#define TCB_CLKSEL_DIV1_gc          0x00
+#define TCB_CLKSEL_DIV2_gc          0x02
+#define TCB_CLKSEL_TCA0_gc          0x04
+#define TCB_CLKSEL_EVENT_gc         0x0E
+#define TCB_CNTMODE_INT_gc          0x00
+#define TCB_CNTMODE_TIMEOUT_gc      0x01
+#define TCB_CNTMODE_CAPT_gc         0x02
+#define TCB_CNTMODE_FRQ_gc          0x03
+#define TCB_CNTMODE_PW_gc           0x04
+#define TCB_CNTMODE_FRQPW_gc        0x05
+#define TCB_CNTMODE_SINGLE_gc       0x06
+#define TCB_CNTMODE_PWM8_gc         0x07
+#define TCB_CAPTEI_bm               0x01
+#define TCB_CAPT_bm                 0x01
+
+/* USART */
+typedef struct
+{
+	register8_t RXDATAL;
+	register8_t RXDATAH;
+	register8_t TXDATAL;
+	register8_t TXDATAH;
+	register8_t STATUS;
+	register8_t CTRLA;
+	register8_t CTRLB;
+	register8_t CTRLC;
+	register16_t BAUD;
+} USART_t;
+
+#define USART_RXCIF_bm              0x80
+#define USART_TXCIF_bm              0x40
+#define USART_DREIF_bm              0x20
+#define USART_RXCIE_bm              0x80
+#define USART_TXCIE_bm              0x40
+#define USART_DREIE_bm              0x20
+#define USART_RXEN_bm               0x80
+#define USART_TXEN_bm               0x40
+#define USART_RXMODE_NORMAL_gc      0x00
+#define USART_RXMODE_CLK2X_gc       0x02
+
+/* WDT */
+#define WDT_PERIOD_OFF_gc           0x00
+#define WDT_PERIOD_8CLK_gc          0x01
+#define WDT_PERIOD_16CLK_gc         0x02
+#define WDT_PERIOD_32CLK_gc         0x03
+#define WDT_PERIOD_64CLK_gc         0x04
+#define WDT_PERIOD_128CLK_gc        0x05
+#define WDT_PERIOD_256CLK_gc        0x06
+#define WDT_PERIOD_512CLK_gc        0x07
+#define WDT_PERIOD_1KCLK_gc         0x08
+#define WDT_PERIOD_2KCLK_gc         0x09
+#define WDT_PERIOD_4KCLK_gc         0x0A
+#define WDT_PERIOD_8KCLK_gc         0x0B
+
+#ifdef AVR_SIM_ADC_HOOK
+/* Every access to ADC0 calls avr_sim_adc_hook(), which the test program
+defines. It returns the registers in avr_sim_adc0, and may first start a
+conversion or set flags, so that a model of the ADC can run the main loop of
+an example that polls the ADC. */
+AVR_SIM_STORAGE ADC_t avr_sim_adc0;
+ADC_t *avr_sim_adc_hook(void);
+#define ADC0                        (*avr_sim_adc_hook())
+#else
+AVR_SIM_STORAGE ADC_t ADC0;
+#endif
+AVR_SIM_STORAGE CCL_t CCL;
+AVR_SIM_STORAGE CLKCTRL_t CLKCTRL;
+AVR_SIM_STORAGE EVSYS_t EVSYS;
+AVR_SIM_STORAGE NVMCTRL_t NVMCTRL;
+AVR_SIM_STORAGE PORT_t PORTA;
+AVR_SIM_STORAGE PORT_t PORTB;
+AVR_SIM_STORAGE PORT_t PORTC;
+AVR_SIM_STORAGE VPORT_t VPORTA;
+AVR_SIM_STORAGE VPORT_t VPORTB;
+AVR_SIM_STORAGE VPORT_t VPORTC;
+AVR_SIM_STORAGE RSTCTRL_t RSTCTRL;
+AVR_SIM_STORAGE RTC_t RTC;
+AVR_SIM_STORAGE SIGROW_t SIGROW;
+AVR_SIM_STORAGE SLPCTRL_t SLPCTRL;
+AVR_SIM_STORAGE TCA_t TCA0;
+AVR_SIM_STORAGE TCB_t TCB0;
+AVR_SIM_STORAGE TCB_t TCB1;
+AVR_SIM_STORAGE USART_t USART0;
+
+/* Configuration Change Protection, <avr/xmega.h> in avr-libc */
+#define _PROTECTED_WRITE(reg, value)        ((reg) = (value))
+#define _PROTECTED_WRITE_SPM(reg, value)    ((reg) = (value))
+
+/* Global interrupt enable, the I bit of SREG */
+AVR_SIM_STORAGE volatile uint8_t avr_sim_interrupts;
+
+#endif /* AVR_SIM_IO_H */
@@ -0,0 +1,76 @@
+/*
+    \file   sleep.h
+
+    \brief  Host model of the sleep functions used by the code examples
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+#ifndef AVR_SIM_SLEEP_H
+#define AVR_SIM_SLEEP_H
+
+#include <avr/io.h>
+
+#define SLEEP_MODE_IDLE     SLPCTRL_SMODE_IDLE_gc
+#define SLEEP_MODE_STANDBY  SLPCTRL_SMODE_STDBY_gc
+#define SLEEP_MODE_PWR_DOWN SLPCTRL_SMODE_PDOWN_gc
+
+/* Called instead of sleeping, a test program sets it to run the peripherals that wake the CPU */
+AVR_SIM_STORAGE void (*avr_sim_sleep_hook)(void);
+/* Number of times the CPU went to sleep */
+AVR_SIM_STORAGE unsigned long avr_sim_sleeps;
+
+static inline void set_sleep_mode(uint8_t mode)
+{
+	SLPCTRL.CTRLA = (SLPCTRL.CTRLA & SLPCTRL_SEN_bm) | mode;
+}
+
+static inline void sleep_enable(void)
+{
+	SLPCTRL.CTRLA |= SLPCTRL_SEN_bm;
+}
+
+static inline void sleep_disable(void)
+{
+	SLPCTRL.CTRLA &= ~SLPCTRL_SEN_bm;
+}
+
+static inline void sleep_cpu(void)
+{
+	if(SLPCTRL.CTRLA & SLPCTRL_SEN_bm)
+	{
+		avr_sim_sleeps++;
+		if(avr_sim_sleep_hook)
+		{
+			avr_sim_sleep_hook();
+		}
+	}
+}
+
+static inline void sleep_mode(void)
+{
+	sleep_enable();
+	sleep_cpu();
+	sleep_disable();
+}
+
+#endif /* AVR_SIM_SLEEP_H */
@@ -0,0 +1,41 @@
+/*
+    \file   wdt.h
+
+    \brief  Host model of the watchdog functions used by the code examples
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+#ifndef AVR_SIM_WDT_H
+#define AVR_SIM_WDT_H
+
+#include <avr/io.h>
+
+/* Watchdog period set with wdt_enable(), and the number of wdt_reset() calls */
+AVR_SIM_STORAGE uint8_t avr_sim_wdt_period;
+AVR_SIM_STORAGE unsigned long avr_sim_wdt_resets;
+
+#define wdt_enable(period)  (avr_sim_wdt_period = (period))
+#define wdt_disable()       (avr_sim_wdt_period = WDT_PERIOD_OFF_gc)
+#define wdt_reset()         (avr_sim_wdt_resets++)
+
+#endif /* AVR_SIM_WDT_H */
@@ -0,0 +1,55 @@
+/*
+    \file   atomic.h
+
+    \brief  Host model of the atomic blocks used by the code examples
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+#ifndef AVR_SIM_ATOMIC_H
+#define AVR_SIM_ATOMIC_H
+
+#include <avr/interrupt.h>
+
+/* Same structure as in avr-libc: the state is restored when the block is left, also by return or break */
+static inline uint8_t avr_sim_cli_once(void)
+{
+	cli();
+	return 1;
+}
+
+static inline void avr_sim_restore(const uint8_t *state)
+{
+	avr_sim_interrupts = *state;
+}
+
+static inline void avr_sim_force_on(const uint8_t *state)
+{
+	(void)state;
+	sei();
+}
+
+#define ATOMIC_BLOCK(type)      for(type, avr_sim_todo = avr_sim_cli_once(); avr_sim_todo; avr_sim_todo = 0)
+#define ATOMIC_RESTORESTATE     uint8_t avr_sim_state __attribute__((cleanup(avr_sim_restore))) = avr_sim_interrupts
+#define ATOMIC_FORCEON          uint8_t avr_sim_state __attribute__((cleanup(avr_sim_force_on))) = 0
+
+#endif /* AVR_SIM_ATOMIC_H */
@@ -0,0 +1,220 @@
+/*
+    \file   dither_enob_sim.c
+
+    \brief  Host ENOB simulation of the series-dithered-oversampling example
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+/*
+ * Compiles the main.c of the series-dithered-oversampling example with the
+ * register model in host-tools/avr-sim, and measures the effective number of
+ * bits of the 17-bit result with and without the dither. Each conversion sees
+ * the signal and the resistor DAC level that the Sample Ready interrupt set,
+ * plus Gaussian noise, and is rounded to 12 bits. The accumulated result is
+ * converted as the main loop of the example does: DITHER_SUM is subtracted,
+ * then the extra bits are shifted out.
+ *
+ * The input is swept in small steps over a few LSB. The mean error of the
+ * results is the offset. The rms error around the mean gives the ENOB:
+ *     ENOB = 17 - log2(rms error * sqrt(12))
+ *
+ * DITHER_SUM is calculated from the nominal resistor values. The simulation is
+ * repeated with resistor sets within the given tolerance, and prints the range
+ * of the offset that the tolerance causes. The simulation fails when the dither
+ * gains less than 2 bits on a quiet input (noise below QUIET_NOISE) with
+ * nominal resistors, or when the tolerance moves the offset by more than the
+ * bound given in main.c: 2 * tolerance * DITHER_SUM, in accumulated codes.
+ *
+ * Build:   gcc -O2 -Wall -I../avr-sim -o dither_enob_sim dither_enob_sim.c -lm
+ * Usage:   dither_enob_sim [noise LSB rms [tolerance %]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define main firmware_main
+#include "../../attiny1627-how-to-use-the-12-bit-differential-adc-with-pga/series-dithered-oversampling/main.c"
+#undef main
+
+#define VDD             3.3     /* V */
+#define SWEEP_START     1.0     /* V */
+#define SWEEP_LSB       8       /* Sweep range in 12-bit LSB */
+#define SWEEP_STEPS     128
+#define TOLERANCE_SETS  100     /* Resistor sets in the tolerance run */
+#define QUIET_NOISE     0.3     /* LSB rms, below this the dither must gain resolution */
+#define OFFSET_MARGIN   0.25    /* 17-bit LSB, for the noise of the offset estimate */
+
+/* Attenuation of the signal and weight of each dither pin, as built */
+typedef struct
+{
+	double signal_gain;
+	double dither_weight[4];
+} dac_t;
+
+typedef struct
+{
+	double enob;
+	double offset;  /* 17-bit LSB */
+} sweep_result_t;
+
+static double noise_rms;
+static int failures;
+
+static double gaussian(void)
+{
+	double u1 = (rand() + 1.0) / (RAND_MAX + 2.0);
+	double u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+
+	return sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+}
+
+/* Uniform in [-1, 1] */
+static double uniform(void)
+{
+	return 2.0 * rand() / RAND_MAX - 1;
+}
+
+static void dac_build(dac_t *dac, double tolerance)
+{
+	const double nominal[4] = { R_DITHER_0, R_DITHER_1, R_DITHER_2, R_DITHER_3 };
+	double g_source = 1 / (R_SOURCE * (1 + tolerance * uniform()));
+	double g_dither[4];
+	double g_total = g_source;
+
+	for(int i = 0; i < 4; i++)
+	{
+		g_dither[i] = 1 / (nominal[i] * (1 + tolerance * uniform()));
+		g_total += g_dither[i];
+	}
+	dac->signal_gain = g_source / g_total;
+	for(int i = 0; i < 4; i++)
+	{
+		dac->dither_weight[i] = g_dither[i] / g_total;
+	}
+}
+
+/* One accumulation, converted as in the main loop of the example */
+static uint32_t measure(const dac_t *dac, double signal, int dither)
+{
+	uint32_t accumulated = 0;
+	uint32_t dither_sum = dither ? DITHER_SUM : 0;
+
+	VPORTC.OUT = 0; /* dither_sequence[0] */
+	for(int k = 0; k < ADC_SAMPLES; k++)
+	{
+		double voltage = dac->signal_gain * signal;
+		double code;
+
+		for(int i = 0; i < 4; i++)
+		{
+			if(dither && (VPORTC.OUT & (1 << i)))
+			{
+				voltage += dac->dither_weight[i] * VDD;
+			}
+		}
+		code = floor(voltage / VDD * 4096 + 0.5 + noise_rms * gaussian());
+		accumulated += (code < 0) ? 0 : (code > 4095) ? 4095 : (uint32_t) code;
+
+		if(dither)
+		{
+			ADC0.INTFLAGS = ADC_SAMPRDY_bm;
+			ADC0_SAMPRDY_vect();
+		}
+	}
+	accumulated = (accumulated > dither_sum) ? accumulated - dither_sum : 0;
+	return accumulated >> OVERSAMPLING_BITS;
+}
+
+static sweep_result_t sweep(const dac_t *dac, int dither)
+{
+	double error[SWEEP_STEPS];
+	double sum = 0;
+	double square_sum = 0;
+	sweep_result_t result;
+
+	for(int j = 0; j < SWEEP_STEPS; j++)
+	{
+		double signal = SWEEP_START + (double) j * SWEEP_LSB * VDD / 4096 / SWEEP_STEPS;
+		/* The reading the firmware expects for this signal, 17-bit LSB */
+		double ideal = signal * SIGNAL_GAIN / VDD * 4096 * (1 << OVERSAMPLING_BITS);
+
+		error[j] = measure(dac, signal, dither) - ideal;
+		sum += error[j];
+	}
+	result.offset = sum / SWEEP_STEPS;
+	for(int j = 0; j < SWEEP_STEPS; j++)
+	{
+		square_sum += (error[j] - result.offset) * (error[j] - result.offset);
+	}
+	result.enob = 12 + OVERSAMPLING_BITS - log2(sqrt(square_sum / SWEEP_STEPS) * sqrt(12));
+	return result;
+}
+
+int main(int argc, char *argv[])
+{
+	double tolerance;
+	dac_t dac;
+	sweep_result_t plain;
+	sweep_result_t dithered;
+	double offset_min = INFINITY;
+	double offset_max = -INFINITY;
+	double enob_min = INFINITY;
+	double offset_bound;
+
+	noise_rms = (argc > 1) ? atof(argv[1]) : 0.1;
+	tolerance = ((argc > 2) ? atof(argv[2]) : 1.0) / 100;
+	srand(1);
+
+	printf("Noise %.2f LSB rms, %d inputs over %d LSB from %.3f V, DITHER_SUM %lu\n",
+	       noise_rms, SWEEP_STEPS, SWEEP_LSB, SWEEP_START, (unsigned long) DITHER_SUM);
+	printf("%-32s %6s %20s\n", "", "ENOB", "offset (17-bit LSB)");
+
+	dac_build(&dac, 0);
+	plain = sweep(&dac, 0);
+	dithered = sweep(&dac, 1);
+	printf("%-32s %6.2f %20.2f\n", "without dither", plain.enob, plain.offset);
+	printf("%-32s %6.2f %20.2f\n", "with dither, nominal resistors", dithered.enob, dithered.offset);
+
+	for(int i = 0; i < TOLERANCE_SETS; i++)
+	{
+		sweep_result_t result;
+
+		dac_build(&dac, tolerance);
+		result = sweep(&dac, 1);
+		offset_min = fmin(offset_min, result.offset);
+		offset_max = fmax(offset_max, result.offset);
+		enob_min = fmin(enob_min, result.enob);
+	}
+	printf("with dither, %d sets at %.1f %%: ENOB >= %.2f, offset %.2f to %.2f\n",
+	       TOLERANCE_SETS, tolerance * 100, enob_min, offset_min, offset_max);
+
+	/* Bound from main.c, in 17-bit LSB */
+	offset_bound = 2 * tolerance * DITHER_SUM / (1 << OVERSAMPLING_BITS);
+	printf("tolerance offset bound: %.2f\n", offset_bound);
+
+	failures += (noise_rms < QUIET_NOISE) && (dithered.enob < plain.enob + 2);
+	failures += (fabs(dithered.offset) > 1);
+	failures += (fmax(dithered.offset - offset_min, offset_max - dithered.offset) > offset_bound + OFFSET_MARGIN);
+	printf("%s\n", failures ? "FAILED" : "PASSED");
+	return failures ? 1 : 0;
+}
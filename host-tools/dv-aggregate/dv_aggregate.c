@@ -0,0 +1,524 @@
+/*
+    \file   dv_aggregate.c
+
+    \brief  Linux host tool that merges the Data Visualizer streams of many boards into one file
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+/*
+ * Reads the Data Visualizer streams of many boards running the same code
+ * example, from serial ports or ptys, in one thread with epoll. The frames are
+ * decoded with dv_stream.c, given a timestamp, and written to one file ordered
+ * by time.
+ *
+ * The timestamp of a frame is the time it was received, corrected for the
+ * frames received after it in the same read. When the payload contains a
+ * timestamp from the device, -t gives the column and the rate of its counter,
+ * and the timestamps are then the time the first frame was received plus the
+ * counter ticks since the first frame. 8, 16 and 32-bit counters may wrap
+ * around.
+ *
+ * Each stream has a queue of QUEUE_LENGTH frames. A frame is written when no
+ * stream can deliver an older frame any more: every other stream has a queued
+ * frame that is not older, or has been silent for longer than the lag given
+ * with -l. When a queue is full, the oldest queued frames are written anyway,
+ * so the memory used is fixed by the number of streams.
+ *
+ * The output file starts with the 8 bytes "DVAGGR1\0", the number of streams
+ * and the number of columns as 32-bit values, one type byte per column (the
+ * dv_type_t values), and for each stream the length of its name as a 16-bit
+ * value followed by the name. Then follow the records: a 64-bit timestamp in
+ * nanoseconds since 1970, the 16-bit stream number, and the payload of the
+ * frame. For every INDEX_INTERVAL records, the index file <output>.idx gets
+ * the timestamp and the file offset of the record as two 64-bit values. All
+ * values are little endian.
+ *
+ * Build:   gcc -O2 -Wall -I../dv-stream -o dv_aggregate dv_aggregate.c ../dv-stream/dv_stream.c
+ * Usage:   dv_aggregate [options] -o <output> <device>...
+ *
+ * Options:
+ *   -f <types>      Payload format, e.g. "f32" or "u16,u16" (default: f32)
+ *   -c <file>       Payload format from a Data Visualizer stream configuration file
+ *   -B <baud>       Baud rate of the serial ports (default: 9600)
+ *   -t <col>:<Hz>   Column with a timestamp counter from the device, and the rate of the counter
+ *   -l <ms>         Time to wait for a silent stream before writing newer frames (default: 100)
+ *   -o <file>       Output file, and <file>.idx for the index
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+
+#include "dv_stream.h"
+
+#define QUEUE_LENGTH        1024    /* Frames queued per stream */
+#define READ_SIZE           4096    /* Bytes read from a stream at a time */
+#define INDEX_INTERVAL      4096    /* Records per index entry */
+#define MAX_EVENTS          64
+#define NS_PER_S            1000000000ll
+
+typedef struct
+{
+	const char *path;
+	int fd;
+	int open;
+	dv_parser_t parser;
+
+	/* Received bytes that do not make a complete frame yet */
+	uint8_t buffer[READ_SIZE + 2 * (DV_MAX_COLUMNS * 4 + 2)];
+	size_t used;
+
+	/* Timestamps of the frames in the current read */
+	int64_t read_time;
+	size_t read_frames;
+	size_t read_index;
+
+	/* Device counter state, for -t */
+	int64_t counter_start_time;
+	uint64_t counter_ticks;
+	uint32_t counter_last;
+	int counter_started;
+
+	/* Queue of decoded frames, oldest at head */
+	int64_t *times;
+	uint8_t *payloads;
+	size_t head;
+	size_t count;
+	int64_t last_time;
+	int64_t last_read;
+
+	uint64_t late;
+	uint64_t forced;
+} stream_t;
+
+typedef struct
+{
+	FILE *out;
+	FILE *index;
+	uint64_t offset;
+	uint64_t records;
+	int64_t last_time;
+} output_t;
+
+static dv_format_t format;
+static stream_t *streams;
+static int stream_count;
+static output_t output;
+static int time_column = -1;
+static double time_rate;
+static int64_t frame_ns;
+static volatile sig_atomic_t stop;
+
+static void on_signal(int signal)
+{
+	(void)signal;
+	stop = 1;
+}
+
+static int64_t now_ns()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return ts.tv_sec * NS_PER_S + ts.tv_nsec;
+}
+
+static void write_le(FILE *out, uint64_t value, int bytes)
+{
+	for(int i = 0; i < bytes; i++)
+	{
+		fputc((value >> (8 * i)) & 0xFF, out);
+	}
+}
+
+static void output_header()
+{
+	fwrite("DVAGGR1", 1, 8, output.out);
+	write_le(output.out, stream_count, 4);
+	write_le(output.out, format.columns, 4);
+	output.offset = 16;
+	for(int i = 0; i < format.columns; i++)
+	{
+		fputc(format.types[i], output.out);
+		output.offset++;
+	}
+	for(int i = 0; i < stream_count; i++)
+	{
+		size_t len = strlen(streams[i].path);
+
+		write_le(output.out, len, 2);
+		fwrite(streams[i].path, 1, len, output.out);
+		output.offset += 2 + len;
+	}
+}
+
+/* Writes and removes the frame at the head of a stream queue */
+static void output_record(int number)
+{
+	stream_t *stream = &streams[number];
+	int64_t time = stream->times[stream->head];
+
+	if(output.records % INDEX_INTERVAL == 0)
+	{
+		write_le(output.index, time, 8);
+		write_le(output.index, output.offset, 8);
+	}
+	/* Frames that were older than the frames already written */
+	if(time < output.last_time)
+	{
+		stream->late++;
+	}
+	else
+	{
+		output.last_time = time;
+	}
+	write_le(output.out, time, 8);
+	write_le(output.out, number, 2);
+	fwrite(&stream->payloads[stream->head * format.payload_size], 1, format.payload_size, output.out);
+	output.offset += 10 + format.payload_size;
+	output.records++;
+
+	stream->head = (stream->head + 1) % QUEUE_LENGTH;
+	stream->count--;
+}
+
+/* Returns the stream with the oldest queued frame, or -1 if all queues are empty */
+static int oldest_stream()
+{
+	int oldest = -1;
+
+	for(int i = 0; i < stream_count; i++)
+	{
+		if(streams[i].count && (oldest < 0 || streams[i].times[streams[i].head] < streams[oldest].times[streams[oldest].head]))
+		{
+			oldest = i;
+		}
+	}
+	return oldest;
+}
+
+/* Writes the queued frames that no stream can deliver an older frame than */
+static void output_ready(int64_t now, int64_t lag)
+{
+	int64_t watermark = INT64_MAX;
+
+	/* The next frame of a stream is not older than its last frame, unless the stream has been silent */
+	for(int i = 0; i < stream_count; i++)
+	{
+		if(streams[i].open && now - streams[i].last_read < lag && streams[i].last_time < watermark)
+		{
+			watermark = streams[i].last_time;
+		}
+	}
+
+	for(int oldest = oldest_stream(); oldest >= 0; oldest = oldest_stream())
+	{
+		if(streams[oldest].times[streams[oldest].head] > watermark)
+		{
+			break;
+		}
+		output_record(oldest);
+	}
+}
+
+static int64_t frame_time(stream_t *stream, const uint8_t *payload)
+{
+	/* Received time, minus the time to receive the frames after this one */
+	int64_t after = (int64_t)stream->read_frames - (int64_t)++stream->read_index;
+	int64_t received = stream->read_time - (after > 0 ? after : 0) * frame_ns;
+
+	/* Frames received faster than the baud rate allows, e.g. from a pty, or frames from a stream that was
+	   silent, would otherwise be older than frames already written */
+	if(received < stream->last_time)
+	{
+		received = stream->last_time;
+	}
+	if(received < output.last_time)
+	{
+		received = output.last_time;
+	}
+
+	if(time_column < 0)
+	{
+		return received;
+	}
+
+	uint32_t counter = (uint32_t)(int64_t)dv_value(&format, payload, time_column);
+	uint32_t mask = (dv_type_size(format.types[time_column]) == 4) ? UINT32_MAX :
+	                (1u << (8 * dv_type_size(format.types[time_column]))) - 1;
+
+	if(!stream->counter_started)
+	{
+		stream->counter_started = 1;
+		stream->counter_start_time = received;
+		stream->counter_last = counter;
+	}
+	stream->counter_ticks += (counter - stream->counter_last) & mask;
+	stream->counter_last = counter;
+	return stream->counter_start_time + (int64_t)(stream->counter_ticks / time_rate * NS_PER_S);
+}
+
+static void queue_batch(void *context, const uint8_t *const *payloads, size_t count)
+{
+	stream_t *stream = context;
+	for(size_t i = 0; i < count; i++)
+	{
+		/* A full queue is emptied by writing the oldest frames of all streams */
+		while(stream->count == QUEUE_LENGTH)
+		{
+			int oldest = oldest_stream();
+
+			streams[oldest].forced++;
+			output_record(oldest);
+		}
+
+		size_t tail = (stream->head + stream->count) % QUEUE_LENGTH;
+		int64_t time = frame_time(stream, payloads[i]);
+
+		stream->times[tail] = time;
+		memcpy(&stream->payloads[tail * format.payload_size], payloads[i], format.payload_size);
+		stream->count++;
+		stream->last_time = time;
+	}
+}
+
+/* Counts the frames in the buffer, so their receive times can be spread over the read */
+static size_t count_frames(const uint8_t *data, size_t len)
+{
+	size_t frame_size = format.payload_size + 2;
+	size_t frames = 0;
+
+	for(size_t pos = 0; pos + frame_size <= len; pos++)
+	{
+		if(data[pos] == DV_START_BYTE && data[pos + frame_size - 1] == DV_STOP_BYTE)
+		{
+			frames++;
+			pos += frame_size - 1;
+		}
+	}
+	return frames;
+}
+
+static void stream_read(stream_t *stream, int epoll_fd)
+{
+	for(;;)
+	{
+		ssize_t n = read(stream->fd, stream->buffer + stream->used, READ_SIZE);
+
+		if(n < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		{
+			return;
+		}
+		if(n <= 0)
+		{
+			/* End of file, or the other side of a pty was closed */
+			epoll_ctl(epoll_fd, EPOLL_CTL_DEL, stream->fd, NULL);
+			close(stream->fd);
+			stream->open = 0;
+			return;
+		}
+
+		stream->used += n;
+		stream->read_time = now_ns();
+		stream->last_read = stream->read_time;
+		stream->read_frames = count_frames(stream->buffer, stream->used);
+		stream->read_index = 0;
+
+		size_t consumed = dv_parse(&stream->parser, stream->buffer, stream->used, queue_batch, stream);
+		memmove(stream->buffer, stream->buffer + consumed, stream->used - consumed);
+		stream->used -= consumed;
+	}
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "usage: %s [-f types | -c config.txt] [-B baud] [-t column:Hz] [-l ms] -o output <device>...\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *spec = "f32";
+	const char *config = NULL;
+	const char *out_path = NULL;
+	long baud = 9600;
+	int64_t lag = 100 * 1000000ll;
+	int opt;
+
+	while((opt = getopt(argc, argv, "f:c:B:t:l:o:")) != -1)
+	{
+		switch(opt)
+		{
+		case 'f': spec = optarg; break;
+		case 'c': config = optarg; break;
+		case 'B': baud = atol(optarg); break;
+		case 'l': lag = atol(optarg) * 1000000ll; break;
+		case 'o': out_path = optarg; break;
+		case 't':
+			if(sscanf(optarg, "%d:%lf", &time_column, &time_rate) != 2 || time_rate <= 0)
+			{
+				usage(argv[0]);
+				return 2;
+			}
+			break;
+		default:
+			usage(argv[0]);
+			return 2;
+		}
+	}
+	if(optind == argc || !out_path)
+	{
+		usage(argv[0]);
+		return 2;
+	}
+	if((config ? dv_format_load(&format, config) : dv_format_parse(&format, spec)) < 0)
+	{
+		usage(argv[0]);
+		return 2;
+	}
+	if(time_column >= format.columns || (time_column >= 0 && format.types[time_column] == DV_F32))
+	{
+		fprintf(stderr, "the timestamp column must be an integer column of the payload\n");
+		return 2;
+	}
+	/* 10 bits per byte on the UART */
+	frame_ns = (int64_t)(format.payload_size + 2) * 10 * NS_PER_S / baud;
+
+	stream_count = argc - optind;
+	streams = calloc(stream_count, sizeof(*streams));
+	if(!streams)
+	{
+		perror("calloc");
+		return 1;
+	}
+
+	int epoll_fd = epoll_create1(0);
+	if(epoll_fd < 0)
+	{
+		perror("epoll_create1");
+		return 1;
+	}
+
+	for(int i = 0; i < stream_count; i++)
+	{
+		stream_t *stream = &streams[i];
+		struct epoll_event event = { .events = EPOLLIN, .data.ptr = stream };
+
+		stream->path = argv[optind + i];
+		stream->fd = dv_open(stream->path, baud, O_NONBLOCK);
+		stream->times = malloc(QUEUE_LENGTH * sizeof(*stream->times));
+		stream->payloads = malloc(QUEUE_LENGTH * format.payload_size);
+		if(stream->fd < 0 || !stream->times || !stream->payloads)
+		{
+			return 1;
+		}
+		if(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, stream->fd, &event) < 0)
+		{
+			fprintf(stderr, "%s: %s\n", stream->path, strerror(errno));
+			return 1;
+		}
+		stream->open = 1;
+		dv_parser_init(&stream->parser, &format);
+	}
+
+	char index_path[4096];
+	snprintf(index_path, sizeof(index_path), "%s.idx", out_path);
+	output.out = fopen(out_path, "wb");
+	output.index = fopen(index_path, "wb");
+	if(!output.out || !output.index)
+	{
+		fprintf(stderr, "%s: %s\n", output.out ? index_path : out_path, strerror(errno));
+		return 1;
+	}
+	output_header();
+
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+
+	int open_streams = stream_count;
+	while(!stop && open_streams)
+	{
+		struct epoll_event events[MAX_EVENTS];
+		int n = epoll_wait(epoll_fd, events, MAX_EVENTS, lag / 1000000 + 1);
+
+		if(n < 0 && errno != EINTR)
+		{
+			perror("epoll_wait");
+			break;
+		}
+		for(int i = 0; i < n; i++)
+		{
+			stream_t *stream = events[i].data.ptr;
+
+			stream_read(stream, epoll_fd);
+			if(!stream->open)
+			{
+				open_streams--;
+			}
+		}
+		output_ready(now_ns(), lag);
+	}
+
+	/* Write the frames still queued */
+	for(int oldest = oldest_stream(); oldest >= 0; oldest = oldest_stream())
+	{
+		output_record(oldest);
+	}
+	fclose(output.out);
+	fclose(output.index);
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	for(int i = 0; i < stream_count; i++)
+	{
+		stream_t *stream = &streams[i];
+
+		fprintf(stderr, "%s: %llu frames, %llu resyncs, %llu bytes skipped, %llu late, %llu forced\n", stream->path,
+		        (unsigned long long)stream->parser.frames, (unsigned long long)stream->parser.resyncs,
+		        (unsigned long long)stream->parser.skipped_bytes, (unsigned long long)stream->late,
+		        (unsigned long long)stream->forced);
+		if(stream->open)
+		{
+			close(stream->fd);
+		}
+		free(stream->times);
+		free(stream->payloads);
+	}
+	fprintf(stderr, "%llu records from %d streams, %.2f s CPU time\n", (unsigned long long)output.records, stream_count,
+	        usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6);
+
+	free(streams);
+	close(epoll_fd);
+	return 0;
+}
@@ -0,0 +1,300 @@
+/*
+    \file   dv_aggregate_test.c
+
+    \brief  Scalability test of the Data Visualizer stream aggregator with many pseudo terminals
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+/*
+ * Runs dv_aggregate on many pseudo terminals at once, as a rack of boards
+ * running the same code example. Every stream sends the frame "u16,u16" with a
+ * sequence number and the stream number, one frame per interval, for the
+ * given time. Then the master sides are closed, so that dv_aggregate sees all
+ * streams end and writes the remaining frames.
+ *
+ * The output file must hold every frame of every stream, with the sequence
+ * numbers of each stream in order and the timestamps of all records not
+ * decreasing. The CPU time dv_aggregate used is measured with wait4() and
+ * printed per frame and as a share of one core.
+ *
+ * Build:   gcc -O2 -Wall -I../dv-stream -o dv_aggregate_test dv_aggregate_test.c
+ * Usage:   dv_aggregate_test <path to dv_aggregate> [streams, default 128] [seconds, default 5] [interval ms, default 10]
+ */
+
+#define _DEFAULT_SOURCE
+#define _XOPEN_SOURCE 600
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "dv_stream.h"
+
+#define PAYLOAD_SIZE        4       /* u16 sequence number, u16 stream number */
+#define RECORD_SIZE         (8 + 2 + PAYLOAD_SIZE)
+#define EXIT_TIMEOUT_MS     5000
+
+static int failures;
+
+static void check(int condition, const char *name)
+{
+	printf("%-50s %s\n", name, condition ? "ok" : "FAILED");
+	if(!condition)
+	{
+		failures++;
+	}
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t read_le(const uint8_t *data, int bytes)
+{
+	uint64_t value = 0;
+
+	for(int i = bytes - 1; i >= 0; i--)
+	{
+		value = (value << 8) | data[i];
+	}
+	return value;
+}
+
+/* Checks the records in the output file, returns the number of records */
+static uint64_t check_output(const char *path, int stream_count, uint32_t frames)
+{
+	FILE *in = fopen(path, "rb");
+	uint8_t header[16];
+	uint8_t record[RECORD_SIZE];
+	uint32_t *next = calloc(stream_count, sizeof(*next));
+	uint64_t records = 0;
+	uint64_t last_time = 0;
+	int ordered = 1;
+	int sequences = 1;
+
+	if(!in || !next || fread(header, 1, sizeof(header), in) != sizeof(header) || memcmp(header, "DVAGGR1", 8) != 0 ||
+	   read_le(&header[8], 4) != (uint64_t)stream_count || read_le(&header[12], 4) != 2)
+	{
+		check(0, "output header");
+		return 0;
+	}
+	/* Column types, then the stream names */
+	fseek(in, 2, SEEK_CUR);
+	for(int i = 0; i < stream_count; i++)
+	{
+		uint8_t len[2];
+
+		if(fread(len, 1, 2, in) != 2)
+		{
+			check(0, "output header");
+			return 0;
+		}
+		fseek(in, read_le(len, 2), SEEK_CUR);
+	}
+
+	while(fread(record, 1, RECORD_SIZE, in) == RECORD_SIZE)
+	{
+		uint64_t time = read_le(record, 8);
+		uint32_t number = read_le(&record[8], 2);
+		uint32_t sequence = read_le(&record[10], 2);
+
+		if(time < last_time)
+		{
+			ordered = 0;
+		}
+		last_time = time;
+		if(number >= (uint32_t)stream_count || read_le(&record[12], 2) != number ||
+		   sequence != (next[number] & 0xFFFF))
+		{
+			sequences = 0;
+		}
+		else
+		{
+			next[number]++;
+		}
+		records++;
+	}
+
+	int complete = 1;
+	for(int i = 0; i < stream_count; i++)
+	{
+		complete &= next[i] == frames;
+	}
+	check(records == (uint64_t)stream_count * frames && complete, "every frame of every stream written");
+	check(sequences, "frames of each stream in order");
+	check(ordered, "records ordered by time");
+
+	free(next);
+	fclose(in);
+	return records;
+}
+
+int main(int argc, char *argv[])
+{
+	if(argc < 2 || argc > 5)
+	{
+		fprintf(stderr, "usage: %s <path to dv_aggregate> [streams] [seconds] [interval ms]\n", argv[0]);
+		return 2;
+	}
+	const char *tool_path = argv[1];
+	int stream_count = (argc > 2) ? atoi(argv[2]) : 128;
+	double seconds = (argc > 3) ? atof(argv[3]) : 5.0;
+	double interval = ((argc > 4) ? atof(argv[4]) : 10.0) * 1e-3;
+	uint32_t frames = (uint32_t)(seconds / interval);
+
+	/* Two file descriptors per stream here, and one in dv_aggregate */
+	struct rlimit limit;
+	getrlimit(RLIMIT_NOFILE, &limit);
+	if(stream_count < 1 || (rlim_t)(2 * stream_count + 16) > limit.rlim_cur)
+	{
+		fprintf(stderr, "1 to %ld streams with the current file limit\n", (long)(limit.rlim_cur - 16) / 2);
+		return 2;
+	}
+
+	int *masters = calloc(stream_count, sizeof(*masters));
+	char **argv_tool = calloc(stream_count + 8, sizeof(*argv_tool));
+	char out_path[] = "/tmp/dv_aggregate_test_XXXXXX";
+	char index_path[sizeof(out_path) + 4];
+	int out_fd = mkstemp(out_path);
+	if(!masters || !argv_tool || out_fd < 0)
+	{
+		perror("setup");
+		return 1;
+	}
+	close(out_fd);
+	snprintf(index_path, sizeof(index_path), "%s.idx", out_path);
+
+	int arg = 0;
+	argv_tool[arg++] = (char *)tool_path;
+	argv_tool[arg++] = "-B";
+	argv_tool[arg++] = "115200";
+	argv_tool[arg++] = "-f";
+	argv_tool[arg++] = "u16,u16";
+	argv_tool[arg++] = "-o";
+	argv_tool[arg++] = out_path;
+	for(int i = 0; i < stream_count; i++)
+	{
+		struct termios tty;
+
+		masters[i] = posix_openpt(O_RDWR | O_NOCTTY);
+		if(masters[i] < 0 || grantpt(masters[i]) < 0 || unlockpt(masters[i]) < 0)
+		{
+			perror("posix_openpt");
+			return 1;
+		}
+		/* Not inherited by dv_aggregate, so that closing it here hangs up the stream */
+		fcntl(masters[i], F_SETFD, FD_CLOEXEC);
+		argv_tool[arg++] = strdup(ptsname(masters[i]));
+
+		/* Raw before dv_aggregate opens it, so that no byte is changed by the line discipline */
+		int slave_fd = open(argv_tool[arg - 1], O_RDWR | O_NOCTTY);
+		if(slave_fd < 0 || tcgetattr(slave_fd, &tty) < 0)
+		{
+			perror(argv_tool[arg - 1]);
+			return 1;
+		}
+		cfmakeraw(&tty);
+		tcsetattr(slave_fd, TCSANOW, &tty);
+		close(slave_fd);
+	}
+
+	pid_t pid = fork();
+	if(pid == 0)
+	{
+		execv(tool_path, argv_tool);
+		perror(tool_path);
+		_exit(127);
+	}
+	/* Let dv_aggregate open the streams */
+	usleep(200000);
+
+	printf("%d streams, %u frames each, one every %.1f ms\n", stream_count, frames, interval * 1e3);
+	double start = now();
+	for(uint32_t n = 0; n < frames; n++)
+	{
+		for(int i = 0; i < stream_count; i++)
+		{
+			uint8_t frame[PAYLOAD_SIZE + 2] =
+			{
+				DV_START_BYTE, n & 0xFF, (n >> 8) & 0xFF, i & 0xFF, (i >> 8) & 0xFF, DV_STOP_BYTE
+			};
+
+			if(write(masters[i], frame, sizeof(frame)) != sizeof(frame))
+			{
+				perror("write");
+				return 1;
+			}
+		}
+
+		double wait = start + (n + 1) * interval - now();
+		if(wait > 0)
+		{
+			usleep(wait * 1e6);
+		}
+	}
+	double wall = now() - start;
+
+	/* Wait for the last frames to be read, then hang up all streams */
+	usleep(200000);
+	for(int i = 0; i < stream_count; i++)
+	{
+		close(masters[i]);
+	}
+
+	struct rusage usage;
+	int status = 0;
+	int exited = 0;
+	for(int ms = 0; ms < EXIT_TIMEOUT_MS && !exited; ms += 10)
+	{
+		usleep(10000);
+		exited = wait4(pid, &status, WNOHANG, &usage) == pid;
+	}
+	if(!exited)
+	{
+		kill(pid, SIGKILL);
+		wait4(pid, &status, 0, &usage);
+	}
+	check(exited && WIFEXITED(status) && WEXITSTATUS(status) == 0, "dv_aggregate exits when all streams end");
+
+	uint64_t records = check_output(out_path, stream_count, frames);
+	double cpu = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+	printf("%llu records in %.2f s, %.0f frames/s, dv_aggregate used %.2f s CPU, %.1f %% of a core, %.1f us per frame\n",
+	       (unsigned long long)records, wall, records / wall, cpu, 100 * cpu / wall, records ? cpu / records * 1e6 : 0.0);
+
+	unlink(out_path);
+	unlink(index_path);
+	printf("%s\n", failures ? "FAILED" : "PASSED");
+	return failures ? 1 : 0;
+}
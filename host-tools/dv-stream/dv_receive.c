@@ -0,0 +1,260 @@
+/*
+    \file   dv_receive.c
+
+    \brief  Linux host tool that receives Data Visualizer streams from the code examples
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+/*
+ * Reads the 0x33/~0x33 framed stream sent by USART_send_DV() and similar
+ * functions in the code examples, from a serial port or a recorded file, and
+ * writes the values as CSV or as a columnar binary file. Statistics and the
+ * decoding rate are printed when the input ends or on Ctrl+C.
+ *
+ * The columnar binary file starts with the 8 bytes "DVCOLS1\0", the number of
+ * columns as a 32-bit value and one type byte per column (the dv_type_t
+ * values). Then follow blocks of a 32-bit row count and, for each column, the
+ * values of all rows in the block. All values are little endian.
+ *
+ * Build:   gcc -O2 -Wall -o dv_receive dv_receive.c dv_stream.c
+ * Usage:   dv_receive [options] <device or file>
+ *
+ * Options:
+ *   -f <types>      Payload format, e.g. "f32" or "u16,u16" (default: f32)
+ *   -c <file>       Payload format from a Data Visualizer stream configuration file
+ *   -B <baud>       Baud rate, when the input is a serial port (default: 9600)
+ *   -o <file>       Output file (default: standard output)
+ *   -b              Write the columnar binary format instead of CSV
+ */
+
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "dv_stream.h"
+
+#define READ_BUFFER_SIZE    (1 << 20)
+
+typedef struct
+{
+	FILE *out;
+	const dv_format_t *format;
+	int binary;
+} output_t;
+
+static volatile sig_atomic_t stop;
+
+static void on_signal(int signal)
+{
+	(void)signal;
+	stop = 1;
+}
+
+static void write_le(FILE *out, uint32_t value, int bytes)
+{
+	for(int i = 0; i < bytes; i++)
+	{
+		fputc((value >> (8 * i)) & 0xFF, out);
+	}
+}
+
+static void write_header(const output_t *output)
+{
+	const dv_format_t *format = output->format;
+
+	if(output->binary)
+	{
+		fwrite("DVCOLS1", 1, 8, output->out);
+		write_le(output->out, format->columns, 4);
+		for(int i = 0; i < format->columns; i++)
+		{
+			fputc(format->types[i], output->out);
+		}
+		return;
+	}
+	for(int i = 0; i < format->columns; i++)
+	{
+		fprintf(output->out, "%s%s", i ? "," : "", format->names[i]);
+	}
+	fputc('\n', output->out);
+}
+
+static void write_batch(void *context, const uint8_t *const *payloads, size_t count)
+{
+	const output_t *output = context;
+	const dv_format_t *format = output->format;
+
+	if(output->binary)
+	{
+		/* The payloads are already little endian, so the values are copied as they are */
+		write_le(output->out, count, 4);
+		for(int column = 0; column < format->columns; column++)
+		{
+			size_t size = dv_type_size(format->types[column]);
+
+			for(size_t row = 0; row < count; row++)
+			{
+				fwrite(payloads[row] + format->offsets[column], 1, size, output->out);
+			}
+		}
+		return;
+	}
+
+	for(size_t row = 0; row < count; row++)
+	{
+		for(int column = 0; column < format->columns; column++)
+		{
+			double value = dv_value(format, payloads[row], column);
+
+			if(format->types[column] == DV_F32)
+			{
+				fprintf(output->out, "%s%.7g", column ? "," : "", value);
+			}
+			else
+			{
+				fprintf(output->out, "%s%.0f", column ? "," : "", value);
+			}
+		}
+		fputc('\n', output->out);
+	}
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "usage: %s [-f types | -c config.txt] [-B baud] [-o output] [-b] <device or file>\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+	dv_format_t format;
+	dv_parser_t parser;
+	output_t output = { stdout, &format, 0 };
+	const char *spec = "f32";
+	const char *config = NULL;
+	const char *out_path = NULL;
+	long baud = 9600;
+	struct timespec start, end;
+	uint64_t bytes = 0;
+	int opt;
+
+	while((opt = getopt(argc, argv, "f:c:B:o:b")) != -1)
+	{
+		switch(opt)
+		{
+		case 'f': spec = optarg; break;
+		case 'c': config = optarg; break;
+		case 'B': baud = atol(optarg); break;
+		case 'o': out_path = optarg; break;
+		case 'b': output.binary = 1; break;
+		default:
+			usage(argv[0]);
+			return 2;
+		}
+	}
+	if(optind != argc - 1)
+	{
+		usage(argv[0]);
+		return 2;
+	}
+	if((config ? dv_format_load(&format, config) : dv_format_parse(&format, spec)) < 0)
+	{
+		usage(argv[0]);
+		return 2;
+	}
+
+	int fd = dv_open(argv[optind], baud, 0);
+	if(fd < 0)
+	{
+		return 1;
+	}
+	if(out_path)
+	{
+		output.out = fopen(out_path, "wb");
+		if(!output.out)
+		{
+			fprintf(stderr, "%s: %s\n", out_path, strerror(errno));
+			return 1;
+		}
+	}
+
+	uint8_t *buffer = malloc(READ_BUFFER_SIZE);
+	if(!buffer)
+	{
+		perror("malloc");
+		return 1;
+	}
+
+	/* Without SA_RESTART, so that a read() waiting for a serial port returns on Ctrl+C */
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = on_signal;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+	dv_parser_init(&parser, &format);
+	write_header(&output);
+
+	size_t used = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	while(!stop)
+	{
+		ssize_t n = read(fd, buffer + used, READ_BUFFER_SIZE - used);
+
+		if(n < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if(n <= 0)
+		{
+			break;
+		}
+		bytes += n;
+		used += n;
+
+		/* Keep the bytes of a frame that is not complete yet */
+		size_t consumed = dv_parse(&parser, buffer, used, write_batch, &output);
+		memmove(buffer, buffer + consumed, used - consumed);
+		used -= consumed;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	fflush(output.out);
+
+	double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+	fprintf(stderr, "%llu bytes, %llu frames, %llu resyncs, %llu bytes skipped, %llu bytes left, %.1f MB/s\n",
+	        (unsigned long long)bytes, (unsigned long long)parser.frames, (unsigned long long)parser.resyncs,
+	        (unsigned long long)parser.skipped_bytes, (unsigned long long)used,
+	        seconds > 0 ? bytes / seconds * 1e-6 : 0.0);
+
+	if(output.out != stdout)
+	{
+		fclose(output.out);
+	}
+	free(buffer);
+	close(fd);
+	return 0;
+}
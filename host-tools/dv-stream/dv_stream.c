@@ -0,0 +1,280 @@
+/*
+    \file   dv_stream.c
+
+    \brief  Decoder for the Data Visualizer stream format used by the code examples
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "dv_stream.h"
+
+static const struct
+{
+	const char *name;
+	dv_type_t type;
+} type_names[] =
+{
+	{ "u8",  DV_U8  }, { "i8",  DV_I8  },
+	{ "u16", DV_U16 }, { "i16", DV_I16 },
+	{ "u32", DV_U32 }, { "i32", DV_I32 },
+	{ "f32", DV_F32 },
+};
+
+size_t dv_type_size(dv_type_t type)
+{
+	switch(type)
+	{
+	case DV_U8:
+	case DV_I8:
+		return 1;
+	case DV_U16:
+	case DV_I16:
+		return 2;
+	default:
+		return 4;
+	}
+}
+
+static int format_add(dv_format_t *format, dv_type_t type, const char *name)
+{
+	if(format->columns >= DV_MAX_COLUMNS)
+	{
+		fprintf(stderr, "more than %d values per frame\n", DV_MAX_COLUMNS);
+		return -1;
+	}
+	format->types[format->columns] = type;
+	format->offsets[format->columns] = format->payload_size;
+	snprintf(format->names[format->columns], DV_MAX_NAME, "%s", name);
+	format->payload_size += dv_type_size(type);
+	format->columns++;
+	return 0;
+}
+
+int dv_format_parse(dv_format_t *format, const char *spec)
+{
+	char buffer[256];
+	char *save = NULL;
+
+	memset(format, 0, sizeof(*format));
+	snprintf(buffer, sizeof(buffer), "%s", spec);
+
+	for(char *token = strtok_r(buffer, ",", &save); token; token = strtok_r(NULL, ",", &save))
+	{
+		size_t i;
+		char name[DV_MAX_NAME];
+
+		for(i = 0; i < sizeof(type_names) / sizeof(type_names[0]); i++)
+		{
+			if(!strcmp(token, type_names[i].name))
+			{
+				break;
+			}
+		}
+		if(i == sizeof(type_names) / sizeof(type_names[0]))
+		{
+			fprintf(stderr, "unknown type '%s'\n", token);
+			return -1;
+		}
+		snprintf(name, sizeof(name), "value%d", format->columns);
+		if(format_add(format, type_names[i].type, name) < 0)
+		{
+			return -1;
+		}
+	}
+	return format->columns ? 0 : -1;
+}
+
+int dv_format_load(dv_format_t *format, const char *path)
+{
+	FILE *file = fopen(path, "r");
+	char line[256];
+
+	if(!file)
+	{
+		fprintf(stderr, "%s: %s\n", path, strerror(errno));
+		return -1;
+	}
+	memset(format, 0, sizeof(*format));
+
+	while(fgets(line, sizeof(line), file))
+	{
+		char *name = strrchr(line, ',');
+
+		line[strcspn(line, "\r\n")] = '\0';
+		if(line[0] == '\0' || !name)
+		{
+			continue;
+		}
+		/* Only floats are used by the code examples */
+		if(line[0] != 'F' || line[1] != ',')
+		{
+			fprintf(stderr, "%s: unsupported type in '%s'\n", path, line);
+			fclose(file);
+			return -1;
+		}
+		if(format_add(format, DV_F32, name + 1) < 0)
+		{
+			fclose(file);
+			return -1;
+		}
+	}
+	fclose(file);
+	return format->columns ? 0 : -1;
+}
+
+static speed_t baud_to_speed(long baud)
+{
+	switch(baud)
+	{
+	case 9600:    return B9600;
+	case 19200:   return B19200;
+	case 38400:   return B38400;
+	case 57600:   return B57600;
+	case 115200:  return B115200;
+	case 230400:  return B230400;
+	case 460800:  return B460800;
+	case 500000:  return B500000;
+	case 921600:  return B921600;
+	case 1000000: return B1000000;
+	default:      return B0;
+	}
+}
+
+int dv_open(const char *path, long baud, int flags)
+{
+	struct termios tty;
+	int fd = open(path, O_RDONLY | O_NOCTTY | flags);
+
+	if(fd < 0)
+	{
+		fprintf(stderr, "%s: %s\n", path, strerror(errno));
+		return -1;
+	}
+
+	/* Serial ports are configured, files are read as they are */
+	if(isatty(fd) && tcgetattr(fd, &tty) == 0)
+	{
+		speed_t speed = baud_to_speed(baud);
+
+		if(speed == B0)
+		{
+			fprintf(stderr, "unsupported baud rate %ld\n", baud);
+			close(fd);
+			return -1;
+		}
+		cfmakeraw(&tty);
+		cfsetispeed(&tty, speed);
+		cfsetospeed(&tty, speed);
+		tty.c_cflag |= CLOCAL | CREAD;
+		tty.c_cc[VMIN] = 1;
+		tty.c_cc[VTIME] = 0;
+		tcsetattr(fd, TCSANOW, &tty);
+	}
+	return fd;
+}
+
+void dv_parser_init(dv_parser_t *parser, const dv_format_t *format)
+{
+	memset(parser, 0, sizeof(*parser));
+	parser->format = format;
+}
+
+size_t dv_parse(dv_parser_t *parser, const uint8_t *data, size_t len, dv_batch_cb callback, void *context)
+{
+	const uint8_t *batch[DV_BATCH_SIZE];
+	size_t frame_size = parser->format->payload_size + 2;
+	size_t count = 0;
+	size_t pos = 0;
+	int aligned = 1;
+
+	while(pos + frame_size <= len)
+	{
+		if(data[pos] == DV_START_BYTE && data[pos + frame_size - 1] == DV_STOP_BYTE)
+		{
+			batch[count++] = &data[pos + 1];
+			pos += frame_size;
+			aligned = 1;
+			if(count == DV_BATCH_SIZE)
+			{
+				callback(context, batch, count);
+				parser->frames += count;
+				count = 0;
+			}
+			continue;
+		}
+
+		if(aligned)
+		{
+			parser->resyncs++;
+			aligned = 0;
+		}
+		/* Skip to the next start byte */
+		const uint8_t *next = memchr(&data[pos + 1], DV_START_BYTE, len - pos - 1);
+		size_t skip = next ? (size_t)(next - &data[pos]) : len - pos;
+		parser->skipped_bytes += skip;
+		pos += skip;
+	}
+
+	if(count)
+	{
+		callback(context, batch, count);
+		parser->frames += count;
+	}
+	return pos;
+}
+
+double dv_value(const dv_format_t *format, const uint8_t *p, int column)
+{
+	p += format->offsets[column];
+
+	switch(format->types[column])
+	{
+	case DV_U8:
+		return p[0];
+	case DV_I8:
+		return (int8_t)p[0];
+	case DV_U16:
+		return (uint16_t)(p[0] | (p[1] << 8));
+	case DV_I16:
+		return (int16_t)(p[0] | (p[1] << 8));
+	case DV_U32:
+		return (uint32_t)(p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24));
+	case DV_I32:
+		return (int32_t)(p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24));
+	default:
+	{
+		/* The AVR float format is IEEE 754 single precision, little endian */
+		uint32_t bits = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+		float value;
+
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+	}
+}
@@ -0,0 +1,104 @@
+/*
+    \file   dv_stream.h
+
+    \brief  Decoder for the Data Visualizer stream format used by the code examples
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+/*
+ * A frame is a start byte 0x33, a fixed-size payload of little endian values,
+ * and a stop byte ~0x33. The payload layout is described by a format, either a
+ * list of types such as "u16,u16,f32", or a Data Visualizer stream
+ * configuration file such as single_VDD_voltage.txt.
+ *
+ * dv_parse() finds the frames in a buffer and passes pointers to their
+ * payloads in batches, without copying them. A frame that is cut off at the end
+ * of the buffer is not consumed, so the caller keeps the unconsumed bytes and
+ * appends new data to them. When the stop byte of a frame is wrong, the parser
+ * skips one byte and searches for the next start byte.
+ */
+
+#ifndef DV_STREAM_H
+#define DV_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define DV_START_BYTE       0x33
+#define DV_STOP_BYTE        ((uint8_t)~DV_START_BYTE)
+#define DV_MAX_COLUMNS      32
+#define DV_MAX_NAME         32
+#define DV_BATCH_SIZE       256
+
+typedef enum
+{
+	DV_U8,
+	DV_I8,
+	DV_U16,
+	DV_I16,
+	DV_U32,
+	DV_I32,
+	DV_F32
+} dv_type_t;
+
+typedef struct
+{
+	int columns;
+	dv_type_t types[DV_MAX_COLUMNS];
+	size_t offsets[DV_MAX_COLUMNS];
+	char names[DV_MAX_COLUMNS][DV_MAX_NAME];
+	size_t payload_size;
+} dv_format_t;
+
+typedef struct
+{
+	const dv_format_t *format;
+	uint64_t frames;
+	uint64_t resyncs;           /* Times the parser lost the frame alignment */
+	uint64_t skipped_bytes;     /* Bytes that were not part of a frame */
+} dv_parser_t;
+
+/* Called with up to DV_BATCH_SIZE payloads, which point into the parsed buffer */
+typedef void (*dv_batch_cb)(void *context, const uint8_t *const *payloads, size_t count);
+
+/* Parses a list of types: u8, i8, u16, i16, u32, i32 and f32, separated by commas. Returns 0 on success. */
+int dv_format_parse(dv_format_t *format, const char *spec);
+
+/* Reads a Data Visualizer stream configuration file, one "type,...,name" line per value. Returns 0 on success. */
+int dv_format_load(dv_format_t *format, const char *path);
+
+/* Opens a serial port, configured as raw at the given baud rate, or a file. Returns the file descriptor, or -1. */
+int dv_open(const char *path, long baud, int flags);
+
+void dv_parser_init(dv_parser_t *parser, const dv_format_t *format);
+
+/* Parses the frames in data, and returns the number of bytes consumed */
+size_t dv_parse(dv_parser_t *parser, const uint8_t *data, size_t len, dv_batch_cb callback, void *context);
+
+/* Size of a value of the given type in bytes */
+size_t dv_type_size(dv_type_t type);
+
+/* Value of a column in a payload */
+double dv_value(const dv_format_t *format, const uint8_t *payload, int column);
+
+#endif /* DV_STREAM_H */
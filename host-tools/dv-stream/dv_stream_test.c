@@ -0,0 +1,283 @@
+/*
+    \file   dv_stream_test.c
+
+    \brief  Benchmark and pseudo terminal test of the Data Visualizer stream receiver
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+/*
+ * Measures the decoding rate of dv_parse() on several GB of frames, and runs
+ * dv_receive end to end on a pseudo terminal.
+ *
+ * The benchmark builds a buffer of frames with the format "u16,u16,f32", with
+ * a stray byte between some of the frames as after a lost byte on the serial
+ * line, and parses it again and again in 1 MB reads, as dv_receive does. The
+ * number of frames, resyncs and the sum of the values are checked, so the
+ * rate is only printed for a parser that decodes every frame.
+ *
+ * The end to end test writes frames to the master side of a pseudo terminal
+ * while dv_receive reads the slave side as a serial port, then sends SIGINT
+ * while dv_receive waits in read(). dv_receive must stop within a second and
+ * write every frame to its CSV output.
+ *
+ * Build:   gcc -O2 -Wall -o dv_stream_test dv_stream_test.c dv_stream.c
+ * Usage:   dv_stream_test <path to dv_receive> [GB to parse, default 4]
+ */
+
+#define _DEFAULT_SOURCE
+#define _XOPEN_SOURCE 600
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "dv_stream.h"
+
+#define FORMAT              "u16,u16,f32"
+#define BUFFER_FRAMES       1000000
+#define STRAY_INTERVAL      1000        /* Frames between stray bytes */
+#define READ_SIZE           (1 << 20)   /* As READ_BUFFER_SIZE in dv_receive.c */
+#define PTY_FRAMES          5000
+#define STOP_TIMEOUT_MS     1000
+
+typedef struct
+{
+	uint64_t frames;
+	uint64_t sum;
+} totals_t;
+
+static int failures;
+
+static void check(int condition, const char *name)
+{
+	printf("%-50s %s\n", name, condition ? "ok" : "FAILED");
+	if(!condition)
+	{
+		failures++;
+	}
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Frame n holds n & 0xFFFF, 0x3333 and n as a float, so payloads also contain the start and stop bytes */
+static size_t write_frame(uint8_t *frame, uint32_t n)
+{
+	float value = (float)n;
+
+	frame[0] = DV_START_BYTE;
+	frame[1] = n & 0xFF;
+	frame[2] = (n >> 8) & 0xFF;
+	frame[3] = 0x33;
+	frame[4] = 0x33;
+	memcpy(&frame[5], &value, sizeof(value));
+	frame[9] = DV_STOP_BYTE;
+	return 10;
+}
+
+static void sum_batch(void *context, const uint8_t *const *payloads, size_t count)
+{
+	totals_t *totals = context;
+
+	for(size_t i = 0; i < count; i++)
+	{
+		totals->sum += payloads[i][0] | (payloads[i][1] << 8);
+	}
+	totals->frames += count;
+}
+
+static void benchmark(double gigabytes)
+{
+	dv_format_t format;
+	dv_parser_t parser;
+	totals_t totals = { 0, 0 };
+	uint8_t *buffer = malloc(BUFFER_FRAMES * 11);
+	size_t len = 0;
+	uint64_t sum = 0;
+
+	if(!buffer || dv_format_parse(&format, FORMAT) < 0)
+	{
+		check(0, "benchmark setup");
+		return;
+	}
+	for(uint32_t n = 0; n < BUFFER_FRAMES; n++)
+	{
+		if(n % STRAY_INTERVAL == STRAY_INTERVAL - 1)
+		{
+			buffer[len++] = 0x00;
+		}
+		len += write_frame(buffer + len, n);
+		sum += n & 0xFFFF;
+	}
+
+	uint64_t passes = (uint64_t)(gigabytes * 1e9 / len + 0.5);
+	if(passes == 0)
+	{
+		passes = 1;
+	}
+
+	dv_parser_init(&parser, &format);
+	double start = now();
+	for(uint64_t pass = 0; pass < passes; pass++)
+	{
+		size_t pos = 0;
+
+		while(pos < len)
+		{
+			size_t chunk = (len - pos < READ_SIZE) ? len - pos : READ_SIZE;
+			size_t consumed = dv_parse(&parser, buffer + pos, chunk, sum_batch, &totals);
+
+			if(consumed == 0)
+			{
+				break;
+			}
+			pos += consumed;
+		}
+	}
+	double seconds = now() - start;
+
+	printf("Parsed %.2f GB in %.2f s, %.0f MB/s, %.1f Mframes/s\n", (double)passes * len * 1e-9, seconds,
+	       passes * len / seconds * 1e-6, totals.frames / seconds * 1e-6);
+	check(totals.frames == passes * BUFFER_FRAMES, "every frame decoded");
+	check(totals.sum == passes * sum, "values decoded");
+	check(parser.skipped_bytes == passes * (BUFFER_FRAMES / STRAY_INTERVAL), "stray bytes skipped");
+	free(buffer);
+}
+
+static void end_to_end(const char *tool_path)
+{
+	char out_path[] = "/tmp/dv_stream_test_XXXXXX";
+	struct termios tty;
+	int out_fd = mkstemp(out_path);
+	int master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+
+	if(out_fd < 0 || master_fd < 0 || grantpt(master_fd) < 0 || unlockpt(master_fd) < 0)
+	{
+		perror("end to end setup");
+		failures++;
+		return;
+	}
+	close(out_fd);
+
+	/* Raw before dv_receive opens it, so that no byte is changed by the line discipline */
+	const char *slave_path = ptsname(master_fd);
+	int slave_fd = open(slave_path, O_RDWR | O_NOCTTY);
+	if(slave_fd < 0 || tcgetattr(slave_fd, &tty) < 0)
+	{
+		perror(slave_path);
+		failures++;
+		return;
+	}
+	cfmakeraw(&tty);
+	tcsetattr(slave_fd, TCSANOW, &tty);
+
+	pid_t pid = fork();
+	if(pid == 0)
+	{
+		execl(tool_path, tool_path, "-B", "115200", "-f", FORMAT, "-o", out_path, slave_path, (char *)NULL);
+		perror(tool_path);
+		_exit(127);
+	}
+
+	uint8_t frame[10];
+	for(uint32_t n = 0; n < PTY_FRAMES; n++)
+	{
+		size_t size = write_frame(frame, n);
+
+		if(write(master_fd, frame, size) != (ssize_t)size)
+		{
+			perror("write");
+			break;
+		}
+	}
+
+	/* Let dv_receive read everything and wait in read() again */
+	usleep(300000);
+	kill(pid, SIGINT);
+
+	int status = 0;
+	int stopped = 0;
+	for(int ms = 0; ms < STOP_TIMEOUT_MS && !stopped; ms += 10)
+	{
+		usleep(10000);
+		stopped = waitpid(pid, &status, WNOHANG) == pid;
+	}
+	if(!stopped)
+	{
+		kill(pid, SIGKILL);
+		waitpid(pid, &status, 0);
+	}
+	check(stopped && WIFEXITED(status) && WEXITSTATUS(status) == 0, "dv_receive stops on SIGINT in read()");
+
+	FILE *out = fopen(out_path, "r");
+	char line[128];
+	uint32_t rows = 0;
+	int values_ok = out && fgets(line, sizeof(line), out) != NULL;
+	while(out && fgets(line, sizeof(line), out))
+	{
+		unsigned a, b;
+		float c;
+
+		if(sscanf(line, "%u,%u,%f", &a, &b, &c) != 3 || a != (rows & 0xFFFF) || b != 0x3333 || c != (float)rows)
+		{
+			values_ok = 0;
+		}
+		rows++;
+	}
+	check(rows == PTY_FRAMES, "every frame written to the CSV");
+	check(values_ok, "CSV values");
+
+	if(out)
+	{
+		fclose(out);
+	}
+	unlink(out_path);
+	close(slave_fd);
+	close(master_fd);
+}
+
+int main(int argc, char *argv[])
+{
+	if(argc < 2 || argc > 3)
+	{
+		fprintf(stderr, "usage: %s <path to dv_receive> [GB to parse]\n", argv[0]);
+		return 2;
+	}
+
+	benchmark(argc > 2 ? atof(argv[2]) : 4.0);
+	end_to_end(argv[1]);
+
+	printf("%s\n", failures ? "FAILED" : "PASSED");
+	return failures ? 1 : 0;
+}
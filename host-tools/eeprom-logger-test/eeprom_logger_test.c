@@ -0,0 +1,282 @@
+/*
+    \file   eeprom_logger_test.c
+
+    \brief  Host test of the single-eeprom-logger example with simulated power cuts
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+/*
+ * Compiles the main.c of the single-eeprom-logger example with the register
+ * model in host-tools/avr-sim, and cuts the power while records are written.
+ *
+ * The EEPROM is modelled as non-volatile cells behind the array the example
+ * writes to. The bytes log_append() loads into the page buffer are only
+ * programmed into the cells by the page erase/write command. A power cut stops
+ * the command at a random point: during the erase, a bit of a byte may already
+ * be erased or not, and during the write, a bit may already be programmed or
+ * not, independently for every bit. After the cut, the array is loaded from
+ * the cells, the variables of the example are cleared as by a reset, and
+ * log_recover() must find every record that was completely written before the
+ * cut, in order. A torn record may only be recovered as the newest record, or
+ * as the oldest when its old sequence number survived the cut, and the share of
+ * torn records that pass the 4-bit check is printed: about 1 in 16.
+ *
+ * The append rate of log_append() and the time of log_recover() on the host
+ * are printed, together with the rate and lifetime of the log on the device,
+ * from the EEPROM erase/write time and endurance below.
+ *
+ * Build:   gcc -O2 -Wall -I../avr-sim -o eeprom_logger_test eeprom_logger_test.c
+ * Usage:   eeprom_logger_test [power cuts, default 100000]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define main firmware_main
+#include "../../attiny1627-how-to-use-the-12-bit-differential-adc-with-pga/single-eeprom-logger/main.c"
+#undef main
+
+#define EEPROM_ERASE_WRITE_MS   4.0     /* Page erase/write time, an estimate to be checked in the data sheet */
+#define EEPROM_ENDURANCE        100000  /* Erase/write cycles per cell, an estimate to be checked in the data sheet */
+#define MAX_APPENDS_PER_CUT     150     /* Records appended between two power cuts, more than one round of the ring */
+#define THROUGHPUT_APPENDS      10000000
+
+/* Contents of the EEPROM cells, which the array of the register model only mirrors */
+static uint8_t cells[EEPROM_SIZE];
+
+/* Records that must be in the log, oldest first */
+static log_record_t expected[LOG_RECORDS];
+static int expected_count;
+
+static int failures;
+
+static void check(int condition, const char *name)
+{
+	printf("%-60s %s\n", name, condition ? "ok" : "FAILED");
+	if(!condition)
+	{
+		failures++;
+	}
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double random_unit(void)
+{
+	return rand() / (RAND_MAX + 1.0);
+}
+
+/* A reset: the array shows the cells, and the variables of the example are cleared */
+static void reset(void)
+{
+	memcpy(avr_sim_eeprom, cells, EEPROM_SIZE);
+	NVMCTRL.CTRLA = NVMCTRL_CMD_NONE_gc;
+	log_newest = 0;
+	log_count = 0;
+	log_sequence = 0;
+	log_torn_records = 0;
+	log_recover();
+}
+
+/*
+ * Appends a record, and runs the page erase/write up to the given progress:
+ * 0 to 1 is the erase, 1 to 2 the write, 2 or more completes the command.
+ */
+static void append(uint8_t interval, uint16_t sample, double progress)
+{
+	log_append(interval, sample);
+	if(NVMCTRL.CTRLA != NVMCTRL_CMD_PAGEERASEWRITE_gc)
+	{
+		check(0, "log_append() starts a page erase/write");
+		exit(1);
+	}
+	NVMCTRL.CTRLA = NVMCTRL_CMD_NONE_gc;
+
+	/* The loaded bytes are the four bytes of the newest slot */
+	for(int i = log_newest * LOG_RECORD_SIZE; i < (log_newest + 1) * LOG_RECORD_SIZE; i++)
+	{
+		uint8_t target = avr_sim_eeprom[i];
+
+		if(progress >= 2)
+		{
+			cells[i] = target;
+			continue;
+		}
+		for(uint8_t bit = 1; bit; bit <<= 1)
+		{
+			if(progress < 1 && !(cells[i] & bit) && random_unit() < progress)
+			{
+				cells[i] |= bit;        /* Erased */
+			}
+			else if(progress >= 1 && (cells[i] |= bit, !(target & bit)) && random_unit() < progress - 1)
+			{
+				cells[i] &= ~bit;       /* Programmed */
+			}
+		}
+	}
+}
+
+static void expect(const log_record_t *record)
+{
+	if(expected_count == LOG_RECORDS)
+	{
+		memmove(&expected[0], &expected[1], (LOG_RECORDS - 1) * sizeof(log_record_t));
+		expected_count--;
+	}
+	expected[expected_count++] = *record;
+}
+
+/* Compares the recovered log with the expected records, returns 1 if it has one more, torn, record at either end */
+static int compare_recovered(int *lost)
+{
+	uint8_t slot = (log_newest + LOG_RECORDS + 1 - log_count) % LOG_RECORDS;
+	log_record_t recovered[LOG_RECORDS];
+
+	for(int i = 0; i < log_count; i++)
+	{
+		memcpy(&recovered[i], &cells[slot * LOG_RECORD_SIZE], LOG_RECORD_SIZE);
+		slot = (slot + 1) % LOG_RECORDS;
+	}
+
+	/* The recovered log is the log from now on */
+	int extra = log_count - expected_count;
+	size_t size = expected_count * sizeof(log_record_t);
+	*lost = !((extra == 0 && memcmp(recovered, expected, size) == 0) ||
+	          (extra == 1 && (memcmp(recovered, expected, size) == 0 || memcmp(&recovered[1], expected, size) == 0)));
+	memcpy(expected, recovered, log_count * sizeof(log_record_t));
+	expected_count = log_count;
+	return !*lost && extra == 1;
+}
+
+static void power_cuts(long cuts)
+{
+	long torn = 0;
+	long passed = 0;
+	long accepted = 0;
+	long lost = 0;
+	long appends = 0;
+
+	memset(cells, LOG_ERASED, sizeof(cells));
+	reset();
+	expected_count = 0;
+
+	for(long cut = 0; cut < cuts; cut++)
+	{
+		int count = rand() % MAX_APPENDS_PER_CUT;
+
+		for(int i = 0; i < count; i++)
+		{
+			log_record_t record;
+
+			append(rand() % LOG_INTERVAL_RESET, rand() & 0x0FFF, 2);
+			memcpy(&record, &cells[log_newest * LOG_RECORD_SIZE], LOG_RECORD_SIZE);
+			expect(&record);
+			appends++;
+		}
+
+		/* The cut, while the next record is written, into the slot of the oldest record when the ring is full */
+		uint8_t slot = (log_newest + 1) % LOG_RECORDS;
+		uint8_t old[LOG_RECORD_SIZE];
+		log_record_t record;
+
+		memcpy(old, &cells[slot * LOG_RECORD_SIZE], LOG_RECORD_SIZE);
+		append(rand() % LOG_INTERVAL_RESET, rand() & 0x0FFF, 2 * random_unit());
+		memcpy(&record, &avr_sim_eeprom[slot * LOG_RECORD_SIZE], LOG_RECORD_SIZE);
+		appends++;
+
+		if(memcmp(&cells[slot * LOG_RECORD_SIZE], &record, LOG_RECORD_SIZE) == 0)
+		{
+			expect(&record);
+		}
+		else if(memcmp(&cells[slot * LOG_RECORD_SIZE], old, LOG_RECORD_SIZE) != 0)
+		{
+			torn++;
+			passed += log_valid((const log_record_t *)&cells[slot * LOG_RECORD_SIZE]);
+			if(expected_count == LOG_RECORDS)
+			{
+				memmove(&expected[0], &expected[1], (LOG_RECORDS - 1) * sizeof(log_record_t));
+				expected_count--;
+			}
+		}
+
+		reset();
+		int lost_records;
+		accepted += compare_recovered(&lost_records);
+		lost += lost_records;
+	}
+
+	printf("%ld power cuts, %ld appends, %ld torn records, %ld passed the check (1 in %.1f), %ld recovered\n",
+	       cuts, appends, torn, passed, passed ? (double)torn / passed : 0.0, accepted);
+	check(lost == 0, "every complete record recovered after every cut");
+	check(passed > 0 && (double)torn / passed > 10 && (double)torn / passed < 25,
+	      "about 1 in 16 torn records passes the check");
+	check(accepted <= passed, "only torn records that pass the check are recovered");
+}
+
+static void throughput(void)
+{
+	memset(cells, LOG_ERASED, sizeof(cells));
+	reset();
+
+	double start = now();
+	for(long i = 0; i < THROUGHPUT_APPENDS; i++)
+	{
+		log_append(i & 0x7F, i & 0x0FFF);
+	}
+	double append_time = now() - start;
+
+	start = now();
+	for(int i = 0; i < 1000; i++)
+	{
+		log_recover();
+	}
+	double recover_time = (now() - start) / 1000;
+
+	printf("Host: %.1f M appends/s, log_recover() %.1f us\n", THROUGHPUT_APPENDS / append_time * 1e-6,
+	       recover_time * 1e6);
+	printf("Device: at most %.0f appends/s with a %.1f ms page erase/write, %.1f M records before a cell wears out\n",
+	       1000 / EEPROM_ERASE_WRITE_MS, EEPROM_ERASE_WRITE_MS, (double)EEPROM_ENDURANCE * LOG_RECORDS * 1e-6);
+	printf("        at one record every %d s, the shortest interval of the example, %.0f years\n", LOG_PERIOD,
+	       (double)EEPROM_ENDURANCE * LOG_RECORDS * LOG_PERIOD / (365.25 * 24 * 3600));
+	check(log_count == LOG_RECORDS && log_valid(log_slot(log_newest)), "log full and valid after the appends");
+}
+
+int main(int argc, char *argv[])
+{
+	long cuts = (argc > 1) ? atol(argv[1]) : 100000;
+
+	srand(1);
+	power_cuts(cuts);
+	throughput();
+
+	printf("%s\n", failures ? "FAILED" : "PASSED");
+	return failures ? 1 : 0;
+}
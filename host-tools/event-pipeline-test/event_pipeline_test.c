@@ -0,0 +1,280 @@
+/*
+    \file   event_pipeline_test.c
+
+    \brief  Host test of the event routing of the single-event-pipeline example
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+/*
+ * Compiles the main.c of the single-event-pipeline example with the register
+ * model in host-tools/avr-sim and checks the event system configuration that
+ * event_pipeline_build() writes:
+ *
+ * - every channel has the generator of its table entry, and every user listens
+ *   to the channel of its entry
+ * - tables with an invalid channel, a channel used twice or a user used twice
+ *   are rejected, and leave the event system untouched
+ *
+ * Then the pipeline is run for a number of sampling periods with a sine wave
+ * on the input. The events travel from generator to channel to user as the
+ * EVSYS registers route them, so a wrong assignment shows up as missing
+ * conversions, pulses or captures. The timing uses the register values written
+ * by the example: the TCA0 period, and the conversion time from the ADC
+ * prescaler and SAMPDUR.
+ *
+ * Build:   gcc -O2 -Wall -I../avr-sim -o event_pipeline_test event_pipeline_test.c -lm
+ * Usage:   event_pipeline_test [periods]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define main firmware_main
+#include "../../attiny1627-how-to-use-the-12-bit-differential-adc-with-pga/single-event-pipeline/main.c"
+#undef main
+
+#define ADC_CONVERSION_CLKS 13      /* CLK_ADC cycles of a 12-bit conversion after sampling */
+#define SINE_PERIODS        7.3     /* Periods of the input signal during the test */
+
+static int failures;
+
+static void check(int condition, const char *name)
+{
+	printf("%-60s %s\n", name, condition ? "ok" : "FAILED");
+	if(!condition)
+	{
+		failures++;
+	}
+}
+
+/* Users of each channel, as routed by the EVSYS user registers */
+static int user_channel(register8_t *user)
+{
+	return (*user == EVSYS_USER_OFF_gc) ? -1 : *user - EVSYS_USER_CHANNEL0_gc;
+}
+
+/* Channel that carries the generator, or -1 */
+static int generator_channel(uint8_t generator)
+{
+	for(int c = 0; c < EVSYS_CHANNELS; c++)
+	{
+		if((&EVSYS.CHANNEL0)[c] == generator)
+		{
+			return c;
+		}
+	}
+	return -1;
+}
+
+static int routed(uint8_t generator, register8_t *user)
+{
+	int channel = generator_channel(generator);
+
+	return channel >= 0 && user_channel(user) == channel;
+}
+
+static void check_assignments(void)
+{
+	for(size_t i = 0; i < sizeof(event_pipeline) / sizeof(event_pipeline[0]); i++)
+	{
+		const event_route_t *route = &event_pipeline[i];
+		char name[80];
+
+		snprintf(name, sizeof(name), "channel %u has the generator of entry %zu", route->channel, i);
+		check((&EVSYS.CHANNEL0)[route->channel] == route->generator, name);
+		for(register8_t * const *user = route->users; *user != NULL; user++)
+		{
+			snprintf(name, sizeof(name), "user %zu of entry %zu listens to channel %u", (size_t)(user - route->users), i, route->channel);
+			check(user_channel(*user) == route->channel, name);
+		}
+	}
+	check(routed(EVSYS_CHANNEL0_TCA0_OVF_LUNF_gc, &EVSYS.USERADC0START), "TCA0 overflow starts the ADC");
+	check(routed(EVSYS_CHANNEL0_ADC0_WCMP_gc, &EVSYS.USERCCLLUT0A), "window compare drives LUT0 input A");
+	check(routed(EVSYS_CHANNEL0_ADC0_WCMP_gc, &EVSYS.USERTCB0CAPT), "window compare captures TCB0");
+	check(routed(EVSYS_CHANNEL0_ADC0_RES_gc, &EVSYS.USEREVSYSEVOUTB), "result ready is output on EVOUTB");
+	check(routed(EVSYS_CHANNEL0_ADC0_RES_gc, &EVSYS.USERTCB1COUNT), "result ready is counted by TCB1");
+}
+
+static void check_rejected(void)
+{
+	static const event_route_t bad_channel[] =
+	{
+		{ EVSYS_CHANNELS, EVSYS_CHANNEL0_RTC_OVF_gc, { &EVSYS.USERADC0START, NULL } },
+	};
+	static const event_route_t channel_twice[] =
+	{
+		{ 0, EVSYS_CHANNEL0_RTC_OVF_gc, { &EVSYS.USERADC0START, NULL } },
+		{ 0, EVSYS_CHANNEL0_ADC0_RES_gc, { &EVSYS.USEREVSYSEVOUTB, NULL } },
+	};
+	static const event_route_t user_twice[] =
+	{
+		{ 0, EVSYS_CHANNEL0_RTC_OVF_gc, { &EVSYS.USERADC0START, NULL } },
+		{ 1, EVSYS_CHANNEL1_ADC0_RES_gc, { &EVSYS.USEREVSYSEVOUTB, &EVSYS.USERADC0START, NULL } },
+	};
+	static const event_route_t user_twice_in_entry[] =
+	{
+		{ 0, EVSYS_CHANNEL0_RTC_OVF_gc, { &EVSYS.USERADC0START, &EVSYS.USERADC0START, NULL } },
+	};
+	EVSYS_t before;
+
+	memset((void *)&EVSYS, 0, sizeof(EVSYS));
+	before = EVSYS;
+	check(event_pipeline_build(bad_channel, 1) == PIPELINE_INVALID_CHANNEL, "channel 6 is rejected");
+	check(event_pipeline_build(channel_twice, 2) == PIPELINE_CHANNEL_IN_USE, "a channel used twice is rejected");
+	check(event_pipeline_build(user_twice, 2) == PIPELINE_USER_IN_USE, "a user on two channels is rejected");
+	check(event_pipeline_build(user_twice_in_entry, 1) == PIPELINE_USER_IN_USE, "a user listed twice is rejected");
+	check(!memcmp((const void *)&before, (const void *)&EVSYS, sizeof(EVSYS)), "rejected tables leave EVSYS untouched");
+}
+
+/* LUT0 output for input A, with inputs 1 and 2 masked */
+static int lut0_output(int input_a)
+{
+	return (CCL.CTRLA & CCL_ENABLE_bm) && (CCL.LUT0CTRLA & CCL_ENABLE_bm) && ((CCL.TRUTH0 >> input_a) & 1);
+}
+
+static int window_match(uint16_t result)
+{
+	switch(ADC0.CTRLD & ADC_WINCM_gm)
+	{
+	case ADC_WINCM_BELOW_gc:   return result < ADC0.WINLT;
+	case ADC_WINCM_ABOVE_gc:   return result > ADC0.WINHT;
+	case ADC_WINCM_INSIDE_gc:  return result >= ADC0.WINLT && result <= ADC0.WINHT;
+	case ADC_WINCM_OUTSIDE_gc: return result < ADC0.WINLT || result > ADC0.WINHT;
+	default:                   return 0;
+	}
+}
+
+/* Sends an event from a generator to all users listening to its channel */
+static void event(uint8_t generator, uint32_t cycle, unsigned long *lut0_pulses, unsigned long *evoutb_pulses, int *start)
+{
+	int channel = generator_channel(generator);
+
+	if(channel < 0)
+	{
+		return;
+	}
+	if(user_channel(&EVSYS.USERADC0START) == channel)
+	{
+		*start = 1;
+	}
+	if(user_channel(&EVSYS.USERCCLLUT0A) == channel && lut0_output(1) && !lut0_output(0))
+	{
+		/* The event is a pulse, so the LUT output is a pulse of the same length */
+		(*lut0_pulses)++;
+	}
+	if(user_channel(&EVSYS.USERTCB0CAPT) == channel && (TCB0.EVCTRL & TCB_CAPTEI_bm) && (TCB0.CTRLA & TCB_ENABLE_bm))
+	{
+		TCB0.CCMP = (uint16_t)cycle; /* TCB0 counts the same clock as TCA0 */
+	}
+	if(user_channel(&EVSYS.USEREVSYSEVOUTB) == channel)
+	{
+		(*evoutb_pulses)++;
+	}
+	if(user_channel(&EVSYS.USERTCB1COUNT) == channel && (TCB1.CTRLA & TCB_ENABLE_bm))
+	{
+		TCB1.CNT++;
+	}
+}
+
+static void run_pipeline(unsigned long periods)
+{
+	static const uint8_t presc_div[] = { 2, 4, 6, 8, 10, 12, 14, 16, 20, 24, 28, 32, 40, 48, 56, 64 };
+	uint32_t period = TCA0.SINGLE.PER + 1;
+	uint32_t conversion = presc_div[ADC0.CTRLB & 0x0F] * (ADC0.CTRLE + 1 + ADC_CONVERSION_CLKS);
+	unsigned long lut0_pulses = 0, evoutb_pulses = 0, expected_matches = 0, trigger_overruns = 0;
+	uint32_t last_match_cycle = 0;
+	int converting = 0;
+	uint32_t done_cycle = 0;
+
+	printf("TCA0 period %lu CLK_PER cycles (%.1f us), conversion %lu cycles (%.1f us)\n",
+	       (unsigned long)period, period * 1e6 / F_CPU, (unsigned long)conversion, conversion * 1e6 / F_CPU);
+
+	for(unsigned long p = 0; p < periods; p++)
+	{
+		uint32_t overflow_cycle = (uint32_t)(p + 1) * period;
+		int start = 0;
+
+		/* A conversion that ends before the next trigger sends its events first */
+		if(converting && done_cycle <= overflow_cycle)
+		{
+			converting = 0;
+		}
+
+		event(EVSYS_CHANNEL0_TCA0_OVF_LUNF_gc, overflow_cycle, &lut0_pulses, &evoutb_pulses, &start);
+		if(!start || !(ADC0.CTRLA & ADC_ENABLE_bm) || (ADC0.COMMAND & ADC_START_gm) != ADC_START_EVENT_TRIGGER_gc)
+		{
+			continue;
+		}
+		if(converting)
+		{
+			trigger_overruns++;
+			continue;
+		}
+
+		double phase = 2 * M_PI * SINE_PERIODS * p / periods;
+		uint16_t result = (uint16_t)lround(2047.5 + 2047.5 * sin(phase));
+
+		converting = 1;
+		done_cycle = overflow_cycle + conversion;
+		ADC0.RESULT = result;
+		if(window_match(result))
+		{
+			expected_matches++;
+			last_match_cycle = done_cycle;
+			event(EVSYS_CHANNEL0_ADC0_WCMP_gc, done_cycle, &lut0_pulses, &evoutb_pulses, &start);
+		}
+		event(EVSYS_CHANNEL0_ADC0_RES_gc, done_cycle, &lut0_pulses, &evoutb_pulses, &start);
+	}
+
+	printf("%lu conversions, %lu window matches, %lu LUT0 pulses, %lu EVOUTB pulses\n",
+	       (unsigned long)TCB1.CNT, expected_matches, lut0_pulses, evoutb_pulses);
+
+	check(conversion < period, "a conversion ends before the next trigger");
+	check(trigger_overruns == 0, "no trigger arrives during a conversion");
+	check(TCB1.CNT == (uint16_t)periods, "TCB1 counts one result per period");
+	check(evoutb_pulses == periods, "EVOUTB pulses once per result");
+	check(expected_matches > 0 && expected_matches < periods, "the sine wave leaves and enters the window");
+	check(lut0_pulses == expected_matches, "LUT0 pulses once per window match");
+	check(TCB0.CCMP == (uint16_t)last_match_cycle, "TCB0 holds the time of the last window match");
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned long periods = (argc > 1) ? strtoul(argv[1], NULL, 0) : 10000;
+
+	check_rejected();
+
+	adc_init();
+	ccl_init();
+	tcb_init();
+	check(event_pipeline_build(event_pipeline, sizeof(event_pipeline) / sizeof(event_pipeline[0])) == PIPELINE_OK,
+	      "the pipeline table is accepted");
+	tca_init();
+
+	check_assignments();
+	run_pipeline(periods);
+
+	printf("%s\n", failures ? "FAILED" : "PASSED");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,124 @@
+/*
+    \file   analysis_firmware.h
+
+    \brief  Includes the single-frequency-analysis example once per ANALYSIS_FFT setting
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+/*
+ * Included by frequency_analysis_test.c once for each ANALYSIS_FFT setting,
+ * with FIRMWARE defined to a prefix, e.g.
+ *
+ *     #define ANALYSIS_FFT    0
+ *     #define FIRMWARE        goertzel
+ *     #include "analysis_firmware.h"
+ *
+ * Every name the example defines gets the prefix, so both builds of main.c are
+ * in one program. The registers of avr-sim are shared. The functions, buffers
+ * and sizes the test uses are collected in FIRMWARE_variant.
+ */
+
+#define FIRMWARE_NAME(name)             FIRMWARE_PASTE(FIRMWARE, name)
+#define FIRMWARE_PASTE(prefix, name)    FIRMWARE_PASTE_(prefix, name)
+#define FIRMWARE_PASTE_(prefix, name)   prefix##_##name
+
+#define main                FIRMWARE_NAME(main)
+#define goertzel_freqs      FIRMWARE_NAME(goertzel_freqs)
+#define sample_buffers      FIRMWARE_NAME(sample_buffers)
+#define ready_buffer        FIRMWARE_NAME(ready_buffer)
+#define fft_imag            FIRMWARE_NAME(fft_imag)
+#define twiddle_cos         FIRMWARE_NAME(twiddle_cos)
+#define twiddle_sin         FIRMWARE_NAME(twiddle_sin)
+#define goertzel_coeff      FIRMWARE_NAME(goertzel_coeff)
+#define goertzel_sin        FIRMWARE_NAME(goertzel_sin)
+#define dc_level            FIRMWARE_NAME(dc_level)
+#define amplitudes          FIRMWARE_NAME(amplitudes)
+#define analysis_cycles     FIRMWARE_NAME(analysis_cycles)
+#define block_overruns      FIRMWARE_NAME(block_overruns)
+#define event_system_init   FIRMWARE_NAME(event_system_init)
+#define rtc_init            FIRMWARE_NAME(rtc_init)
+#define tca_init            FIRMWARE_NAME(tca_init)
+#define adc_init            FIRMWARE_NAME(adc_init)
+#define usart_init          FIRMWARE_NAME(usart_init)
+#define usart_send_byte     FIRMWARE_NAME(usart_send_byte)
+#define usart_send_spectrum FIRMWARE_NAME(usart_send_spectrum)
+#define isqrt64             FIRMWARE_NAME(isqrt64)
+#define analysis_init       FIRMWARE_NAME(analysis_init)
+#define remove_dc           FIRMWARE_NAME(remove_dc)
+#define fft_radix2          FIRMWARE_NAME(fft_radix2)
+#define mul_q14             FIRMWARE_NAME(mul_q14)
+#define analyze_block       FIRMWARE_NAME(analyze_block)
+#define ADC0_RESRDY_vect    FIRMWARE_NAME(ADC0_RESRDY_vect)
+
+#include "../../attiny1627-how-to-use-the-12-bit-differential-adc-with-pga/single-frequency-analysis/main.c"
+
+static const firmware_t FIRMWARE_NAME(variant) =
+{
+	ANALYSIS_FFT,
+	BLOCK_SIZE,
+	ANALYSIS_BINS,
+	CYCLES_PER_BLOCK_BUDGET,
+#if ANALYSIS_FFT
+	NULL,
+#else
+	goertzel_freqs,
+#endif
+	sample_buffers[0],
+	amplitudes,
+	analysis_init,
+	remove_dc,
+	analyze_block
+};
+
+#undef main
+#undef goertzel_freqs
+#undef sample_buffers
+#undef ready_buffer
+#undef fft_imag
+#undef twiddle_cos
+#undef twiddle_sin
+#undef goertzel_coeff
+#undef goertzel_sin
+#undef dc_level
+#undef amplitudes
+#undef analysis_cycles
+#undef block_overruns
+#undef event_system_init
+#undef rtc_init
+#undef tca_init
+#undef adc_init
+#undef usart_init
+#undef usart_send_byte
+#undef usart_send_spectrum
+#undef isqrt64
+#undef analysis_init
+#undef remove_dc
+#undef fft_radix2
+#undef mul_q14
+#undef analyze_block
+#undef ADC0_RESRDY_vect
+#undef ANALYSIS_FFT
+#undef BLOCK_SIZE
+#undef BLOCK_BITS
+#undef ANALYSIS_BINS
+#undef FIRMWARE
@@ -0,0 +1,250 @@
+/*
+    \file   frequency_analysis_test.c
+
+    \brief  Host test of the single-frequency-analysis example
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+/*
+ * Compiles the main.c of the single-frequency-analysis example with the
+ * register model in host-tools/avr-sim, with ANALYSIS_FFT set to 0 and to 1
+ * (see analysis_firmware.h), and runs remove_dc() and analyze_block() on
+ * blocks of known test tones on a DC level of 2048 codes.
+ *
+ * The DC level must equal the mean of the block within 1 code, and the
+ * amplitude of the bin of each tone must be within AMPLITUDE_TOLERANCE. With the FFT, the tones are at the
+ * centers of bins, and the other bins must stay below LEAKAGE_MAX.
+ *
+ * The analysis of each block is single-stepped with the x86 trap flag, as in
+ * watchdog-supervised-bench, and the instructions are counted. The test is
+ * built without vectorization, so every sample takes its own instructions, as
+ * on the AVR. An x86-64 instruction does 16- and 32-bit arithmetic at once,
+ * where the 8-bit AVR takes one cycle per byte, and two for loads and
+ * multiplications. So the count is multiplied by AVR_CYCLES_PER_INSTRUCTION
+ * before it is compared to CYCLES_PER_BLOCK_BUDGET. This is an estimate, not a
+ * cycle count: the cycles on the device are measured by the example in
+ * analysis_cycles.
+ *
+ * Build:   gcc -O2 -fno-tree-vectorize -Wall -I../avr-sim -o frequency_analysis_test frequency_analysis_test.c -lm
+ * Usage:   frequency_analysis_test
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <math.h>
+
+#if !defined(__x86_64__) || !defined(__linux__)
+#error "The test single-steps with the x86-64 trap flag on Linux"
+#endif
+#include <ucontext.h>
+
+typedef struct
+{
+	int fft;
+	unsigned block_size;
+	unsigned bins;
+	uint32_t budget;            /* CYCLES_PER_BLOCK_BUDGET */
+	const uint16_t *freqs;      /* Goertzel frequencies, NULL for the FFT */
+	int16_t *samples;
+	volatile uint16_t *amplitudes;
+	void (*analysis_init)(void);
+	uint16_t (*remove_dc)(int16_t *samples);
+	void (*analyze_block)(int16_t *samples);
+} firmware_t;
+
+#define ANALYSIS_FFT    0
+#define FIRMWARE        goertzel
+#include "analysis_firmware.h"
+
+#define ANALYSIS_FFT    1
+#define FIRMWARE        fft
+#include "analysis_firmware.h"
+
+#define TRAP_FLAG                   0x100
+#define DC_LEVEL                    2048        /* ADC codes */
+#define AMPLITUDE_TOLERANCE(a)      ((a) / 100.0 + 2)   /* ADC codes */
+#define LEAKAGE_MAX                 2           /* ADC codes */
+#define AVR_CYCLES_PER_INSTRUCTION  3
+
+typedef struct
+{
+	double freq;        /* Hz */
+	double amplitude;   /* ADC codes */
+} tone_t;
+
+static volatile int stepping;
+static unsigned long instructions;
+static int failures;
+
+static void check(int condition, const char *name)
+{
+	printf("  %-60s %s\n", name, condition ? "ok" : "FAILED");
+	if(!condition)
+	{
+		failures++;
+	}
+}
+
+/* Called after every instruction */
+static void trap_handler(int signal, siginfo_t *info, void *context)
+{
+	ucontext_t *uc = context;
+
+	(void) signal;
+	(void) info;
+	if(!stepping)
+	{
+		uc->uc_mcontext.gregs[REG_EFL] &= ~TRAP_FLAG;
+		return;
+	}
+	instructions++;
+}
+
+/* Fills the block with the tones, analyzes it and returns the instructions it took */
+static unsigned long analyze(const firmware_t *firmware, const tone_t *tones, unsigned count, uint16_t *dc, double *mean)
+{
+	*mean = 0;
+	for(unsigned n = 0; n < firmware->block_size; n++)
+	{
+		double value = DC_LEVEL;
+
+		for(unsigned i = 0; i < count; i++)
+		{
+			value += tones[i].amplitude * sin(2 * M_PI * tones[i].freq * n / ADC_SAMPLING_FREQ + 0.3 * (i + 1));
+		}
+		firmware->samples[n] = (int16_t) lround(value);
+		*mean += (double) firmware->samples[n] / firmware->block_size;
+	}
+
+	instructions = 0;
+	stepping = 1;
+	__asm__ volatile("pushf\n\torl %0, (%%rsp)\n\tpopf" : : "i" (TRAP_FLAG) : "memory", "cc");
+	*dc = firmware->remove_dc(firmware->samples);
+	firmware->analyze_block(firmware->samples);
+	stepping = 0;
+	return instructions;
+}
+
+static double bin_freq(const firmware_t *firmware, unsigned bin)
+{
+	return firmware->freqs ? firmware->freqs[bin] : (double) bin * ADC_SAMPLING_FREQ / firmware->block_size;
+}
+
+/* Checks the DC level, the bins of the tones and, for the FFT, the other bins */
+static void check_block(const firmware_t *firmware, const tone_t *tones, unsigned count, const char *name)
+{
+	uint16_t dc;
+	double mean;
+	unsigned long length = analyze(firmware, tones, count, &dc, &mean);
+	int amplitudes_ok = 1;
+	int leakage_ok = 1;
+	char text[80];
+
+	printf(" %s: %lu instructions, DC %u, amplitudes", name, length, dc);
+	for(unsigned bin = 0; bin < firmware->bins; bin++)
+	{
+		double expected = -1;
+
+		for(unsigned i = 0; i < count; i++)
+		{
+			if(fabs(tones[i].freq - bin_freq(firmware, bin)) < 0.5)
+			{
+				expected = tones[i].amplitude;
+			}
+		}
+		if(expected >= 0)
+		{
+			printf(" %u Hz: %u", (unsigned) bin_freq(firmware, bin), firmware->amplitudes[bin]);
+			amplitudes_ok &= fabs(firmware->amplitudes[bin] - expected) <= AMPLITUDE_TOLERANCE(expected);
+		}
+		else if(firmware->fft && bin > 0)
+		{
+			leakage_ok &= firmware->amplitudes[bin] <= LEAKAGE_MAX;
+		}
+	}
+	printf("\n");
+
+	check(fabs(dc - mean) <= 1, "DC level is the mean of the block");
+	check(amplitudes_ok, "amplitudes of the tones");
+	if(firmware->fft)
+	{
+		check(leakage_ok, "other bins below LEAKAGE_MAX");
+	}
+	snprintf(text, sizeof(text), "%lu x %d cycles, %.0f%% of the budget",
+	         length, AVR_CYCLES_PER_INSTRUCTION, 100.0 * length * AVR_CYCLES_PER_INSTRUCTION / firmware->budget);
+	check(length * AVR_CYCLES_PER_INSTRUCTION <= firmware->budget, text);
+}
+
+static void run(const firmware_t *firmware)
+{
+	tone_t tones[2];
+
+	printf("ANALYSIS_FFT %d: %u samples, %u bins, budget %lu cycles per block\n", firmware->fft,
+	       firmware->block_size, firmware->bins, (unsigned long) firmware->budget);
+	firmware->analysis_init();
+
+	check_block(firmware, NULL, 0, "DC only");
+	if(firmware->freqs)
+	{
+		/* One tone at each Goertzel frequency */
+		for(unsigned bin = 0; bin < firmware->bins; bin++)
+		{
+			char name[40];
+
+			tones[0].freq = firmware->freqs[bin];
+			tones[0].amplitude = 400;
+			snprintf(name, sizeof(name), "%u Hz tone", firmware->freqs[bin]);
+			check_block(firmware, tones, 1, name);
+		}
+	}
+	else
+	{
+		/* Two tones at the centers of bins */
+		tones[0].freq = bin_freq(firmware, 4);
+		tones[0].amplitude = 400;
+		tones[1].freq = bin_freq(firmware, 16);
+		tones[1].amplitude = 200;
+		check_block(firmware, tones, 2, "two tones");
+	}
+}
+
+int main(void)
+{
+	struct sigaction action;
+
+	memset(&action, 0, sizeof(action));
+	action.sa_sigaction = trap_handler;
+	action.sa_flags = SA_SIGINFO;
+	sigaction(SIGTRAP, &action, NULL);
+
+	run(&goertzel_variant);
+	run(&fft_variant);
+
+	printf("%s\n", failures ? "FAILED" : "PASSED");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,266 @@
+/*
+    \file   interleaved_pair_bench.c
+
+    \brief  Host benchmark of the burst-interleaved-pair example
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+/*
+ * Compiles the main.c of the burst-interleaved-pair example with the register
+ * model in host-tools/avr-sim, with PAIR_ALIGN set to 0 and to 1 (see
+ * pair_firmware.h), and runs its Result Ready and PIT interrupts for a few
+ * seconds of RTC events.
+ *
+ * The RTC overflows every PER + 1 cycles, and the overflow starts a burst
+ * when the ADC waits for an event. A burst of 2^SAMPNUM conversions takes
+ * (SAMPDUR + 0.5 + ADC_CONVERSION_CLKS) CLK_ADC cycles per conversion. Its
+ * Result Ready interrupt is entered INTERRUPT_LATENCY CLK_PER cycles after the
+ * last conversion, with TCA0.CNT counting CLK_PER cycles, and a burst started
+ * by the handler begins START_DELAY cycles after the entry. VDD/10 is constant
+ * and the current is a sawtooth, so the current the handler stores can be
+ * turned back into the time it was measured at.
+ *
+ * For each setting, the pair rate of the PIT interrupt and the skew of the
+ * example are printed, together with the time of the stored current relative
+ * to the voltage measurement: the skew without PAIR_ALIGN, and close to 0 with
+ * it. The benchmark fails when the pair rate is not PAIR_FREQ, when the skew
+ * the example measures is not the skew of the model, or when the current is
+ * not taken at the expected time.
+ *
+ * Build:   gcc -O2 -Wall -I../avr-sim -o interleaved_pair_bench interleaved_pair_bench.c -lm
+ * Usage:   interleaved_pair_bench [seconds]
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+typedef struct
+{
+	int align;
+	void (*event_system_init)(void);
+	void (*rtc_init)(void);
+	void (*tca_init)(void);
+	void (*adc_init)(void);
+	void (*adc_resrdy_vect)(void);
+	void (*rtc_pit_vect)(void);
+	volatile int16_t *current_raw;
+	volatile uint16_t *skew;
+	volatile uint16_t *pair_rate;
+} firmware_t;
+
+#define PAIR_ALIGN  0
+#define FIRMWARE    unaligned
+#include "pair_firmware.h"
+
+#define PAIR_ALIGN  1
+#define FIRMWARE    aligned
+#include "pair_firmware.h"
+
+#define ADC_CONVERSION_CLKS 13      /* CLK_ADC cycles of a 12-bit conversion after sampling */
+#define INTERRUPT_LATENCY   10      /* CLK_PER cycles from the result to the first instruction of the handler */
+#define START_DELAY         40      /* CLK_PER cycles from the entry of the handler to the start command */
+#define VDD_LSB             1320    /* VDD/10 of a 3.3 V supply, per conversion */
+#define SAWTOOTH_AMPLITUDE  2000.0  /* LSB per conversion */
+#define SAWTOOTH_PERIOD     0.01    /* s */
+#define TIME_TOLERANCE      1.0     /* µs, on the average time of the stored current */
+#define MAX_TIME_ERROR      2.0     /* µs, on the time of any stored current */
+
+static const uint8_t presc_div[] = { 2, 4, 6, 8, 10, 12, 14, 16, 20, 24, 28, 32, 40, 48, 56, 64 };
+
+static int failures;
+
+static void check(int condition, const char *name)
+{
+	printf("  %-56s %s\n", name, condition ? "ok" : "FAILED");
+	if(!condition)
+	{
+		failures++;
+	}
+}
+
+/* Current per conversion at a time in CLK_PER cycles, before quantization */
+static double current_at(double t)
+{
+	double phase = t / (SAWTOOTH_PERIOD * F_CPU);
+
+	return SAWTOOTH_AMPLITUDE * (2 * (phase - floor(phase)) - 1);
+}
+
+static long sawtooth_index(double t)
+{
+	return (long) floor(t / (SAWTOOTH_PERIOD * F_CPU));
+}
+
+static double conversion_cycles(void)
+{
+	return (ADC0.CTRLE + 0.5 + ADC_CONVERSION_CLKS) * presc_div[ADC0.CTRLB & 0x0F];
+}
+
+static void run(const firmware_t *firmware, double seconds)
+{
+	unsigned samples;
+	double conversion;
+	double end = seconds * F_CPU;
+	double next_rtc, next_pit = F_CPU;
+	double burst_start = 0, burst_end = INFINITY;
+	int burst_voltage = 0;
+	double voltage_time = 0, voltage_entry = 0;
+	double previous_current_start = -1;
+	long accumulated = 0;
+	unsigned long pairs = 0, missed = 0, skew_errors = 0;
+	double time_sum = 0, time_max = 0, skew_sum = 0;
+	unsigned long timed = 0;
+	uint16_t pair_rate = 0;
+
+	memset((void *)&ADC0, 0, sizeof(ADC0));
+	memset((void *)&RTC, 0, sizeof(RTC));
+	memset((void *)&TCA0, 0, sizeof(TCA0));
+	memset((void *)&EVSYS, 0, sizeof(EVSYS));
+	firmware->event_system_init();
+	firmware->rtc_init();
+	firmware->tca_init();
+	firmware->adc_init();
+
+	samples = 1 << (ADC0.CTRLF & ADC_SAMPNUM_gm);
+	conversion = conversion_cycles();
+	next_rtc = (RTC.PER + 1.0) * F_CPU / RTC_CLOCK;
+
+	while(1)
+	{
+		double t = fmin(next_rtc, fmin(next_pit, burst_end));
+
+		if(t > end)
+		{
+			break;
+		}
+		if(t == burst_end)
+		{
+			double entry = burst_end + INTERRUPT_LATENCY;
+			int was_voltage = burst_voltage;
+
+			burst_end = INFINITY;
+			ADC0.RESULT = (uint16_t) accumulated;
+			ADC0.INTFLAGS = ADC_RESRDY_bm;
+			TCA0.SINGLE.CNT = (uint16_t) (long) entry;
+			firmware->adc_resrdy_vect();
+
+			if(was_voltage)
+			{
+				voltage_entry = entry;
+			}
+			else
+			{
+				uint16_t model_skew = (uint16_t) ((long) entry - (long) voltage_entry);
+
+				pairs++;
+				skew_errors += (*firmware->skew != model_skew);
+				skew_sum += *firmware->skew;
+
+				/* The first pair is not aligned, and a wrap of the sawtooth between two
+				   current bursts breaks the interpolation */
+				if(previous_current_start >= 0
+				   && sawtooth_index(previous_current_start) == sawtooth_index(entry))
+				{
+					double slope = samples * 2 * SAWTOOTH_AMPLITUDE / (SAWTOOTH_PERIOD * F_CPU);
+					double stored_time = (*firmware->current_raw - samples * current_at(voltage_time)) / slope;
+					double us = stored_time * 1e6 / F_CPU;
+
+					time_sum += us;
+					time_max = fmax(time_max, fabs(us - (firmware->align ? 0 : model_skew * 1e6 / F_CPU)));
+					timed++;
+				}
+				previous_current_start = burst_start;
+			}
+
+			if((ADC0.COMMAND & ADC_START_gm) == ADC_START_IMMEDIATE_gc)
+			{
+				t = entry + START_DELAY;
+			}
+			else
+			{
+				continue;
+			}
+		}
+		else if(t == next_rtc)
+		{
+			next_rtc += (RTC.PER + 1.0) * F_CPU / RTC_CLOCK;
+			if(burst_end != INFINITY || (ADC0.COMMAND & ADC_START_gm) != ADC_START_EVENT_TRIGGER_gc)
+			{
+				missed++;
+				continue;
+			}
+		}
+		else
+		{
+			next_pit += F_CPU;
+			RTC.PITINTFLAGS = RTC_PI_bm;
+			firmware->rtc_pit_vect();
+			pair_rate = *firmware->pair_rate;
+			continue;
+		}
+
+		/* Start a burst at t, on the channel the handler selected */
+		burst_start = t;
+		burst_voltage = (ADC0.MUXPOS == ADC_MUXPOS_VDDDIV10_gc);
+		accumulated = 0;
+		for(unsigned i = 0; i < samples; i++)
+		{
+			double sample_time = t + i * conversion + (ADC0.CTRLE + 0.5) / 2 * presc_div[ADC0.CTRLB & 0x0F];
+
+			accumulated += burst_voltage ? VDD_LSB : lround(current_at(sample_time));
+		}
+		if(burst_voltage)
+		{
+			/* The voltage is measured at the middle of its burst */
+			voltage_time = t + (samples - 1) * conversion / 2 + (ADC0.CTRLE + 0.5) / 2 * presc_div[ADC0.CTRLB & 0x0F];
+		}
+		burst_end = t + samples * conversion;
+	}
+
+	double skew_us = pairs ? skew_sum / pairs * 1e6 / F_CPU : 0;
+	double time_us = timed ? time_sum / timed : 0;
+
+	printf("PAIR_ALIGN %d: pair_rate %u/s, skew %.2f us, current taken %.2f us after the voltage (max error %.2f us)\n",
+	       firmware->align, pair_rate, skew_us, time_us, time_max);
+	check(pair_rate == PAIR_FREQ, "pair_rate is PAIR_FREQ");
+	check(missed == 0, "every RTC event starts a pair");
+	check(pairs > 0 && skew_errors == 0, "skew equals the time between the two results");
+	check(fabs(time_us - (firmware->align ? 0 : skew_us)) < TIME_TOLERANCE,
+	      firmware->align ? "current aligned to the voltage measurement" : "current taken one skew after the voltage");
+	check(time_max < MAX_TIME_ERROR, "time of every stored current");
+}
+
+int main(int argc, char *argv[])
+{
+	double seconds = (argc > 1) ? atof(argv[1]) : 4;
+
+	printf("PAIR_FREQ %u Hz, %.0f s\n", PAIR_FREQ, seconds);
+	run(&unaligned_variant, seconds);
+	run(&aligned_variant, seconds);
+
+	printf("%s\n", failures ? "FAILED" : "PASSED");
+	return failures ? 1 : 0;
+}
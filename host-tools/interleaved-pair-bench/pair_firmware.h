@@ -0,0 +1,97 @@
+/*
+    \file   pair_firmware.h
+
+    \brief  Includes the burst-interleaved-pair example once per PAIR_ALIGN setting
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+/*
+ * Included by interleaved_pair_bench.c once for each PAIR_ALIGN setting, with
+ * FIRMWARE defined to a prefix, e.g.
+ *
+ *     #define PAIR_ALIGN  0
+ *     #define FIRMWARE    unaligned
+ *     #include "pair_firmware.h"
+ *
+ * Every name the example defines gets the prefix, so both builds of main.c are
+ * in one program. The registers of avr-sim are shared. The functions and
+ * variables the benchmark uses are collected in FIRMWARE_variant.
+ */
+
+#define FIRMWARE_NAME(name)             FIRMWARE_PASTE(FIRMWARE, name)
+#define FIRMWARE_PASTE(prefix, name)    FIRMWARE_PASTE_(prefix, name)
+#define FIRMWARE_PASTE_(prefix, name)   prefix##_##name
+
+#define main                FIRMWARE_NAME(main)
+#define pair_channel_t      FIRMWARE_NAME(pair_channel_t)
+#define CHANNEL_VOLTAGE     FIRMWARE_NAME(CHANNEL_VOLTAGE)
+#define CHANNEL_CURRENT     FIRMWARE_NAME(CHANNEL_CURRENT)
+#define adc_pair_t          FIRMWARE_NAME(adc_pair_t)
+#define pair                FIRMWARE_NAME(pair)
+#define vdd                 FIRMWARE_NAME(vdd)
+#define current             FIRMWARE_NAME(current)
+#define power               FIRMWARE_NAME(power)
+#define skew_us             FIRMWARE_NAME(skew_us)
+#define pair_rate           FIRMWARE_NAME(pair_rate)
+#define event_system_init   FIRMWARE_NAME(event_system_init)
+#define rtc_init            FIRMWARE_NAME(rtc_init)
+#define tca_init            FIRMWARE_NAME(tca_init)
+#define adc_init            FIRMWARE_NAME(adc_init)
+#define ADC0_RESRDY_vect    FIRMWARE_NAME(ADC0_RESRDY_vect)
+#define RTC_PIT_vect        FIRMWARE_NAME(RTC_PIT_vect)
+
+#include "../../attiny1627-how-to-use-the-12-bit-differential-adc-with-pga/burst-interleaved-pair/main.c"
+
+static const firmware_t FIRMWARE_NAME(variant) =
+{
+	PAIR_ALIGN,
+	event_system_init,
+	rtc_init,
+	tca_init,
+	adc_init,
+	ADC0_RESRDY_vect,
+	RTC_PIT_vect,
+	&pair.current_raw,
+	&pair.skew,
+	&pair_rate
+};
+
+#undef main
+#undef pair_channel_t
+#undef CHANNEL_VOLTAGE
+#undef CHANNEL_CURRENT
+#undef adc_pair_t
+#undef pair
+#undef vdd
+#undef current
+#undef power
+#undef skew_us
+#undef pair_rate
+#undef event_system_init
+#undef rtc_init
+#undef tca_init
+#undef adc_init
+#undef ADC0_RESRDY_vect
+#undef RTC_PIT_vect
+#undef PAIR_ALIGN
+#undef FIRMWARE
@@ -0,0 +1,257 @@
+/*
+    \file   lut_linearization_test.c
+
+    \brief  Host test of lut_lookup() in the single-lut-linearization example
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+/*
+ * Compiles the main.c of the single-lut-linearization example with the
+ * register model in host-tools/avr-sim and checks lut_lookup():
+ *
+ * - every code covered by thermistor.csv is converted with the generated
+ *   table, and compared to the linear interpolation of the curve. The worst
+ *   case error is printed, and must stay below MAX_ERROR_DEGC
+ * - the temperature falls with the code over the whole 12-bit range
+ * - synthetic tables for 16- and 17-bit codes, with breakpoints far apart and
+ *   shifts of 14 to 16, agree with a floating point interpolation. These
+ *   shifts overflow a 32-bit product. A wrapped product can still give the
+ *   right 16-bit result, so the test is built with the undefined behavior
+ *   sanitizer, which stops at the first signed overflow
+ * - with LOOKUP_INSTRUCTIONS defined, the lookup of every 12-bit code in the
+ *   thermistor table is single-stepped with the x86 trap flag, as in
+ *   frequency-analysis-test, and the instructions are counted and printed.
+ *   Build without the sanitizer for this, as its checks are counted too. The
+ *   count is for the x86-64 host, which multiplies 32-bit values in one
+ *   instruction, so the AVR takes more cycles than this
+ *
+ * Build:   gcc -O2 -Wall -fsanitize=undefined -fno-sanitize-recover -I../avr-sim -o lut_linearization_test lut_linearization_test.c -lm
+ *          gcc -O2 -Wall -DLOOKUP_INSTRUCTIONS -I../avr-sim -o lut_linearization_test lut_linearization_test.c -lm
+ * Usage:   lut_linearization_test [curve.csv]
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef LOOKUP_INSTRUCTIONS
+#include <string.h>
+#include <signal.h>
+
+#if !defined(__x86_64__) || !defined(__linux__)
+#error "LOOKUP_INSTRUCTIONS single-steps with the x86-64 trap flag on Linux"
+#endif
+#include <ucontext.h>
+#endif
+
+#define main firmware_main
+#include "../../attiny1627-how-to-use-the-12-bit-differential-adc-with-pga/single-lut-linearization/main.c"
+#undef main
+
+#define CURVE_FILE      "../../attiny1627-how-to-use-the-12-bit-differential-adc-with-pga/single-lut-linearization/thermistor.csv"
+#define MAX_POINTS      256
+#define MAX_ERROR_DEGC  0.3     /* Worst case table error the example documents, with margin */
+#define TRAP_FLAG       0x100
+
+static int failures;
+
+static void check(int condition, const char *name)
+{
+	printf("%-60s %s\n", name, condition ? "ok" : "FAILED");
+	if(!condition)
+	{
+		failures++;
+	}
+}
+
+#ifdef LOOKUP_INSTRUCTIONS
+static volatile int stepping;
+static unsigned long instructions;
+static volatile int16_t lookup_value;
+
+/* Called after every instruction */
+static void trap_handler(int signal, siginfo_t *info, void *context)
+{
+	ucontext_t *uc = context;
+
+	(void) signal;
+	(void) info;
+	if(!stepping)
+	{
+		uc->uc_mcontext.gregs[REG_EFL] &= ~TRAP_FLAG;
+		return;
+	}
+	instructions++;
+}
+
+/* The lookup of the example, as in its main loop */
+static __attribute__((noinline)) void thermistor_lookup(uint32_t code)
+{
+	lookup_value = lut_lookup(thermistor_lut, THERMISTOR_LUT_SHIFT, code);
+}
+#endif
+
+static double curve_code[MAX_POINTS];
+static double curve_value[MAX_POINTS];
+static int curve_points;
+
+/* Reads the code,value lines of the CSV file, skipping the header */
+static int read_curve(const char *path)
+{
+	FILE *f = fopen(path, "r");
+	char line[128];
+
+	if(f == NULL)
+	{
+		perror(path);
+		return -1;
+	}
+	while(fgets(line, sizeof(line), f) != NULL && curve_points < MAX_POINTS)
+	{
+		if(sscanf(line, "%lf,%lf", &curve_code[curve_points], &curve_value[curve_points]) == 2)
+		{
+			curve_points++;
+		}
+	}
+	fclose(f);
+	return (curve_points < 2) ? -1 : 0;
+}
+
+/* Same interpolation as evaluate() in generate_lut.py, the curve is sorted by code */
+static double evaluate(double code)
+{
+	int i = 1;
+
+	while(i < curve_points - 1 && code > curve_code[i])
+	{
+		i++;
+	}
+	return curve_value[i - 1] + (curve_value[i] - curve_value[i - 1]) * (code - curve_code[i - 1]) / (curve_code[i] - curve_code[i - 1]);
+}
+
+static void test_thermistor_table(void)
+{
+	double worst_error = 0;
+	uint32_t worst_code = 0;
+	int monotonic = 1;
+	int16_t previous = INT16_MAX;
+
+	for(uint32_t code = curve_code[0]; code <= curve_code[curve_points - 1] && code < 4096; code++)
+	{
+		double error = fabs(lut_lookup(thermistor_lut, THERMISTOR_LUT_SHIFT, code) / (double) THERMISTOR_LUT_SCALE - evaluate(code));
+
+		if(error > worst_error)
+		{
+			worst_error = error;
+			worst_code = code;
+		}
+	}
+	for(uint32_t code = 0; code < 4096; code++)
+	{
+		int16_t value = lut_lookup(thermistor_lut, THERMISTOR_LUT_SHIFT, code);
+
+		if(value > previous)
+		{
+			monotonic = 0;
+		}
+		previous = value;
+	}
+	printf("thermistor table: maximum error %.4f degC at code %u\n", worst_error, (unsigned) worst_code);
+	check(worst_error < MAX_ERROR_DEGC, "thermistor table within the documented error");
+	check(monotonic, "temperature falls with the code");
+}
+
+#ifdef LOOKUP_INSTRUCTIONS
+/* Counts the instructions of a lookup for every 12-bit code, with the call */
+static void test_lookup_instructions(void)
+{
+	struct sigaction action;
+	unsigned long fewest = ~0UL;
+	unsigned long most = 0;
+	unsigned long total = 0;
+
+	memset(&action, 0, sizeof(action));
+	action.sa_sigaction = trap_handler;
+	action.sa_flags = SA_SIGINFO;
+	sigaction(SIGTRAP, &action, NULL);
+
+	for(uint32_t code = 0; code < 4096; code++)
+	{
+		instructions = 0;
+		stepping = 1;
+		__asm__ volatile("pushf\n\torl %0, (%%rsp)\n\tpopf" : : "i" (TRAP_FLAG) : "memory", "cc");
+		thermistor_lookup(code);
+		stepping = 0;
+
+		fewest = (instructions < fewest) ? instructions : fewest;
+		most = (instructions > most) ? instructions : most;
+		total += instructions;
+	}
+	printf("thermistor lookup: %lu to %lu x86-64 instructions, %.1f on average\n", fewest, most, total / 4096.0);
+	check(most > 0, "lookup instructions counted");
+}
+#endif
+
+/* Two segments over the whole range of a (shift + 1)-bit code, from -30000 to +30000 and back */
+static void test_wide_table(uint8_t shift)
+{
+	static const int16_t table[] = { -30000, 30000, -30000 };
+	double worst_error = 0;
+	char name[80];
+
+	for(uint32_t code = 0; code < (2UL << shift); code++)
+	{
+		uint32_t index = code >> shift;
+		double position = (double) (code & ((1UL << shift) - 1)) / (1UL << shift);
+		double expected = table[index] + (table[index + 1] - table[index]) * position;
+		double error = fabs(lut_lookup(table, shift, code) - expected);
+
+		if(error > worst_error)
+		{
+			worst_error = error;
+		}
+	}
+	snprintf(name, sizeof(name), "%u-bit code, shift %u: within 1 of the interpolation", shift + 1, shift);
+	check(worst_error <= 1.0, name);
+}
+
+int main(int argc, char *argv[])
+{
+	if(read_curve((argc > 1) ? argv[1] : CURVE_FILE) != 0)
+	{
+		fprintf(stderr, "No curve, give the path of thermistor.csv as argument\n");
+		return 1;
+	}
+
+	test_thermistor_table();
+	test_wide_table(14);
+	test_wide_table(15);
+	test_wide_table(16);
+#ifdef LOOKUP_INSTRUCTIONS
+	test_lookup_instructions();
+#endif
+
+	printf("%s\n", failures ? "FAILED" : "PASSED");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,282 @@
+/*
+    \file   seqlock_stress_test.c
+
+    \brief  Host stress test of the sequence lock in the burst-seqlock-snapshot example
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+/*
+ * Compiles the main.c of the burst-seqlock-snapshot example with the register
+ * model in host-tools/avr-sim, and checks that snapshot_read() never returns a
+ * torn snapshot, whatever point the Result Ready interrupt comes at:
+ *
+ * - instruction granularity: snapshot_read() is single-stepped with the x86
+ *   trap flag, and the interrupt handler is called after instruction k, for
+ *   every k of the read, and again in bursts of up to three interrupts per read
+ * - byte granularity: the AVR loads the snapshot one byte at a time. The same
+ *   protocol is run with one load per byte, and the interrupt handler is called
+ *   before each byte. A copy without the sequence check is torn by the same
+ *   interrupts, which shows that the check detects torn copies
+ *
+ * Every snapshot has a timestamp that tells which interrupt wrote it, so the
+ * raw result and the voltage of a copy can be compared to the values of that
+ * interrupt. Consecutive raw results differ in every byte. The timestamps are
+ * also compared to the RTC period, PER + 1 cycles per trigger.
+ *
+ * The single-stepping needs x86-64 Linux, elsewhere only the byte granularity
+ * test is run.
+ *
+ * Build:   gcc -O2 -Wall -I../avr-sim -o seqlock_stress_test seqlock_stress_test.c -lm
+ * Usage:   seqlock_stress_test
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+
+#if defined(__x86_64__) && defined(__linux__)
+#include <ucontext.h>
+#define SINGLE_STEP 1
+#define TRAP_FLAG   0x100
+#else
+#define SINGLE_STEP 0
+#endif
+
+#define main firmware_main
+#include "../../attiny1627-how-to-use-the-12-bit-differential-adc-with-pga/burst-seqlock-snapshot/main.c"
+#undef main
+
+#define MAX_BURST       3       /* Interrupts per read in the burst test */
+#define MAX_STEPS       1000    /* A read that takes more instructions is a failure */
+
+static int failures;
+static uint32_t publishes;
+
+static void check(int condition, const char *name)
+{
+	printf("%-60s %s\n", name, condition ? "ok" : "FAILED");
+	if(!condition)
+	{
+		failures++;
+	}
+}
+
+/* Raw result of interrupt n, consecutive values differ in all four bytes */
+static int32_t test_raw(uint32_t n)
+{
+	return (n & 1) ? 0x5A5A : -0x2525;
+}
+
+/* One RTC overflow: the burst result is ready and the handler publishes it */
+static void publish(void)
+{
+	publishes++;
+	ADC0.RESULT = test_raw(publishes);
+	ADC0.INTFLAGS = ADC_RESRDY_bm;
+	ADC0_RESRDY_vect();
+}
+
+/* The copy holds the values of one interrupt */
+static int consistent(const adc_snapshot_t *copy)
+{
+	uint32_t n = copy->timestamp / (RTC_PERIOD + 1);
+	float expected_voltage = (float)((test_raw(n) * 1.024) / ADC_DIFF_MAX_VALUE_16BIT) / 16;
+
+	return n > 0 && n <= publishes && copy->timestamp == n * (RTC_PERIOD + 1) && copy->raw == test_raw(n) && copy->voltage == expected_voltage;
+}
+
+/**********************************************************************************
+Byte granularity
+**********************************************************************************/
+static const volatile uint8_t *snapshot_bytes = (const volatile uint8_t *) &snapshot;
+static unsigned byte_loads;
+static unsigned byte_interrupt_at;
+
+static uint8_t load_byte(const volatile uint8_t *p)
+{
+	if(byte_loads++ == byte_interrupt_at)
+	{
+		publish();
+	}
+	return *p;
+}
+
+/* snapshot_read() with one load per byte, as on the AVR */
+static void byte_read(adc_snapshot_t *copy, int sequence_check)
+{
+	uint8_t *bytes = (uint8_t *) copy;
+	uint8_t sequence;
+
+	while(1)
+	{
+		sequence = load_byte(&snapshot_sequence);
+		for(unsigned i = 0; i < sizeof(*copy); i++)
+		{
+			bytes[i] = load_byte(&snapshot_bytes[i]);
+		}
+		if(!sequence_check || (!(sequence & 1) && sequence == load_byte(&snapshot_sequence)))
+		{
+			return;
+		}
+	}
+}
+
+static void test_byte_granularity(void)
+{
+	adc_snapshot_t copy;
+	int torn_with_check = 0;
+	int torn_without_check = 0;
+
+	for(unsigned k = 0; k <= sizeof(copy) + 1; k++)
+	{
+		byte_loads = 0;
+		byte_interrupt_at = k;
+		byte_read(&copy, 1);
+		torn_with_check += !consistent(&copy);
+
+		byte_loads = 0;
+		byte_interrupt_at = k;
+		byte_read(&copy, 0);
+		torn_without_check += !consistent(&copy);
+	}
+	printf("byte granularity: %u interrupt points, %d torn copies without the sequence check\n", (unsigned) sizeof(copy) + 2, torn_without_check);
+	check(torn_with_check == 0, "no torn copy with an interrupt before any byte");
+	check(torn_without_check > 0, "a copy without the sequence check is torn");
+}
+
+/**********************************************************************************
+Instruction granularity
+**********************************************************************************/
+#if SINGLE_STEP
+static volatile int stepping;
+static volatile unsigned steps;
+static unsigned interrupt_at[MAX_BURST];
+static unsigned interrupts;
+
+static void trap_handler(int signal, siginfo_t *info, void *context)
+{
+	ucontext_t *uc = context;
+
+	(void) signal;
+	(void) info;
+	if(!stepping || steps >= MAX_STEPS)
+	{
+		uc->uc_mcontext.gregs[REG_EFL] &= ~TRAP_FLAG;
+		return;
+	}
+	for(unsigned i = 0; i < interrupts; i++)
+	{
+		if(interrupt_at[i] == steps)
+		{
+			publish();
+		}
+	}
+	steps++;
+}
+
+/* Runs snapshot_read() one instruction at a time, returns the number of instructions */
+static unsigned stepped_read(adc_snapshot_t *copy, uint8_t *retries)
+{
+	steps = 0;
+	stepping = 1;
+	__asm__ volatile("pushf\n\torl %0, (%%rsp)\n\tpopf" : : "i" (TRAP_FLAG) : "memory", "cc");
+	*retries = snapshot_read(copy);
+	stepping = 0;
+	return steps;
+}
+
+static void test_instruction_granularity(void)
+{
+	struct sigaction action;
+	adc_snapshot_t copy;
+	uint8_t retries;
+	unsigned length;
+	unsigned reads = 0;
+	unsigned torn = 0;
+	unsigned retried = 0;
+	unsigned stuck = 0;
+
+	memset(&action, 0, sizeof(action));
+	action.sa_sigaction = trap_handler;
+	action.sa_flags = SA_SIGINFO;
+	sigaction(SIGTRAP, &action, NULL);
+
+	interrupts = 0;
+	length = stepped_read(&copy, &retries);
+	printf("instruction granularity: undisturbed read is %u instructions\n", length);
+
+	/* One interrupt after each instruction, then bursts at every spacing */
+	for(unsigned burst = 1; burst <= MAX_BURST; burst++)
+	{
+		for(unsigned spacing = 1; spacing <= ((burst == 1) ? 1 : length); spacing++)
+		{
+			for(unsigned k = 0; k <= length; k++)
+			{
+				interrupts = burst;
+				for(unsigned i = 0; i < burst; i++)
+				{
+					interrupt_at[i] = k + i * spacing;
+				}
+				stepped_read(&copy, &retries);
+				reads++;
+				torn += !consistent(&copy);
+				retried += (retries > 0);
+				stuck += (steps >= MAX_STEPS);
+			}
+		}
+	}
+	interrupts = 0;
+	printf("instruction granularity: %u reads, %u retried\n", reads, retried);
+	check(torn == 0, "no torn copy with interrupts after any instruction");
+	check(stuck == 0, "every read completes");
+	check(retried > 0, "interrupts during the copy force a retry");
+}
+#endif
+
+int main(void)
+{
+	adc_snapshot_t copy;
+
+	rtc_init();
+	publish(); /* The first snapshot */
+
+	for(int i = 0; i < 99; i++)
+	{
+		publish();
+	}
+	snapshot_read(&copy);
+	check(copy.timestamp == 100UL * (RTC.PER + 1), "timestamps advance by PER + 1 per trigger");
+
+	test_byte_granularity();
+#if SINGLE_STEP
+	test_instruction_granularity();
+#else
+	printf("instruction granularity: not supported on this host\n");
+#endif
+
+	printf("%s\n", failures ? "FAILED" : "PASSED");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,157 @@
+#!/usr/bin/env python3
+"""
+    \\file   check_golden.py
+
+    \\brief  Replays the golden traces through the code examples and compares the results
+
+    Every example in EXAMPLES is compiled with trace_example.c and the register
+    model in host-tools/avr-sim, and its main() is run on a golden trace. The
+    values the example calculated for every result are compared with the golden
+    output, <name>.csv, and the first differences are printed. The
+    throughput of the simulated firmware is printed for every example.
+
+    After a change that is meant to change the results, run with --update to
+    write the new golden outputs, and review the difference before committing.
+    The traces are generated by --traces, and are committed so that they do not
+    depend on the floating point library of the host.
+
+    Examples that are not in EXAMPLES cannot be replayed, because trace_example.c
+    feeds the trace on accesses to ADC0 from the main loop of the example:
+      - burst-coulomb-counter, burst-interleaved-pair, burst-seqlock-snapshot,
+        single-adaptive-sampling, single-frequency-analysis and
+        single-statistics start their conversions by RTC overflow events and
+        read the results in the interrupt handler.
+      - burst-usart-command is started by RTC overflow events as well, and
+        also waits for commands from the USART.
+      - single-event-pipeline starts its conversions by TCA0 overflow events.
+      - single-eeprom-logger waits for the seconds counted by the RTC
+        interrupt.
+      - burst-chopping-diff-pga, burst-pga-channel-scan, single-ratiometric
+        and single-triggered-capture start the next conversion from the ADC
+        interrupt handler, and the main loop only reads the results from RAM.
+      - burst-power-profiles starts its bursts from the RTC interrupt handler
+        and sleeps in between, and its adc_result variable collides with
+        adc_result() of trace.h.
+      - single-window-fast-path runs freely and routes the window compare
+        event to the CCL and TCB0, and the main loop only reads ADC0 after a
+        trip.
+      - single-high-speed-usart clears TXCIF by writing USART0.STATUS, which
+        also clears DREIF in the register model, so it waits forever.
+
+    Usage:
+        python3 check_golden.py [--update] [--traces] [--cc gcc]
+"""
+
+import argparse
+import math
+import os
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+REPO = os.path.normpath(os.path.join(HERE, '..', '..', '..'))
+EXAMPLES_DIR = os.path.join(REPO, 'attiny1627-how-to-use-the-12-bit-differential-adc-with-pga')
+
+TRACE_SAMPLES = 8192
+
+# Name of the golden output, example, trace, extra compiler options
+EXAMPLES = [
+    ('burst-event-trigger', 'burst-event-trigger', 'single_ended.csv', []),
+    ('burst-oversampling', 'burst-oversampling', 'single_ended.csv', []),
+    ('burst-scaling-diff-pga', 'burst-scaling-diff-pga', 'differential.csv', []),
+    ('burst-window-comparator', 'burst-window-comparator', 'window.csv', []),
+    ('series-dithered-oversampling', 'series-dithered-oversampling', 'single_ended.csv', []),
+    ('series-event-trigger', 'series-event-trigger', 'single_ended.csv', []),
+    ('series-oversampling', 'series-oversampling', 'single_ended.csv', []),
+    ('series-scaling', 'series-scaling', 'single_ended.csv', []),
+    ('series-unified-accumulation', 'series-unified-accumulation', 'single_ended.csv', []),
+    ('series-unified-accumulation-diff-window', 'series-unified-accumulation', 'differential.csv',
+     ['-DACQ_DIFF=1', '-DACQ_WINDOW=1']),
+    ('series-window-comparator', 'series-window-comparator', 'window.csv', []),
+    ('single-event-trigger', 'single-event-trigger', 'single_ended.csv', []),
+    ('single-lut-linearization', 'single-lut-linearization', 'single_ended.csv',
+     ['-DTRACE_VALUE=temperature_in_centi_degC']),
+    ('single-measuring-temp', 'single-measuring-temp', 'single_ended.csv', ['-DTRACE_VALUE=temperature_in_K']),
+    ('single-measuring-vdd', 'single-measuring-vdd', 'single_ended.csv', []),
+    ('single-watchdog-supervised', 'single-watchdog-supervised', 'single_ended.csv', []),
+    ('single-window-comparator', 'single-window-comparator', 'single_ended.csv', []),
+    ('single-window-comparator-window', 'single-window-comparator', 'window.csv', []),
+]
+
+
+def write_traces():
+    """Slow sines with a small saw tooth on top, which go beyond the range of the ADC at the peaks, except in window.csv"""
+    with open(os.path.join(HERE, 'single_ended.csv'), 'w') as f:
+        f.write('sample\n')
+        for i in range(TRACE_SAMPLES):
+            f.write('%d\n' % round(2048 + 2100 * math.sin(2 * math.pi * i / 3000) + i % 7 - 3))
+    with open(os.path.join(HERE, 'differential.csv'), 'w') as f:
+        f.write('sample\n')
+        for i in range(TRACE_SAMPLES):
+            f.write('%d\n' % round(2100 * math.sin(2 * math.pi * i / 2000) + i % 5 - 2))
+    # Stays inside the 2000..3000 window of the window comparator examples, except for a short spike every
+    # 1000 samples, which alternates between above and below the window
+    with open(os.path.join(HERE, 'window.csv'), 'w') as f:
+        f.write('sample\n')
+        for i in range(TRACE_SAMPLES):
+            if i >= 1000 and i % 1000 < 8:
+                f.write('%d\n' % (3300 if i // 1000 % 2 else 1700))
+            else:
+                f.write('%d\n' % round(2500 + 400 * math.sin(2 * math.pi * i / 2500) + i % 7 - 3))
+
+
+def replay(cc, build_dir, name, example, trace, options):
+    binary = os.path.join(build_dir, name)
+    subprocess.run([cc, '-O2', '-Wall', '-I' + os.path.join(HERE, '..', '..', 'avr-sim'),
+                    '-I' + os.path.join(EXAMPLES_DIR, example)] + options +
+                   ['-o', binary, os.path.join(HERE, '..', 'trace_example.c'), '-lm'], check=True)
+    run = subprocess.run([binary, os.path.join(HERE, trace)], stdout=subprocess.PIPE,
+                         stderr=subprocess.PIPE, universal_newlines=True, timeout=60)
+    if run.returncode != 0:
+        sys.exit('%s: %s' % (name, run.stderr.strip()))
+    return run.stdout, run.stderr.strip()
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compare the results of the code examples with the golden outputs')
+    parser.add_argument('--update', action='store_true', help='Write the golden outputs instead of comparing')
+    parser.add_argument('--traces', action='store_true', help='Generate the golden traces')
+    parser.add_argument('--cc', default='gcc', help='Host C compiler')
+    args = parser.parse_args()
+
+    if args.traces:
+        write_traces()
+
+    failures = 0
+    with tempfile.TemporaryDirectory() as build_dir:
+        for name, example, trace, options in EXAMPLES:
+            output, throughput = replay(args.cc, build_dir, name, example, trace, options)
+            golden_path = os.path.join(HERE, name + '.csv')
+
+            if args.update:
+                with open(golden_path, 'w') as f:
+                    f.write(output)
+                print('%-40s written, %s' % (name, throughput))
+                continue
+
+            with open(golden_path) as f:
+                golden = f.read().splitlines()
+            replayed = output.splitlines()
+            differences = [(n, g, r) for n, (g, r) in enumerate(zip(golden, replayed)) if g != r]
+            if len(golden) != len(replayed):
+                differences.append((min(len(golden), len(replayed)), '%d results' % len(golden),
+                                    '%d results' % len(replayed)))
+
+            print('%-40s %s, %s' % (name, 'differs' if differences else 'ok', throughput))
+            for n, g, r in differences[:5]:
+                print('    result %d: golden %s, replayed %s' % (n, g, r))
+            failures += bool(differences)
+
+    if not args.update:
+        print('FAILED' if failures else 'PASSED')
+    return 1 if failures else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,177 @@
+/*
+    \file   trace.h
+
+    \brief  Trace reader and ADC result model shared by the trace replay tools
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+/*
+ * The trace is memory-mapped and read once from start to end, so traces with
+ * millions of samples are not loaded into memory. A trace is either a CSV file
+ * with one sample per line in the first column, or binary with 16-bit little
+ * endian samples. The samples are 12-bit ADC codes, signed in differential
+ * mode.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define ADC_RESOLUTION      12
+#define SCALED_BITS         16
+
+typedef struct
+{
+	const char *data;
+	size_t size;
+	size_t pos;
+	int binary;
+} trace_t;
+
+static int trace_open(trace_t *trace, const char *path)
+{
+	struct stat st;
+	int fd = open(path, O_RDONLY);
+
+	if(fd < 0)
+	{
+		fprintf(stderr, "%s: %s\n", path, strerror(errno));
+		return -1;
+	}
+	if(fstat(fd, &st) < 0)
+	{
+		fprintf(stderr, "%s: %s\n", path, strerror(errno));
+		close(fd);
+		return -1;
+	}
+	trace->size = st.st_size;
+	trace->pos = 0;
+	trace->data = NULL;
+	if(trace->size > 0)
+	{
+		trace->data = mmap(NULL, trace->size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(trace->data == MAP_FAILED)
+		{
+			fprintf(stderr, "%s: %s\n", path, strerror(errno));
+			trace->data = NULL;
+			close(fd);
+			return -1;
+		}
+		/* Read ahead, and let the kernel drop the pages that have been read */
+		madvise((void *)trace->data, trace->size, MADV_SEQUENTIAL);
+	}
+	close(fd);
+	return 0;
+}
+
+static void trace_close(trace_t *trace)
+{
+	if(trace->data)
+	{
+		munmap((void *)trace->data, trace->size);
+		trace->data = NULL;
+	}
+}
+
+/* Reads the next sample, returns 0 at the end of the trace */
+static int trace_next(trace_t *trace, int32_t *sample)
+{
+	if(trace->binary)
+	{
+		if(trace->pos + 2 > trace->size)
+		{
+			return 0;
+		}
+		const uint8_t *p = (const uint8_t *)trace->data + trace->pos;
+		*sample = (int16_t)(p[0] | (p[1] << 8));
+		trace->pos += 2;
+		return 1;
+	}
+
+	while(trace->pos < trace->size)
+	{
+		const char *line = trace->data + trace->pos;
+		const char *end = memchr(line, '\n', trace->size - trace->pos);
+		size_t len = end ? (size_t)(end - line) : trace->size - trace->pos;
+		char field[24];
+		char *stop;
+
+		trace->pos += len + 1;
+		if(len >= sizeof(field))
+		{
+			len = sizeof(field) - 1;
+		}
+		memcpy(field, line, len);
+		field[len] = '\0';
+
+		long value = strtol(field, &stop, 0);
+		if(stop != field)
+		{
+			*sample = value;
+			return 1;
+		}
+		/* Header or empty line */
+	}
+	return 0;
+}
+
+/* Clamps a sample to the range of the ADC, as the device would convert it */
+static int32_t clamp_sample(int32_t sample, int differential)
+{
+	int32_t max = differential ? (1 << (ADC_RESOLUTION - 1)) - 1 : (1 << ADC_RESOLUTION) - 1;
+	int32_t min = differential ? -(1 << (ADC_RESOLUTION - 1)) : 0;
+
+	return (sample > max) ? max : (sample < min) ? min : sample;
+}
+
+/*
+ * RESULT for the sum of 2^sampnum samples. In the Scaling modes, a sum of more
+ * than 16 bits is scaled down to the 16-bit mean, rounded down. With LEFTADJ, a
+ * result of less than 16 bits is left adjusted to 16 bits.
+ */
+static int64_t adc_result(int64_t sum, int sampnum, int scaling, int leftadj)
+{
+	int bits = ADC_RESOLUTION + sampnum;
+
+	if(scaling && bits > SCALED_BITS)
+	{
+		sum >>= bits - SCALED_BITS;
+		bits = SCALED_BITS;
+	}
+	if(leftadj && bits < SCALED_BITS)
+	{
+		sum *= 1 << (SCALED_BITS - bits);
+	}
+	return sum;
+}
+
+#endif /* TRACE_H */
@@ -0,0 +1,346 @@
+/*
+    \file   trace_example.c
+
+    \brief  Replays an ADC trace through the main.c of a code example
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+/*
+ * Compiles the main.c of a code example with the register model in
+ * host-tools/avr-sim, and runs its main() with a model of the ADC that takes
+ * its samples from a trace. After every result, the values the example
+ * calculated from it are printed, by default adc_reading and voltage. So the
+ * output changes when a change to the example changes its results, and can be
+ * compared with the golden outputs in golden/.
+ *
+ * Every access to ADC0 calls the ADC model (AVR_SIM_ADC_HOOK in avr-sim):
+ * - a conversion started with START_IMMEDIATE is done at the next access. A
+ *   single conversion or a Series step takes one sample, a Burst takes
+ *   2^SAMPNUM samples. RESRDY is cleared when the next conversion is started.
+ * - with START_EVENT_TRIGGER or FREERUN, the next trigger comes when RESRDY is
+ *   clear. The example reads RESULT after it has seen RESRDY, and this clears
+ *   the flag, so RESRDY is cleared at the second access after the one that saw
+ *   it set.
+ * - SAMPLE, RESULT, SAMPRDY, RESRDY and WCMP are set as the device sets them,
+ *   with the accumulation, scaling and LEFTADJ of trace.h. When global
+ *   interrupts and the interrupt are enabled, the example's interrupt handler
+ *   is called, and its flag is cleared when the handler returns.
+ * - a write to INTFLAGS is seen at the next access, and clears the flags that
+ *   were written as 1. A write that leaves INTFLAGS unchanged is not seen.
+ * The values of a result are printed when the next conversion starts, as the
+ * example has processed the result by then, and at the end of the trace.
+ *
+ * The example must access ADC0 in its main loop, e.g. burst-oversampling,
+ * series-scaling, single-event-trigger or series-dithered-oversampling. The
+ * USART transmitter is always ready. Other values are printed with e.g.
+ * -DTRACE_VALUE=temperature_in_centi_degC.
+ *
+ * Build:   gcc -O2 -Wall -I../avr-sim -I<example directory> -o trace_example trace_example.c -lm
+ * Usage:   trace_example [-b] [-q] <trace>
+ *
+ * Options:
+ *   -b              Trace is binary, 16-bit little endian samples (default: CSV, first column)
+ *   -q              Do not print the results, only the throughput
+ */
+
+#define AVR_SIM_ADC_HOOK
+
+#include <setjmp.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include "trace.h"
+
+/* The handlers the example may define */
+void ADC0_RESRDY_vect(void) __attribute__((weak));
+void ADC0_SAMPRDY_vect(void) __attribute__((weak));    /* Also the Window Compare interrupt */
+
+#define main firmware_main
+#include "main.c"   /* The example, from the -I directory */
+#undef main
+
+#ifndef TRACE_READING
+#define TRACE_READING   adc_reading
+#endif
+#ifndef TRACE_VALUE
+#define TRACE_VALUE     voltage
+#endif
+
+#define STALL_SECONDS   2   /* No access to ADC0 for this long ends the replay */
+
+typedef struct
+{
+	trace_t trace;
+	int quiet;
+	int depth;                  /* Nesting of the hook, > 0 in an interrupt handler */
+	unsigned accesses_since_result;
+	uint8_t intflags;           /* INTFLAGS as the model left it, to see writes */
+	int result_pending;         /* A result whose values are not printed yet */
+	int64_t sum;
+	unsigned accumulated;
+	unsigned long samples;
+	unsigned long results;
+	unsigned long accesses;
+	jmp_buf end;
+} adc_model_t;
+
+static adc_model_t model;
+
+static void print_values(void)
+{
+	if(model.result_pending && !model.quiet)
+	{
+		printf("%lld,%.7g\n", (long long) TRACE_READING, (double) TRACE_VALUE);
+	}
+	model.result_pending = 0;
+}
+
+/* Flags are cleared by writing 1, the avr-sim register only stores the written value */
+static void clear_written_flags(uint8_t before)
+{
+	if(avr_sim_adc0.INTFLAGS != before)
+	{
+		avr_sim_adc0.INTFLAGS = before & ~avr_sim_adc0.INTFLAGS;
+	}
+}
+
+/* Calls the interrupt handler of a flag if it is enabled, and clears the flag when it returns */
+static void interrupt(uint8_t flag, void (*handler)(void))
+{
+	if(avr_sim_interrupts && (avr_sim_adc0.INTCTRL & flag) && handler)
+	{
+		uint8_t before = avr_sim_adc0.INTFLAGS;
+
+		handler();
+		clear_written_flags(before);
+		avr_sim_adc0.INTFLAGS &= ~flag;
+	}
+}
+
+/* Sets WCMP if the value is in the window of WINCM */
+static void window_compare(int32_t value)
+{
+	int32_t low = (avr_sim_adc0.COMMAND & ADC_DIFF_bm) ? (int16_t) avr_sim_adc0.WINLT : avr_sim_adc0.WINLT;
+	int32_t high = (avr_sim_adc0.COMMAND & ADC_DIFF_bm) ? (int16_t) avr_sim_adc0.WINHT : avr_sim_adc0.WINHT;
+	int match;
+
+	switch(avr_sim_adc0.CTRLD & ADC_WINCM_gm)
+	{
+		case ADC_WINCM_BELOW_gc:
+			match = value < low;
+			break;
+		case ADC_WINCM_ABOVE_gc:
+			match = value > high;
+			break;
+		case ADC_WINCM_INSIDE_gc:
+			match = value > low && value < high;
+			break;
+		case ADC_WINCM_OUTSIDE_gc:
+			match = value < low || value > high;
+			break;
+		default:
+			match = 0;
+			break;
+	}
+	if(match)
+	{
+		avr_sim_adc0.INTFLAGS |= ADC_WCMP_bm;
+		interrupt(ADC_WCMP_bm, ADC0_SAMPRDY_vect);
+	}
+}
+
+/* One start or trigger: a single conversion, a Series step or a whole Burst */
+static void convert(void)
+{
+	uint8_t mode = avr_sim_adc0.COMMAND & ADC_MODE_gm;
+	int differential = (avr_sim_adc0.COMMAND & ADC_DIFF_bm) != 0;
+	int accumulating = mode >= ADC_MODE_SERIES_gc;
+	int sampnum = accumulating ? (avr_sim_adc0.CTRLF & ADC_SAMPNUM_gm) : 0;
+	int burst = mode == ADC_MODE_BURST_gc || mode == ADC_MODE_BURST_SCALING_gc;
+	int scaling = mode == ADC_MODE_SERIES_SCALING_gc || mode == ADC_MODE_BURST_SCALING_gc;
+	int leftadj = (avr_sim_adc0.CTRLF & ADC_LEFTADJ_bm) != 0;
+	int32_t sample;
+
+	print_values();
+	avr_sim_adc0.INTFLAGS &= ~(ADC_RESRDY_bm | ADC_SAMPRDY_bm | ADC_WCMP_bm);
+	do
+	{
+		if(!trace_next(&model.trace, &sample))
+		{
+			longjmp(model.end, 1);
+		}
+		sample = clamp_sample(sample, differential);
+		model.samples++;
+		model.sum += sample;
+		model.accumulated++;
+
+		avr_sim_adc0.SAMPLE = sample;
+		avr_sim_adc0.INTFLAGS |= ADC_SAMPRDY_bm;
+		if(accumulating && (avr_sim_adc0.CTRLD & ADC_WINSRC_SAMPLE_gc))
+		{
+			window_compare(sample);
+		}
+		interrupt(ADC_SAMPRDY_bm, ADC0_SAMPRDY_vect);
+	}
+	while(burst && model.accumulated < (1u << sampnum));
+
+	if(model.accumulated < (1u << sampnum))
+	{
+		return;
+	}
+
+	int64_t result = (mode == ADC_MODE_SINGLE_8BIT_gc) ? model.sum >> 4 : adc_result(model.sum, sampnum, scaling, leftadj);
+
+	if(mode == ADC_MODE_SINGLE_12BIT_gc && leftadj)
+	{
+		result *= 1 << (SCALED_BITS - ADC_RESOLUTION);
+	}
+	model.sum = 0;
+	model.accumulated = 0;
+	model.results++;
+	model.result_pending = 1;
+	model.accesses_since_result = 0;
+
+	avr_sim_adc0.RESULT = (uint32_t) result;
+	avr_sim_adc0.INTFLAGS |= ADC_RESRDY_bm;
+	if(!accumulating || !(avr_sim_adc0.CTRLD & ADC_WINSRC_SAMPLE_gc))
+	{
+		window_compare(result);
+	}
+	interrupt(ADC_RESRDY_bm, ADC0_RESRDY_vect);
+}
+
+ADC_t *avr_sim_adc_hook(void)
+{
+	uint8_t start = avr_sim_adc0.COMMAND & ADC_START_gm;
+	int triggered = (start == ADC_START_EVENT_TRIGGER_gc) || (avr_sim_adc0.CTRLF & ADC_FREERUN_bm);
+
+	model.accesses++;
+	/*
+	 * Writing ADC_START_STOP_gc alone, as the examples do to restart an accumulation, clears the
+	 * accumulator. It is seen at the access after the write, also when the write is in a handler.
+	 */
+	if(avr_sim_adc0.COMMAND == ADC_START_STOP_gc)
+	{
+		model.sum = 0;
+		model.accumulated = 0;
+	}
+	if(model.depth > 0 || !(avr_sim_adc0.CTRLA & ADC_ENABLE_bm))
+	{
+		return &avr_sim_adc0;
+	}
+
+	model.depth++;
+	clear_written_flags(model.intflags);
+	if(start == ADC_START_IMMEDIATE_gc)
+	{
+		avr_sim_adc0.COMMAND &= ~ADC_START_gm;
+		convert();
+	}
+	else if(triggered)
+	{
+		/* The access after the one that saw RESRDY reads RESULT */
+		if((avr_sim_adc0.INTFLAGS & ADC_RESRDY_bm) && ++model.accesses_since_result > 2)
+		{
+			avr_sim_adc0.INTFLAGS &= ~ADC_RESRDY_bm;
+		}
+		if(!(avr_sim_adc0.INTFLAGS & ADC_RESRDY_bm))
+		{
+			convert();
+		}
+	}
+	model.intflags = avr_sim_adc0.INTFLAGS;
+	model.depth--;
+	return &avr_sim_adc0;
+}
+
+/* Ends the replay when the example stops accessing the ADC */
+static void stall_check(int signal)
+{
+	static unsigned long last_accesses;
+
+	(void) signal;
+	if(model.accesses == last_accesses)
+	{
+		static const char message[] = "the example does not access ADC0, the replay is stopped\n";
+
+		if(write(STDERR_FILENO, message, sizeof(message) - 1) < 0)
+		{
+			/* Exits anyway */
+		}
+		_exit(1);
+	}
+	last_accesses = model.accesses;
+}
+
+int main(int argc, char *argv[])
+{
+	struct itimerval period = { { STALL_SECONDS, 0 }, { STALL_SECONDS, 0 } };
+	struct timespec start, stop;
+	int opt;
+
+	while((opt = getopt(argc, argv, "bq")) != -1)
+	{
+		switch(opt)
+		{
+		case 'b':
+			model.trace.binary = 1;
+			break;
+		case 'q':
+			model.quiet = 1;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-b] [-q] <trace>\n", argv[0]);
+			return 2;
+		}
+	}
+	if(optind != argc - 1)
+	{
+		fprintf(stderr, "usage: %s [-b] [-q] <trace>\n", argv[0]);
+		return 2;
+	}
+	if(trace_open(&model.trace, argv[optind]) < 0)
+	{
+		return 1;
+	}
+
+	/* The transmitter is always ready, so examples that send their results to the Data Visualizer do not wait */
+	USART0.STATUS = USART_DREIF_bm | USART_TXCIF_bm;
+	signal(SIGALRM, stall_check);
+	setitimer(ITIMER_REAL, &period, NULL);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if(!setjmp(model.end))
+	{
+		firmware_main();
+	}
+	clock_gettime(CLOCK_MONOTONIC, &stop);
+	print_values();
+
+	double seconds = (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) * 1e-9;
+	fprintf(stderr, "%lu samples, %lu results, %lu ADC0 accesses, %.1f Msamples/s\n",
+	        model.samples, model.results, model.accesses, seconds > 0 ? model.samples / seconds * 1e-6 : 0.0);
+
+	trace_close(&model.trace);
+	return 0;
+}
@@ -0,0 +1,238 @@
+/*
+    \file   trace_replay.c
+
+    \brief  Linux host tool that replays sample traces through the ADC accumulation
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+/*
+ * Replays a trace of 12-bit ADC samples through the accumulation and window
+ * comparator of the Series and Burst modes, and prints the RESULT register
+ * values the code examples would read. A CSV file with the results read from
+ * the device, or from an earlier run, may be given as reference, and every
+ * result that differs is reported.
+ *
+ * The trace is memory-mapped and read once from start to end, so traces with
+ * millions of samples are not loaded into memory.
+ *
+ * trace_example.c replays a trace through the main.c of a code example instead.
+ *
+ * Build:   gcc -O2 -Wall -o trace_replay trace_replay.c
+ * Usage:   trace_replay [options] <trace>
+ *
+ * Options:
+ *   -b              Trace is binary, 16-bit little endian samples (default: CSV, first column)
+ *   -n <0-10>       SAMPNUM, 2^n samples are accumulated per result (default: 0)
+ *   -d              Differential mode, the samples are signed
+ *   -s              Scaling mode, the result is the 16-bit scaled mean
+ *   -l              LEFTADJ, results of less than 16 bits are left adjusted to 16 bits
+ *   -w <low>:<high> Count the samples outside the window, as WINCM OUTSIDE with WINSRC SAMPLE
+ *   -r <file>       Reference CSV with one result per line, compared with the replayed results
+ *   -q              Do not print the results
+ */
+
+#include <time.h>
+
+#include "trace.h"
+
+#define MAX_REPORTED        10      /* Differences printed before only counting them */
+
+typedef struct
+{
+	FILE *file;
+	unsigned long line;
+} reference_t;
+
+/* Reads the next reference result, returns 0 at the end of the file */
+static int reference_next(reference_t *reference, int64_t *result)
+{
+	char line[64];
+
+	while(fgets(line, sizeof(line), reference->file))
+	{
+		char *stop;
+		long long value = strtoll(line, &stop, 0);
+
+		reference->line++;
+		if(stop != line)
+		{
+			*result = value;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+	        "usage: %s [-b] [-n sampnum] [-d] [-s] [-l] [-w low:high] [-r reference.csv] [-q] <trace>\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+	trace_t trace = { 0 };
+	reference_t reference = { NULL, 0 };
+	int sampnum = 0, differential = 0, scaling = 0, leftadj = 0, quiet = 0, window = 0;
+	long window_low = 0, window_high = 0;
+	struct timespec start, stop;
+	int opt;
+
+	while((opt = getopt(argc, argv, "bn:dslw:r:q")) != -1)
+	{
+		switch(opt)
+		{
+		case 'b':
+			trace.binary = 1;
+			break;
+		case 'n':
+			sampnum = atoi(optarg);
+			break;
+		case 'd':
+			differential = 1;
+			break;
+		case 's':
+			scaling = 1;
+			break;
+		case 'l':
+			leftadj = 1;
+			break;
+		case 'w':
+			if(sscanf(optarg, "%li:%li", &window_low, &window_high) != 2)
+			{
+				usage(argv[0]);
+				return 2;
+			}
+			window = 1;
+			break;
+		case 'r':
+			reference.file = fopen(optarg, "r");
+			if(!reference.file)
+			{
+				fprintf(stderr, "%s: %s\n", optarg, strerror(errno));
+				return 1;
+			}
+			break;
+		case 'q':
+			quiet = 1;
+			break;
+		default:
+			usage(argv[0]);
+			return 2;
+		}
+	}
+	if(optind != argc - 1 || sampnum < 0 || sampnum > 10)
+	{
+		usage(argv[0]);
+		return 2;
+	}
+	if(trace_open(&trace, argv[optind]) < 0)
+	{
+		return 1;
+	}
+
+	unsigned long samples = 0, results = 0, differences = 0, outside = 0;
+	unsigned long accumulated = 0;
+	int64_t sum = 0;
+	int32_t sample;
+
+	if(!quiet)
+	{
+		printf(window ? "result,outside\n" : "result\n");
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	while(trace_next(&trace, &sample))
+	{
+		sample = clamp_sample(sample, differential);
+		samples++;
+		sum += sample;
+		if(window && (sample < window_low || sample > window_high))
+		{
+			outside++;
+		}
+
+		if(++accumulated < (1ul << sampnum))
+		{
+			continue;
+		}
+
+		int64_t result = adc_result(sum, sampnum, scaling, leftadj);
+		int64_t expected;
+
+		if(!quiet)
+		{
+			if(window)
+			{
+				printf("%lld,%lu\n", (long long)result, outside);
+			}
+			else
+			{
+				printf("%lld\n", (long long)result);
+			}
+		}
+		if(reference.file)
+		{
+			if(!reference_next(&reference, &expected))
+			{
+				fprintf(stderr, "reference ends before result %lu\n", results);
+				differences++;
+				fclose(reference.file);
+				reference.file = NULL;
+			}
+			else if(expected != result && ++differences <= MAX_REPORTED)
+			{
+				fprintf(stderr, "result %lu (reference line %lu): replayed %lld, reference %lld\n",
+				        results, reference.line, (long long)result, (long long)expected);
+			}
+		}
+
+		results++;
+		accumulated = 0;
+		sum = 0;
+		outside = 0;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &stop);
+
+	int64_t extra;
+	if(reference.file && reference_next(&reference, &extra))
+	{
+		fprintf(stderr, "reference has more results than the trace\n");
+		differences++;
+	}
+
+	double seconds = (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) * 1e-9;
+	fprintf(stderr, "%lu samples, %lu results, %lu incomplete samples at the end, %.1f Msamples/s\n",
+	        samples, results, accumulated, seconds > 0 ? samples / seconds * 1e-6 : 0.0);
+	if(reference.file || differences)
+	{
+		fprintf(stderr, "%lu results differ from the reference\n", differences);
+	}
+
+	if(reference.file)
+	{
+		fclose(reference.file);
+	}
+	trace_close(&trace);
+	return differences ? 1 : 0;
+}
@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""
+    \\file   compare_unified.py
+
+    \\brief  Compares the series-unified-accumulation example with the hand-written examples
+
+    For every hand-written Series and Burst example in PAIRS, the unified
+    example is built with the ACQ_ options of the same configuration, and the
+    two are compared on:
+
+    - the size of the code: the .text sections of the compiled main.c, with
+      avr-gcc for the ATtiny1627 when --avr is given, or else with the host
+      compiler and the register model in host-tools/avr-sim
+    - the ADC0 register accesses per sample, counted by trace_example.c in
+      host-tools/trace-replay while both examples run on the same golden trace
+
+    The register accesses do not depend on the compiler, and show whether the
+    two do the same work per sample. The host code size only shows whether the
+    same code is compiled; build with --avr for the size on the device.
+
+    The exit code is 1 if the ADC readings of an example on the trace differ
+    from those of the unified example, or if the unified example is larger.
+    The voltages are not compared, as series-scaling measures VDD/10 with the
+    1.024V reference, which the unified example has no option for.
+
+    Usage:
+        python3 compare_unified.py [--avr] [--cc compiler] [--size size] [--cflags flags]
+"""
+
+import argparse
+import os
+import re
+import shlex
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+TOOLS = os.path.normpath(os.path.join(HERE, '..'))
+EXAMPLES_DIR = os.path.normpath(os.path.join(TOOLS, '..', 'attiny1627-how-to-use-the-12-bit-differential-adc-with-pga'))
+TRACES = os.path.join(TOOLS, 'trace-replay', 'golden')
+
+# Hand-written example, ACQ_ options of the same configuration, trace, right shift of the unified reading to
+# the reading of the hand-written example (the oversampling examples decimate the accumulated result)
+PAIRS = [
+    ('series-oversampling', ['ACQ_MODE=ACQ_SERIES', 'ACQ_SAMPNUM=10'], 'single_ended.csv', 5),
+    ('series-scaling', ['ACQ_MODE=ACQ_SERIES', 'ACQ_SAMPNUM=8', 'ACQ_SCALING=1', 'ACQ_LEFTADJ=1', 'ACQ_PERIOD_MS=10'],
+     'single_ended.csv', 0),
+    ('series-window-comparator', ['ACQ_MODE=ACQ_SERIES', 'ACQ_SAMPNUM=8', 'ACQ_WINDOW=1'], 'window.csv', 0),
+    ('burst-oversampling', ['ACQ_MODE=ACQ_BURST', 'ACQ_SAMPNUM=10', 'ACQ_PERIOD_MS=0'], 'single_ended.csv', 5),
+    ('burst-scaling-diff-pga', ['ACQ_MODE=ACQ_BURST', 'ACQ_SAMPNUM=8', 'ACQ_SCALING=1', 'ACQ_LEFTADJ=1', 'ACQ_DIFF=1',
+                                'ACQ_PERIOD_MS=500'], 'differential.csv', 0),
+    ('burst-window-comparator', ['ACQ_MODE=ACQ_BURST', 'ACQ_SAMPNUM=8', 'ACQ_WINDOW=1', 'ACQ_PERIOD_MS=100'],
+     'window.csv', 0),
+]
+
+
+def text_size(args, build_dir, example, defines):
+    """Size of the .text sections of the compiled main.c"""
+    obj = os.path.join(build_dir, 'main.o')
+    command = [args.cc, '-Os', '-c', '-o', obj, os.path.join(EXAMPLES_DIR, example, 'main.c')]
+    command += ['-D' + d for d in defines] + shlex.split(args.cflags)
+    if args.avr:
+        command += ['-mmcu=attiny1627']
+    else:
+        command += ['-I' + os.path.join(TOOLS, 'avr-sim')]
+    subprocess.run(command, check=True)
+
+    sections = subprocess.run([args.size, '-A', obj], stdout=subprocess.PIPE, universal_newlines=True, check=True).stdout
+    return sum(int(m.group(1)) for m in re.finditer(r'^\.text\S*\s+(\d+)', sections, re.M))
+
+
+def replay(build_dir, example, defines, trace):
+    """ADC0 accesses per sample and the ADC readings of the example on the trace, in the trace replay model"""
+    binary = os.path.join(build_dir, 'trace_example')
+    subprocess.run(['gcc', '-O2', '-I' + os.path.join(TOOLS, 'avr-sim'), '-I' + os.path.join(EXAMPLES_DIR, example)] +
+                   ['-D' + d for d in defines] +
+                   ['-o', binary, os.path.join(TOOLS, 'trace-replay', 'trace_example.c'), '-lm'], check=True)
+    run = subprocess.run([binary, os.path.join(TRACES, trace)], stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                         universal_newlines=True, timeout=60, check=True)
+    m = re.search(r'(\d+) samples, (\d+) results, (\d+) ADC0 accesses', run.stderr)
+    samples, accesses = int(m.group(1)), int(m.group(3))
+    return accesses / samples, [int(line.split(',')[0]) for line in run.stdout.splitlines()]
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compare the unified example with the hand-written examples')
+    parser.add_argument('--avr', action='store_true', help='Build for the ATtiny1627 with avr-gcc')
+    parser.add_argument('--cc', help='Compiler (default: avr-gcc with --avr, else gcc)')
+    parser.add_argument('--size', help='size tool (default: avr-size with --avr, else size)')
+    parser.add_argument('--cflags', default='', help='Extra compiler options, e.g. -B for the device pack')
+    args = parser.parse_args()
+    args.cc = args.cc or ('avr-gcc' if args.avr else 'gcc')
+    args.size = args.size or ('avr-size' if args.avr else 'size')
+
+    print('%-26s %8s %8s %6s %15s %8s %8s %8s' % ('example', 'text', 'unified', 'diff', 'accesses/sample', 'unified',
+                                                 'results', 'unified'))
+    failures = 0
+    with tempfile.TemporaryDirectory() as build_dir:
+        for example, options, trace, shift in PAIRS:
+            size = text_size(args, build_dir, example, [])
+            unified_size = text_size(args, build_dir, 'series-unified-accumulation', options)
+            accesses, results = replay(build_dir, example, [], trace)
+            unified_accesses, unified_results = replay(build_dir, 'series-unified-accumulation', options, trace)
+            print('%-26s %8d %8d %+6d %15.3f %8.3f %8d %8d' % (example, size, unified_size, unified_size - size,
+                                                              accesses, unified_accesses, len(results),
+                                                              len(unified_results)))
+            differs = results != [reading >> shift for reading in unified_results]
+            if differs:
+                print('    the readings differ from the unified example')
+            if unified_size > size:
+                print('    the unified example is larger')
+            failures += differs or unified_size > size
+    print('FAILED' if failures else 'PASSED')
+    return 1 if failures else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
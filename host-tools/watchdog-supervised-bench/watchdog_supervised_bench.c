@@ -0,0 +1,192 @@
+/*
+    \file   watchdog_supervised_bench.c
+
+    \brief  Host benchmark of the bounded wait in the single-watchdog-supervised example
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+/*
+ * Compiles the main.c of the single-watchdog-supervised example with the
+ * register model in host-tools/avr-sim, and compares the conversion throughput
+ * of the bounded wait, adc_wait(), with the plain busy-wait of the other
+ * examples, in the healthy case. adc_convert() is measured too: it also
+ * updates the counters in stats after every conversion.
+ *
+ * The conversions are single-stepped with the x86 trap flag. The trap handler
+ * plays the ADC: a start command is taken after the instruction that writes it,
+ * and the Result Ready flag is set a given number of instructions later. The
+ * instructions from one start to the next are counted, so the throughput does
+ * not depend on the load of the host. Reading the result clears the flag on
+ * the device. The avr-sim registers have no side effects, so the flag is
+ * cleared before each conversion.
+ *
+ * The conversion length is varied by a few instructions, so the flag is set at
+ * every point of the poll loop. The benchmark fails when adc_wait() is more
+ * than MAX_DROP slower than the busy-wait, or when a conversion times out.
+ *
+ * Build:   gcc -O2 -Wall -I../avr-sim -o watchdog_supervised_bench watchdog_supervised_bench.c -lm
+ * Usage:   watchdog_supervised_bench [conversions]
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+
+#if !defined(__x86_64__) || !defined(__linux__)
+#error "The benchmark single-steps with the x86-64 trap flag on Linux"
+#endif
+#include <ucontext.h>
+
+#define main firmware_main
+#include "../../attiny1627-how-to-use-the-12-bit-differential-adc-with-pga/single-watchdog-supervised/main.c"
+#undef main
+
+#define TRAP_FLAG       0x100
+#define PHASES          8       /* Conversion lengths L, L + 1, ... L + PHASES - 1 */
+#define MAX_DROP        0.02    /* Highest accepted throughput loss of adc_wait() */
+
+static const unsigned conversion_lengths[] = { 30, 60, 120, 240 };
+
+typedef enum
+{
+	BUSY_WAIT,
+	BOUNDED_WAIT,   /* adc_wait() */
+	SUPERVISED      /* adc_convert() */
+} variant_t;
+
+static volatile int stepping;
+static unsigned long instructions;
+static unsigned conversion_length;
+static unsigned conversion_left;
+static unsigned conversion_count;
+static int failures;
+
+/* Called after every instruction: the ADC model */
+static void trap_handler(int signal, siginfo_t *info, void *context)
+{
+	ucontext_t *uc = context;
+
+	(void) signal;
+	(void) info;
+	if(!stepping)
+	{
+		uc->uc_mcontext.gregs[REG_EFL] &= ~TRAP_FLAG;
+		return;
+	}
+	instructions++;
+	if((ADC0.COMMAND & ADC_START_gm) == ADC_START_IMMEDIATE_gc)
+	{
+		ADC0.COMMAND &= ~ADC_START_gm;
+		conversion_left = conversion_length + conversion_count++ % PHASES;
+	}
+	else if(conversion_left > 0 && --conversion_left == 0)
+	{
+		ADC0.RESULT = 0x0123;
+		ADC0.INTFLAGS |= ADC_RESRDY_bm;
+	}
+}
+
+/* The conversion of the other examples */
+static uint16_t busy_wait_convert(void)
+{
+	ADC0.COMMAND |= ADC_START_IMMEDIATE_gc;     /* Start ADC conversion */
+	while(!(ADC0.INTFLAGS & ADC_RESRDY_bm));   /* Wait until conversion is done */
+	return ADC0.RESULT;
+}
+
+/* The bounded wait alone, without the fault counters of adc_convert() */
+static uint16_t bounded_wait_convert(void)
+{
+	ADC0.COMMAND |= ADC_START_IMMEDIATE_gc;
+	adc_wait(ADC_RESRDY_bm);
+	return ADC0.RESULT;
+}
+
+static volatile uint16_t sink;
+
+/* Instructions per conversion */
+static double run(unsigned length, unsigned conversions, variant_t variant)
+{
+	uint16_t result;
+
+	conversion_length = length;
+	conversion_count = 0;
+	instructions = 0;
+	stepping = 1;
+	__asm__ volatile("pushf\n\torl %0, (%%rsp)\n\tpopf" : : "i" (TRAP_FLAG) : "memory", "cc");
+	for(unsigned i = 0; i < conversions; i++)
+	{
+		ADC0.INTFLAGS = 0;
+		switch(variant)
+		{
+			case BUSY_WAIT:
+				sink = busy_wait_convert();
+				break;
+			case BOUNDED_WAIT:
+				sink = bounded_wait_convert();
+				break;
+			case SUPERVISED:
+				if(adc_convert(&result) == ADC_OK)
+				{
+					sink = result;
+				}
+				break;
+		}
+	}
+	stepping = 0;
+	return (double) instructions / conversions;
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned conversions = (argc > 1) ? atoi(argv[1]) : 1000;
+	struct sigaction action;
+
+	memset(&action, 0, sizeof(action));
+	action.sa_sigaction = trap_handler;
+	action.sa_flags = SA_SIGINFO;
+	sigaction(SIGTRAP, &action, NULL);
+
+	adc_init();
+
+	printf("Instructions per conversion, %u conversions\n", conversions);
+	printf("%-12s %10s %12s %6s %14s %6s\n", "conversion", "busy-wait", "adc_wait()", "drop", "adc_convert()", "drop");
+	for(size_t i = 0; i < sizeof(conversion_lengths) / sizeof(conversion_lengths[0]); i++)
+	{
+		double plain = run(conversion_lengths[i], conversions, BUSY_WAIT);
+		double bounded = run(conversion_lengths[i], conversions, BOUNDED_WAIT);
+		double supervised = run(conversion_lengths[i], conversions, SUPERVISED);
+
+		printf("%-12u %10.1f %12.1f %5.1f%% %14.1f %5.1f%%\n", conversion_lengths[i], plain,
+		       bounded, (1 - plain / bounded) * 100, supervised, (1 - plain / supervised) * 100);
+		failures += (1 - plain / bounded > MAX_DROP);
+	}
+	printf("timeouts: %u\n", stats.timeouts);
+	failures += (stats.timeouts != 0);
+
+	printf("%s\n", failures ? "FAILED" : "PASSED");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,90 @@
+/*
+    \file   fast_path_firmware.h
+
+    \brief  Includes the single-window-fast-path example once per FAST_PATH setting
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+/*
+ * Included by window_fast_path_test.c once for each FAST_PATH setting, with
+ * FIRMWARE defined to a prefix, e.g.
+ *
+ *     #define FAST_PATH   0
+ *     #define FIRMWARE    handler_path
+ *     #include "fast_path_firmware.h"
+ *
+ * Every name the example defines gets the prefix, so both builds of main.c are
+ * in one program. The registers of avr-sim are shared. The functions and
+ * variables the test uses are collected in FIRMWARE_variant.
+ */
+
+#define FIRMWARE_NAME(name)             FIRMWARE_PASTE(FIRMWARE, name)
+#define FIRMWARE_PASTE(prefix, name)    FIRMWARE_PASTE_(prefix, name)
+#define FIRMWARE_PASTE_(prefix, name)   prefix##_##name
+
+#define main                FIRMWARE_NAME(main)
+#define trip_count          FIRMWARE_NAME(trip_count)
+#define trip_sample         FIRMWARE_NAME(trip_sample)
+#define trip_latency        FIRMWARE_NAME(trip_latency)
+#define trip_latency_max    FIRMWARE_NAME(trip_latency_max)
+#define tripped             FIRMWARE_NAME(tripped)
+#define voltage             FIRMWARE_NAME(voltage)
+#define evsys_init          FIRMWARE_NAME(evsys_init)
+#define ccl_init            FIRMWARE_NAME(ccl_init)
+#define tcb_init            FIRMWARE_NAME(tcb_init)
+#define adc_init            FIRMWARE_NAME(adc_init)
+#define trip_rearm          FIRMWARE_NAME(trip_rearm)
+#define ADC0_SAMPRDY_vect   FIRMWARE_NAME(ADC0_SAMPRDY_vect)
+
+#include "../../attiny1627-how-to-use-the-12-bit-differential-adc-with-pga/single-window-fast-path/main.c"
+
+static const firmware_t FIRMWARE_NAME(variant) =
+{
+	FAST_PATH,
+	evsys_init,
+	ccl_init,
+	tcb_init,
+	adc_init,
+	trip_rearm,
+	ADC0_SAMPRDY_vect,
+	&trip_count,
+	&trip_latency,
+	&trip_latency_max,
+	&tripped
+};
+
+#undef main
+#undef trip_count
+#undef trip_sample
+#undef trip_latency
+#undef trip_latency_max
+#undef tripped
+#undef voltage
+#undef evsys_init
+#undef ccl_init
+#undef tcb_init
+#undef adc_init
+#undef trip_rearm
+#undef ADC0_SAMPRDY_vect
+#undef FAST_PATH
+#undef FIRMWARE
@@ -0,0 +1,342 @@
+/*
+    \file   window_fast_path_test.c
+
+    \brief  Host test of the CCL latch, the TCB0 capture and the PA4 latency in the single-window-fast-path example
+
+    (c) 2020 Microchip Technology Inc. and its subsidiaries.
+
+    Subject to your compliance with these terms, you may use Microchip software and any
+    derivatives exclusively with Microchip products. It is your responsibility to comply with third party
+    license terms applicable to your use of third party software (including open source software) that
+    may accompany Microchip software.
+
+    THIS SOFTWARE IS SUPPLIED BY MICROCHIP "AS IS". NO WARRANTIES, WHETHER
+    EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS SOFTWARE, INCLUDING ANY
+    IMPLIED WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY, AND FITNESS
+    FOR A PARTICULAR PURPOSE.
+
+    IN NO EVENT WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE,
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY KIND
+    WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF MICROCHIP
+    HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE FORESEEABLE. TO
+    THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP'S TOTAL LIABILITY ON ALL
+    CLAIMS IN ANY WAY RELATED TO THIS SOFTWARE WILL NOT EXCEED THE AMOUNT
+    OF FEES, IF ANY, THAT YOU HAVE PAID DIRECTLY TO MICROCHIP FOR THIS
+    SOFTWARE.
+*/
+
+/*
+ * Compiles the main.c of the single-window-fast-path example with the register
+ * model in host-tools/avr-sim, with FAST_PATH set to 0 and to 1 (see
+ * fast_path_firmware.h), and runs the Free-Run conversions, the window compare
+ * event, the CCL latch, the TCB0 capture and the interrupt handler on a signal
+ * that crosses the trip threshold several times.
+ *
+ * The events travel as the EVSYS registers written by the example route them:
+ * the latch is set by the event on the LUT0 input and reset by the software
+ * event of trip_rearm(), and TCB0 captures on the rising edge of the event
+ * its capture input listens to. The handler runs a given number of CLK_PER
+ * cycles after the first compare event of a trip, e.g. because interrupts
+ * were disabled, while the conversions above the threshold keep giving
+ * compare events. The trip_latency measured by the example must equal that
+ * delay, every trip must be counted once, and the latch must be set from the
+ * first compare event of a trip until the re-arm.
+ *
+ * The latency from the compare event to PA4 going high is measured for both
+ * settings. With FAST_PATH, PA4 is the output of the latch, which the CCL
+ * drives without a clock, so PA4 rises in the CLK_PER cycle of the event.
+ * Without it, the handler sets PA4. The handler is single-stepped with the x86
+ * trap flag, as in watchdog-supervised-bench, up to the instruction that
+ * writes PORTA.OUTSET. Each of those instructions takes at least one AVR
+ * cycle, and the interrupt response takes INTERRUPT_RESPONSE cycles, so the
+ * latency of the handler path is at least their sum. The float conversion
+ * before the write takes many more cycles on the AVR than on the host.
+ *
+ * To show that the model detects it, the test is also run with TCB0
+ * capturing every compare event directly, which must measure the delays
+ * longer than one conversion wrongly.
+ *
+ * Build:   gcc -O2 -Wall -I../avr-sim -o window_fast_path_test window_fast_path_test.c -lm
+ * Usage:   window_fast_path_test
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+
+#if !defined(__x86_64__) || !defined(__linux__)
+#error "The test single-steps with the x86-64 trap flag on Linux"
+#endif
+#include <ucontext.h>
+
+typedef struct
+{
+	int fast_path;
+	void (*evsys_init)(void);
+	void (*ccl_init)(void);
+	void (*tcb_init)(void);
+	void (*adc_init)(void);
+	void (*trip_rearm)(void);
+	void (*handler)(void);
+	volatile uint16_t *trip_count;
+	volatile uint16_t *trip_latency;
+	volatile uint16_t *trip_latency_max;
+	volatile uint8_t *tripped;
+} firmware_t;
+
+#define FAST_PATH   0
+#define FIRMWARE    handler_path
+#include "fast_path_firmware.h"
+
+#define FAST_PATH   1
+#define FIRMWARE    fast_path
+#include "fast_path_firmware.h"
+
+#define TRAP_FLAG           0x100
+#define ADC_CONVERSION_CLKS 13      /* CLK_ADC cycles of a 12-bit conversion after sampling */
+#define INTERRUPT_RESPONSE  5       /* CLK_PER cycles to push the PC and jump from the vector to the handler */
+#define TRIPS               5       /* Times the signal goes above the threshold */
+#define ABOVE_CONVERSIONS   40      /* Conversions the signal stays above the threshold */
+#define BELOW_CONVERSIONS   40      /* Conversions the signal stays below the release level */
+
+static volatile int stepping;
+static unsigned long instructions;
+static unsigned long pin_instructions;
+static int failures;
+
+static void check(int condition, const char *name)
+{
+	printf("%-60s %s\n", name, condition ? "ok" : "FAILED");
+	if(!condition)
+	{
+		failures++;
+	}
+}
+
+/* Called after every instruction, notes the instruction that sets PA4 */
+static void trap_handler(int signal, siginfo_t *info, void *context)
+{
+	ucontext_t *uc = context;
+
+	(void) signal;
+	(void) info;
+	if(!stepping)
+	{
+		uc->uc_mcontext.gregs[REG_EFL] &= ~TRAP_FLAG;
+		return;
+	}
+	instructions++;
+	if(!pin_instructions && (PORTA.OUTSET & PIN4_bm))
+	{
+		pin_instructions = instructions;
+	}
+}
+
+/* Generator of the channel an event user listens to, 0 if none */
+static uint8_t user_generator(uint8_t user)
+{
+	switch(user)
+	{
+	case EVSYS_USER_CHANNEL0_gc: return EVSYS.CHANNEL0;
+	case EVSYS_USER_CHANNEL1_gc: return EVSYS.CHANNEL1;
+	case EVSYS_USER_CHANNEL2_gc: return EVSYS.CHANNEL2;
+	default: return 0;
+	}
+}
+
+static void reset(const firmware_t *firmware)
+{
+	memset((void *)&EVSYS, 0, sizeof(EVSYS));
+	memset((void *)&CCL, 0, sizeof(CCL));
+	memset((void *)&TCB0, 0, sizeof(TCB0));
+	memset((void *)&ADC0, 0, sizeof(ADC0));
+	memset((void *)&PORTA, 0, sizeof(PORTA));
+	*firmware->trip_count = 0;
+	*firmware->tripped = 0;
+	*firmware->trip_latency_max = 0;
+	firmware->evsys_init();
+	firmware->ccl_init();
+	firmware->tcb_init();
+	firmware->adc_init();
+}
+
+/* CLK_PER cycles from the handler being pended to its write of PA4, 0 if it does not write PA4 */
+static unsigned long handler_pin_cycles(const firmware_t *firmware)
+{
+	reset(firmware);
+	ADC0.SAMPLE = TRIP_THRESHOLD + 100;
+	ADC0.INTFLAGS = ADC_WCMP_bm;
+
+	instructions = 0;
+	pin_instructions = 0;
+	stepping = 1;
+	__asm__ volatile("pushf\n\torl %0, (%%rsp)\n\tpopf" : : "i" (TRAP_FLAG) : "memory", "cc");
+	firmware->handler();
+	stepping = 0;
+
+	return pin_instructions ? INTERRUPT_RESPONSE + pin_instructions : 0;
+}
+
+typedef struct
+{
+	unsigned long trips;
+	unsigned long captures;
+	unsigned long wrong_latencies;
+	unsigned long latch_errors;
+	unsigned long pin_rises;
+	uint32_t pin_latency_max;   /* CLK_PER cycles from the first compare event to PA4 going high */
+} result_t;
+
+/* Runs TRIPS trips with the handler delayed by delay CLK_PER cycles after the compare event */
+static result_t run(const firmware_t *firmware, uint32_t delay, int capture_every_event)
+{
+	result_t result = { 0, 0, 0, 0, 0, 0 };
+	uint32_t conversion;
+	uint32_t now = 0;
+	uint32_t first_event = 0;
+	uint32_t handler_time = 0;
+	unsigned long pin_cycles = handler_pin_cycles(firmware);
+	int handler_pending = 0;
+	int latch = 0;
+
+	reset(firmware);
+	conversion = (uint32_t)(ADC0.CTRLE + 0.5 + ADC_CONVERSION_CLKS) * 2; /* ADC_PRESC_DIV2 */
+	if(capture_every_event)
+	{
+		EVSYS.USERTCB0CAPT = EVSYS_USER_CHANNEL0_gc;
+	}
+
+	for(int trip = 0; trip < TRIPS; trip++)
+	{
+		for(int n = 0; n < ABOVE_CONVERSIONS + BELOW_CONVERSIONS; n++)
+		{
+			uint16_t sample = (n < ABOVE_CONVERSIONS) ? TRIP_THRESHOLD + 100 : TRIP_RELEASE - 100;
+			uint32_t end = now + conversion;
+
+			/* The handler runs before the conversion that ends after it */
+			if(handler_pending && handler_time <= end)
+			{
+				TCB0.CNT = (uint16_t)handler_time;
+				PORTA.OUTSET = 0;
+				firmware->handler();
+				handler_pending = 0;
+				if(*firmware->trip_latency != delay)
+				{
+					result.wrong_latencies++;
+				}
+				if(PORTA.OUTSET & PIN4_bm)
+				{
+					uint32_t pin_latency = handler_time + pin_cycles - first_event;
+
+					result.pin_rises++;
+					result.pin_latency_max = (pin_latency > result.pin_latency_max) ? pin_latency : result.pin_latency_max;
+				}
+			}
+			now = end;
+			ADC0.SAMPLE = sample;
+
+			if(sample > ADC0.WINHT)
+			{
+				/* Window compare event on channel 0, to the latch and maybe to TCB0 */
+				int latch_rises = !latch && user_generator(EVSYS.USERCCLLUT0A) == EVSYS_CHANNEL0_ADC0_WCMP_gc &&
+				                  (CCL.CTRLA & CCL_ENABLE_bm);
+				uint8_t capture_source = user_generator(EVSYS.USERTCB0CAPT);
+
+				if(latch_rises)
+				{
+					latch = 1;
+					first_event = now;
+					/* LUT0 OUT drives PA4 in the same cycle */
+					if((CCL.LUT0CTRLA & CCL_OUTEN_bm) && ((PORTA.DIR | PORTA.DIRSET) & PIN4_bm))
+					{
+						result.pin_rises++;
+					}
+				}
+				if((TCB0.EVCTRL & TCB_CAPTEI_bm) && (capture_source == EVSYS_CHANNEL0_ADC0_WCMP_gc ||
+				   (capture_source == EVSYS_CHANNEL2_CCL_LUT0_gc && latch_rises)))
+				{
+					TCB0.CCMP = (uint16_t)now;
+					result.captures++;
+				}
+				if(ADC0.INTCTRL & ADC_WCMP_bm && !handler_pending && !*firmware->tripped)
+				{
+					handler_pending = 1;
+					handler_time = first_event + delay;
+				}
+			}
+
+			/* Main loop, and the software event that resets the latch */
+			if(*firmware->tripped && ADC0.SAMPLE < TRIP_RELEASE)
+			{
+				firmware->trip_rearm();
+			}
+			if(EVSYS.SWEVENTA & EVSYS_SWEVENTA_CH1_gc)
+			{
+				EVSYS.SWEVENTA = 0;
+				latch = 0;
+			}
+			if(latch != (n < ABOVE_CONVERSIONS))
+			{
+				result.latch_errors++;
+			}
+		}
+	}
+	result.trips = *firmware->trip_count;
+	return result;
+}
+
+/* Checks the trips at every delay, returns the PA4 latency with the handler entered right away */
+static unsigned long test(const firmware_t *firmware)
+{
+	static const uint32_t delays[] = { 20, 33, 100, 500, 1000 };
+	unsigned long pin_cycles = handler_pin_cycles(firmware);
+	char name[80];
+
+	printf("FAST_PATH %d\n", firmware->fast_path);
+	printf("%-12s %8s %10s %10s %12s\n", "delay", "trips", "captures", "latency", "PA4 latency");
+	for(size_t i = 0; i < sizeof(delays) / sizeof(delays[0]); i++)
+	{
+		result_t result = run(firmware, delays[i], 0);
+		/* The handler path sets PA4 after the delay, the CCL right at the event */
+		uint32_t pin_latency = firmware->fast_path ? 0 : delays[i] + pin_cycles;
+
+		printf("%6lu CLK   %8lu %10lu %10u %8lu CLK\n", (unsigned long)delays[i], result.trips, result.captures,
+		       *firmware->trip_latency_max, (unsigned long)result.pin_latency_max);
+		snprintf(name, sizeof(name), "handler %lu CLK_PER after the event", (unsigned long)delays[i]);
+		check(result.trips == TRIPS && result.captures == TRIPS && result.wrong_latencies == 0 &&
+		      result.latch_errors == 0, name);
+		snprintf(name, sizeof(name), "PA4 rises once per trip, %lu CLK_PER after the event", (unsigned long)pin_latency);
+		check(result.pin_rises == TRIPS && result.pin_latency_max == pin_latency, name);
+	}
+	check(firmware->fast_path ? pin_cycles == 0 : pin_cycles > INTERRUPT_RESPONSE,
+	      firmware->fast_path ? "handler does not write PA4" : "handler writes PA4");
+	return pin_cycles;
+}
+
+int main(void)
+{
+	struct sigaction action;
+
+	memset(&action, 0, sizeof(action));
+	action.sa_sigaction = trap_handler;
+	action.sa_flags = SA_SIGINFO;
+	sigaction(SIGTRAP, &action, NULL);
+
+	unsigned long handler_cycles = test(&handler_path_variant);
+	unsigned long fast_cycles = test(&fast_path_variant);
+
+	printf("PA4 latency with the handler entered right away: FAST_PATH 1 %lu CLK_PER, FAST_PATH 0 at least %lu CLK_PER "
+	       "(%d interrupt response + %lu handler instructions)\n",
+	       fast_cycles, handler_cycles, INTERRUPT_RESPONSE, handler_cycles - INTERRUPT_RESPONSE);
+
+	/* The latency must be wrong when TCB0 captures every compare event, once the handler is later than one conversion */
+	result_t every_event = run(&fast_path_variant, 500, 1);
+	check(every_event.wrong_latencies == TRIPS, "capture on every compare event is detected");
+
+	printf("%s\n", failures ? "FAILED" : "PASSED");
+	return failures ? 1 : 0;
+}